@@ -0,0 +1,140 @@
+#include "BenchScenes.hpp"
+#include "core/Engine.hpp"
+#include "util/Json.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#ifdef __linux__
+#include <fontconfig/fontconfig.h>
+#endif
+
+namespace {
+
+struct BenchOptions {
+    bool headless = true;
+    // 300, or the whole log when replaying.
+    std::optional<uint32_t> frames;
+    std::string scene; // Runs every scene when empty.
+    std::string replay; // A session log captured over `scene`, replayed instead of the scene's own update.
+    std::string out;   // Also appends the results here, without the engine's own console output.
+};
+
+// Usage: IroBench [--windowed] [--frames N] [--scene NAME [--replay LOG]] [--out PATH]
+BenchOptions parseOptions(int argc, char **argv) {
+    BenchOptions options {};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--windowed") {
+            options.headless = false;
+        } else if (arg == "--frames" && hasValue) {
+            options.frames = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--scene" && hasValue) {
+            options.scene = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            options.replay = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            options.out = argv[++i];
+        } else {
+            throw std::runtime_error("Unknown or incomplete argument \"" + arg + "\".");
+        }
+    }
+    if (!options.replay.empty() && options.scene.empty()) {
+        throw std::runtime_error("--replay needs the --scene the log was captured over.");
+    }
+    return options;
+}
+
+// One line of JSON per scene, so results from different builds can be compared line by line.
+std::string runScene(const BenchScene &benchScene, const BenchOptions &options) {
+    EngineOptions engineOptions {};
+    engineOptions.headless = options.headless;
+    engineOptions.frameLimit = options.frames.value_or(options.replay.empty() ? 300 : 0);
+    engineOptions.replayPath = options.replay;
+    engineOptions.scene = benchScene.create();
+
+    Engine engine {std::move(engineOptions)};
+    engine.run();
+
+    const FrameStats &stats = engine.getFrameStats();
+    std::ostringstream line;
+    line << "{\"scene\":\"" << benchScene.name << "\",\"headless\":" << (options.headless || !options.replay.empty() ? "true" : "false");
+    if (!options.replay.empty()) {
+        line << ",\"replay\":\"";
+        Json::writeEscaped(line, options.replay);
+        line << "\"";
+    }
+    line << ",\"cpu\":";
+    FrameStats::writeJson(line, stats.total(FrameStats::Channel::Cpu));
+    line << ",\"gpu\":";
+    FrameStats::writeJson(line, stats.total(FrameStats::Channel::Gpu));
+    line << ",\"vulkan\":";
+    VResourceTracker::writeJson(line, engine.getResourceStats());
+#ifdef IRO_TRACK_ALLOCS
+    line << ",\"allocs\":";
+    engine.getFrameAllocations().writeJson(line);
+#endif
+    line << "}";
+    return line.str();
+}
+
+}
+
+int main(int argc, char **argv) {
+    #ifdef __linux__
+    FcInit();
+    #endif
+
+    BenchOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream out;
+    if (!options.out.empty()) {
+        out.open(options.out, std::ios::app);
+        if (!out) {
+            std::cerr << "Error: Could not open " << options.out << ".\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // A failing scene is reported and the suite moves on to the next one.
+    int status = EXIT_SUCCESS;
+    bool matched = false;
+    for (const BenchScene &scene : benchScenes()) {
+        if (!options.scene.empty() && scene.name != options.scene) {
+            continue;
+        }
+        matched = true;
+
+        std::string line;
+        try {
+            line = runScene(scene, options);
+        } catch (const std::exception &e) {
+            std::cerr << "Error: Scene " << scene.name << " failed: " << e.what() << '\n';
+            status = EXIT_FAILURE;
+            continue;
+        }
+
+        std::cout << line << '\n';
+        if (out.is_open()) {
+            out << line << '\n';
+        }
+    }
+
+    if (!matched) {
+        std::cerr << "Error: No scene named \"" << options.scene << "\".\n";
+        return EXIT_FAILURE;
+    }
+    return status;
+}
@@ -0,0 +1,185 @@
+#include "BenchScenes.hpp"
+#include "util/Color.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <string>
+
+namespace {
+
+// Fills the viewport with a grid of `count` quads in varying colors.
+std::vector<Primitives::Primitive *> addQuadGrid(SceneContext &context, uint32_t count) {
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+    const float cell = 2.0f / static_cast<float>(columns);
+
+    std::vector<Primitives::Primitive *> quads;
+    quads.reserve(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t column = i % columns;
+        const uint32_t row = i / columns;
+
+        auto vertices = Primitives::Vertex::create_default_quad();
+        const float hue = static_cast<float>(i % 64) / 64.0f;
+        for (auto &vertex : vertices) {
+            vertex.color = ColorUtil::rgba_to_uint32_aabbggrr({hue, 1.0f - hue, 0.5f, 1.0f});
+        }
+
+        auto quad = std::make_unique<Primitives::Quad>(context.geometry, vertices);
+        quad->setPosition({-1.0f + (static_cast<float>(column) + 0.5f) * cell, -1.0f + (static_cast<float>(row) + 0.5f) * cell});
+        quad->setScale({cell * 0.8f, cell * 0.8f});
+        quads.push_back(quad.get());
+        context.ui.add("quad" + std::to_string(i), std::move(quad));
+    }
+    return quads;
+}
+
+// Quads that never change after the first frame: measures the cost of an idle, fully cached frame.
+class StaticQuads : public Scene {
+
+private:
+    uint32_t count;
+
+
+public:
+    explicit StaticQuads(uint32_t count) : count(count) {}
+
+    void load(SceneContext &context) override { addQuadGrid(context, count); }
+
+};
+
+// Every quad gets new vertex colors every frame, so every batch is recorded again.
+class ChurnQuads : public Scene {
+
+private:
+    uint32_t count;
+    std::vector<Primitives::Primitive *> quads;
+
+
+public:
+    explicit ChurnQuads(uint32_t count) : count(count) {}
+
+    void load(SceneContext &context) override { quads = addQuadGrid(context, count); }
+
+    void update(SceneContext &context, uint64_t frame, float seconds) override {
+        auto vertices = Primitives::Vertex::create_default_quad();
+        for (std::size_t i = 0; i < quads.size(); ++i) {
+            const float hue = static_cast<float>((frame + i) % 64) / 64.0f;
+            for (auto &vertex : vertices) {
+                vertex.color = ColorUtil::rgba_to_uint32_aabbggrr({hue, 0.5f, 1.0f - hue, 1.0f});
+            }
+            quads[i]->setVertices(vertices);
+        }
+    }
+
+};
+
+// A mostly static UI where 1% of the quads move each frame, cycling through all of them: the damage-rect
+// path, where only the moved quads' regions are cleared, recorded and drawn again.
+class SparseMoves : public Scene {
+
+private:
+    static constexpr uint32_t MOVED_PERCENT = 1;
+
+    uint32_t count;
+    std::vector<Primitives::Primitive *> quads;
+    std::vector<glm::vec2> home;
+
+
+public:
+    explicit SparseMoves(uint32_t count) : count(count) {}
+
+    void load(SceneContext &context) override {
+        quads = addQuadGrid(context, count);
+        home.reserve(quads.size());
+        for (const auto *quad : quads) {
+            home.push_back(quad->getTransform().position);
+        }
+    }
+
+    void update(SceneContext &context, uint64_t frame, float seconds) override {
+        const std::size_t moved = std::max<std::size_t>(1, quads.size() * MOVED_PERCENT / 100);
+        const std::size_t first = (frame * moved) % quads.size();
+        // A small nudge, away on one pass through the quads and back on the next.
+        const float offset = (frame * moved / quads.size()) % 2 == 0 ? 0.002f : 0.0f;
+        for (std::size_t i = 0; i < moved; ++i) {
+            const std::size_t index = (first + i) % quads.size();
+            quads[index]->setPosition(home[index] + glm::vec2(offset, 0.0f));
+        }
+    }
+
+};
+
+// A dashboard of small labels where 1% of them show a new value each frame, cycling through all of them:
+// text layout and glyph instancing with mostly clean labels.
+class LabelDashboard : public Scene {
+
+private:
+    static constexpr uint32_t UPDATED_PERCENT = 1;
+    static constexpr float TEXT_SIZE = 10.0f;
+
+    uint32_t count;
+    std::vector<Label *> labels;
+
+
+public:
+    explicit LabelDashboard(uint32_t count) : count(count) {}
+
+    void load(SceneContext &context) override {
+        const FontId font = context.renderer.getTextRenderer().getFonts().load("sans-serif");
+        const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(count))));
+        // Laid out for the default 800x600 target; the cells overlap, which costs nothing extra to draw.
+        const glm::vec2 cell {800.0f / static_cast<float>(columns), 600.0f / static_cast<float>(columns)};
+
+        labels.reserve(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            auto label = std::make_unique<Label>(font, TEXT_SIZE, std::to_string(i));
+            label->setPosition({static_cast<float>(i % columns) * cell.x, static_cast<float>(i / columns) * cell.y});
+            labels.push_back(label.get());
+            context.ui.addLabel("label" + std::to_string(i), std::move(label));
+        }
+    }
+
+    void update(SceneContext &context, uint64_t frame, float seconds) override {
+        const std::size_t updated = std::max<std::size_t>(1, labels.size() * UPDATED_PERCENT / 100);
+        const std::size_t first = (frame * updated) % labels.size();
+        for (std::size_t i = 0; i < updated; ++i) {
+            labels[(first + i) % labels.size()]->setText(std::to_string(frame));
+        }
+    }
+
+};
+
+// Changes the render size every few frames: swap chain recreation, pipeline reuse and full redraws.
+class ResizeStorm : public Scene {
+
+private:
+    static constexpr uint64_t FRAMES_PER_SIZE = 5;
+    static constexpr std::array<VkExtent2D, 4> SIZES {{{800, 600}, {1280, 720}, {640, 480}, {1920, 1080}}};
+
+
+public:
+    void load(SceneContext &context) override { addQuadGrid(context, 1000); }
+
+    void update(SceneContext &context, uint64_t frame, float seconds) override {
+        if (frame > 0 && frame % FRAMES_PER_SIZE == 0) {
+            context.resize(SIZES[(frame / FRAMES_PER_SIZE) % SIZES.size()]);
+        }
+    }
+
+};
+
+}
+
+std::vector<BenchScene> benchScenes() {
+    return {
+        {"quads-1k", [] { return std::make_unique<StaticQuads>(1000); }},
+        {"quads-10k", [] { return std::make_unique<StaticQuads>(10000); }},
+        {"quads-100k", [] { return std::make_unique<StaticQuads>(100000); }},
+        {"churn-1k", [] { return std::make_unique<ChurnQuads>(1000); }},
+        {"churn-10k", [] { return std::make_unique<ChurnQuads>(10000); }},
+        {"moves-1pct-10k", [] { return std::make_unique<SparseMoves>(10000); }},
+        {"labels-10k", [] { return std::make_unique<LabelDashboard>(10000); }},
+        {"resize-storm", [] { return std::make_unique<ResizeStorm>(); }},
+    };
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "core/scene/Scene.hpp"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A named scene for the benchmark suite. Each run gets a fresh engine and a fresh scene.
+struct BenchScene {
+    std::string name;
+    std::function<std::unique_ptr<Scene>()> create;
+};
+
+// Every canned scene, in the order the suite runs them.
+std::vector<BenchScene> benchScenes();
@@ -0,0 +1,442 @@
+#include "MicroHarness.hpp"
+#include "core/ui/UIManager.hpp"
+#include "core/vulkan/VBuffer.hpp"
+#include "core/vulkan/VGeometryRegistry.hpp"
+#include "util/Color.hpp"
+#include "util/JobSystem.hpp"
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Elements in the populated UI that the lookup and iteration cases run against.
+constexpr uint32_t UI_ELEMENTS = 1000;
+constexpr VkDeviceSize BUFFER_BYTES = 64 * 1024;
+constexpr VkDeviceSize WRITE_BYTES = 4 * 1024;
+
+constexpr uint32_t LAYOUT_SECTIONS = 50;
+constexpr uint32_t LAYOUT_ROWS_PER_SECTION = 20;
+constexpr uint32_t LAYOUT_LEAVES_PER_ROW = 50;
+constexpr float LAYOUT_LEAF_SIZE = 10.0f;
+constexpr glm::vec2 LAYOUT_VIEWPORT {1920.0f, 1080.0f};
+
+constexpr uint32_t SPATIAL_PROXIES = 100000;
+constexpr float SPATIAL_EXTENT = 4.0f; // The grid spans [-4, 4] in NDC; the viewport is [-1, 1].
+
+struct MicroBenchOptions {
+    MicroOptions harness;
+    std::string out; // Also appends the results here, without the engine's own console output.
+};
+
+// Usage: IroMicroBench [--warmup N] [--repetitions N] [--time MS] [--cpu N] [--filter TEXT] [--out PATH]
+MicroBenchOptions parseOptions(int argc, char **argv) {
+    MicroBenchOptions options {};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--warmup" && hasValue) {
+            options.harness.warmup = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--repetitions" && hasValue) {
+            options.harness.repetitions = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--time" && hasValue) {
+            options.harness.repetitionMilliseconds = std::stod(argv[++i]);
+        } else if (arg == "--cpu" && hasValue) {
+            options.harness.cpu = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--filter" && hasValue) {
+            options.harness.filter = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            options.out = argv[++i];
+        } else {
+            throw std::runtime_error("Unknown or incomplete argument \"" + arg + "\".");
+        }
+    }
+    return options;
+}
+
+// A Vulkan instance and headless device with nothing else around them, for the cases that need real buffers.
+class HeadlessContext {
+
+private:
+    VkInstance instance = VK_NULL_HANDLE;
+
+
+public:
+    std::unique_ptr<VDevice> device;
+    std::unique_ptr<VGeometryRegistry> geometry;
+
+    HeadlessContext() {
+        uint32_t loaderVersion = VK_API_VERSION_1_0;
+        vkEnumerateInstanceVersion(&loaderVersion);
+        const uint32_t apiVersion = loaderVersion >= VK_API_VERSION_1_3 ? VK_API_VERSION_1_3 : VK_API_VERSION_1_2;
+
+        VkApplicationInfo appInfo {
+            .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+            .pApplicationName = "Iro MicroBench",
+            .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
+            .pEngineName = "Iro Engine",
+            .engineVersion = VK_MAKE_VERSION(1, 0, 0),
+            .apiVersion = apiVersion,
+        };
+
+        VkInstanceCreateInfo createInfo {
+            .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+            .pApplicationInfo = &appInfo,
+        };
+
+        if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create Vulkan instance.");
+        }
+
+        try {
+            device = std::make_unique<VDevice>(instance, VK_NULL_HANDLE, nullptr, apiVersion);
+            geometry = std::make_unique<VGeometryRegistry>(*device);
+        } catch (...) {
+            geometry.reset();
+            device.reset();
+            vkDestroyInstance(instance, nullptr);
+            throw;
+        }
+    }
+
+    ~HeadlessContext() {
+        geometry.reset();
+        device.reset();
+        vkDestroyInstance(instance, nullptr);
+    }
+
+    HeadlessContext(const HeadlessContext &) = delete;
+    HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+};
+
+void addColorCases(std::vector<MicroCase> &cases) {
+    auto colors = std::make_shared<std::vector<glm::vec4>>();
+    for (uint32_t i = 0; i < 1024; ++i) {
+        const float t = static_cast<float>(i) / 1024.0f;
+        colors->push_back({t, 1.0f - t, t * 0.5f, 1.0f});
+    }
+
+    cases.push_back({
+        .name = "color.rgba_to_uint32",
+        .run = [colors](uint64_t iterations) {
+            uint32_t packed = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                packed ^= ColorUtil::rgba_to_uint32_aabbggrr((*colors)[i & 1023]);
+            }
+            keepAlive(packed);
+        },
+    });
+}
+
+void addJobCases(std::vector<MicroCase> &cases, JobSystem &jobs) {
+    // Round trip of a single job: the wake-up latency of an idle worker plus the wait.
+    cases.push_back({
+        .name = "jobs.push_wait",
+        .run = [&jobs](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                JobCounter counter;
+                jobs.push([] {}, &counter);
+                jobs.wait(counter);
+            }
+        },
+    });
+
+    // Empty jobs pushed as fast as possible and waited on once: the per-job cost of the queue under contention.
+    cases.push_back({
+        .name = "jobs.throughput",
+        .run = [&jobs](uint64_t iterations) {
+            JobCounter counter;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                jobs.push([] {}, &counter);
+            }
+            jobs.wait(counter);
+        },
+    });
+}
+
+// Relayout of a 50k-node tree after one leaf changed width, which shifts the rest of its row. The target
+// is well under a millisecond per operation: only the path to the leaf and its row are measured again.
+void addLayoutCases(std::vector<MicroCase> &cases) {
+    struct LayoutState {
+        UIManager ui;
+        std::vector<UINode *> leaves;
+    };
+    auto state = std::make_shared<LayoutState>();
+
+    // Root -> sections -> rows -> leaves: 1 + 50 + 1000 + 50000 nodes.
+    FlexStyle row {};
+    row.direction = FlexDirection::Row;
+    FlexStyle leaf {};
+    leaf.width = LAYOUT_LEAF_SIZE;
+    leaf.height = LAYOUT_LEAF_SIZE;
+    for (uint32_t s = 0; s < LAYOUT_SECTIONS; ++s) {
+        UINode &section = state->ui.getRoot().addChild(std::make_unique<UINode>());
+        for (uint32_t r = 0; r < LAYOUT_ROWS_PER_SECTION; ++r) {
+            UINode &rowNode = section.addChild(std::make_unique<UINode>(row));
+            for (uint32_t l = 0; l < LAYOUT_LEAVES_PER_ROW; ++l) {
+                state->leaves.push_back(&rowNode.addChild(std::make_unique<UINode>(leaf)));
+            }
+        }
+    }
+    state->ui.updateLayout(LAYOUT_VIEWPORT);
+
+    cases.push_back({
+        .name = "layout.relayout_one_leaf_50k",
+        .run = [state](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                // Leaves are visited in a stride so consecutive operations touch different rows.
+                UINode &node = *state->leaves[(i * 7919) % state->leaves.size()];
+                FlexStyle style = node.getStyle();
+                style.width = *style.width == LAYOUT_LEAF_SIZE ? LAYOUT_LEAF_SIZE + 1.0f : LAYOUT_LEAF_SIZE;
+                node.setStyle(style);
+                state->ui.updateLayout(LAYOUT_VIEWPORT);
+            }
+            keepAlive(state->ui.getRoot().getRect());
+        },
+    });
+}
+
+// Queries against 100k proxies in a grid spanning four times the viewport in each direction, so that the
+// viewport ("frustum") query culls most of the tree, as it would for a scrolled or zoomed UI.
+void addSpatialCases(std::vector<MicroCase> &cases) {
+    auto index = std::make_shared<SpatialIndex>();
+    const uint32_t columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(SPATIAL_PROXIES))));
+    const float cell = 2.0f * SPATIAL_EXTENT / static_cast<float>(columns);
+    for (uint32_t i = 0; i < SPATIAL_PROXIES; ++i) {
+        const glm::vec2 min {-SPATIAL_EXTENT + static_cast<float>(i % columns) * cell, -SPATIAL_EXTENT + static_cast<float>(i / columns) * cell};
+        index->createProxy(AABB{min, min + cell * 0.8f}, nullptr);
+    }
+
+    // Precomputed, so the timed loop only queries. A fixed seed keeps the workload identical between runs.
+    auto points = std::make_shared<std::vector<glm::vec2>>();
+    std::mt19937 random {42};
+    std::uniform_real_distribution<float> coordinate {-SPATIAL_EXTENT, SPATIAL_EXTENT};
+    for (uint32_t i = 0; i < 1024; ++i) {
+        points->push_back({coordinate(random), coordinate(random)});
+    }
+
+    // A damage-sized rectangle, about a tenth of the viewport across.
+    cases.push_back({
+        .name = "spatial.query_rect_100k",
+        .run = [index, points](uint64_t iterations) {
+            uint64_t hits = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                const glm::vec2 &point = (*points)[i & 1023];
+                index->queryRect(AABB{point, point + 0.2f}, [&hits](Primitives::Primitive *) { ++hits; });
+            }
+            keepAlive(hits);
+        },
+    });
+
+    cases.push_back({
+        .name = "spatial.query_point_100k",
+        .run = [index, points](uint64_t iterations) {
+            uint64_t hits = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                index->queryPoint((*points)[i & 1023], [&hits](Primitives::Primitive *) { ++hits; });
+            }
+            keepAlive(hits);
+        },
+    });
+
+    // The per-frame visibility query: everything inside the viewport, about 6k of the 100k proxies.
+    cases.push_back({
+        .name = "spatial.query_frustum_100k",
+        .run = [index](uint64_t iterations) {
+            uint64_t hits = 0;
+            for (uint64_t i = 0; i < iterations; ++i) {
+                index->queryRect(AABB{{-1.0f, -1.0f}, {1.0f, 1.0f}}, [&hits](Primitives::Primitive *) { ++hits; });
+            }
+            keepAlive(hits);
+        },
+    });
+}
+
+void addUiCases(std::vector<MicroCase> &cases, HeadlessContext &context) {
+    VGeometryRegistry &geometry = *context.geometry;
+
+    struct AddState {
+        std::unique_ptr<UIManager> ui;
+        std::vector<std::string> names;
+        std::vector<std::unique_ptr<Primitives::Primitive>> quads;
+    };
+    auto add = std::make_shared<AddState>();
+
+    // Building the quads and tearing the manager down are left out; only the insertions are timed.
+    cases.push_back({
+        .name = "ui.add",
+        .run = [add](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                add->ui->add(add->names[i], std::move(add->quads[i]));
+            }
+        },
+        .setup = [add, &geometry](uint64_t iterations) {
+            add->ui = std::make_unique<UIManager>();
+            add->names.resize(iterations);
+            add->quads.resize(iterations);
+            for (uint64_t i = 0; i < iterations; ++i) {
+                add->names[i] = "quad" + std::to_string(i);
+                add->quads[i] = std::make_unique<Primitives::Quad>(geometry);
+            }
+        },
+        .teardown = [add] {
+            add->ui.reset();
+            add->quads.clear();
+        },
+        // Every iteration keeps a quad alive until teardown, so the count is fixed rather than calibrated.
+        .iterations = 20000,
+    });
+
+    auto populated = std::make_shared<UIManager>();
+    auto names = std::make_shared<std::vector<std::string>>();
+    for (uint32_t i = 0; i < UI_ELEMENTS; ++i) {
+        names->push_back("quad" + std::to_string(i));
+        auto quad = std::make_unique<Primitives::Quad>(geometry);
+        quad->setPosition({static_cast<float>(i % 32) / 16.0f - 1.0f, static_cast<float>(i / 32) / 16.0f - 1.0f});
+        populated->add(names->back(), std::move(quad));
+    }
+
+    cases.push_back({
+        .name = "ui.get",
+        .run = [populated, names](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                keepAlive(populated->get((*names)[i % UI_ELEMENTS]));
+            }
+        },
+    });
+
+    // Per element visited, the way the renderer walks the elements each frame.
+    cases.push_back({
+        .name = "ui.iterate",
+        .run = [populated](uint64_t iterations) {
+            float sum = 0.0f;
+            uint64_t visited = 0;
+            while (visited < iterations) {
+                for (const auto &[name, element] : populated->getElements()) {
+                    sum += element->getTransform().position.x;
+                    if (++visited == iterations) {
+                        break;
+                    }
+                }
+            }
+            keepAlive(sum);
+        },
+    });
+}
+
+void addBufferCases(std::vector<MicroCase> &cases, HeadlessContext &context) {
+    VDevice &device = *context.device;
+    constexpr VkMemoryPropertyFlags hostVisible = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    // A fresh buffer and allocation per operation, the cost behind every new mesh.
+    cases.push_back({
+        .name = "vbuffer.create",
+        .run = [&device](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                VBuffer buffer {device, BUFFER_BYTES, 1, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostVisible};
+                keepAlive(buffer.getBuffer());
+            }
+        },
+    });
+
+    auto buffer = std::make_shared<VBuffer>(device, BUFFER_BYTES, 1, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, hostVisible);
+
+    cases.push_back({
+        .name = "vbuffer.map",
+        .run = [buffer](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                buffer->map();
+                keepAlive(buffer->getMappedMemory());
+                buffer->unmap();
+            }
+        },
+    });
+
+    auto data = std::make_shared<std::vector<uint8_t>>(WRITE_BYTES, 0x5a);
+    cases.push_back({
+        .name = "vbuffer.write_4k",
+        .run = [buffer, data](uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; ++i) {
+                buffer->writeToBuffer(data->data(), WRITE_BYTES, (i * WRITE_BYTES) % BUFFER_BYTES);
+            }
+            keepAlive(buffer->getMappedMemory());
+        },
+        .setup = [buffer](uint64_t) { buffer->map(); },
+        .teardown = [buffer] { buffer->unmap(); },
+    });
+}
+
+}
+
+int main(int argc, char **argv) {
+    MicroBenchOptions options;
+    try {
+        options = parseOptions(argc, argv);
+    } catch (const std::exception &e) {
+        std::cerr << "Error: " << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream out;
+    if (!options.out.empty()) {
+        out.open(options.out, std::ios::app);
+        if (!out) {
+            std::cerr << "Error: Could not open " << options.out << ".\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The workers start before the main thread is pinned so that they keep the full CPU mask.
+    JobSystem jobs;
+    if (options.harness.cpu && !pinCurrentThread(*options.harness.cpu)) {
+        std::cerr << "Warning: Could not pin to CPU " << *options.harness.cpu << "; running unpinned.\n";
+    }
+
+    // Only the UI and buffer cases need a device; without one the rest still run.
+    std::unique_ptr<HeadlessContext> context;
+    try {
+        context = std::make_unique<HeadlessContext>();
+    } catch (const std::exception &e) {
+        std::cerr << "Warning: No Vulkan device (" << e.what() << "); skipping the ui and vbuffer cases.\n";
+    }
+
+    std::vector<MicroCase> cases;
+    addColorCases(cases);
+    addJobCases(cases, jobs);
+    addLayoutCases(cases);
+    addSpatialCases(cases);
+    if (context) {
+        addUiCases(cases, *context);
+        addBufferCases(cases, *context);
+    }
+
+    bool matched = false;
+    for (const MicroCase &microCase : cases) {
+        if (microCase.name.find(options.harness.filter) == std::string::npos) {
+            continue;
+        }
+        matched = true;
+
+        std::ostringstream line;
+        writeJson(line, runMicroCase(microCase, options.harness));
+        std::cout << line.str() << '\n';
+        if (out.is_open()) {
+            out << line.str() << '\n';
+        }
+    }
+
+    if (!matched) {
+        std::cerr << "Error: No case matches \"" << options.harness.filter << "\".\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
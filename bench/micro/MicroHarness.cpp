@@ -0,0 +1,110 @@
+#include "MicroHarness.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+// Calibration stops growing the iteration count here, whatever the repetition time.
+constexpr uint64_t MAX_ITERATIONS = uint64_t{1} << 26;
+
+double timeRepetition(const MicroCase &microCase, uint64_t iterations) {
+    if (microCase.setup) {
+        microCase.setup(iterations);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    microCase.run(iterations);
+    const auto end = std::chrono::steady_clock::now();
+
+    if (microCase.teardown) {
+        microCase.teardown();
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Grows the iteration count until one repetition takes about the requested time. The calibration runs
+// double as the first warmup.
+uint64_t calibrate(const MicroCase &microCase, double targetNanoseconds) {
+    uint64_t iterations = 1;
+    while (iterations < MAX_ITERATIONS) {
+        const double elapsed = timeRepetition(microCase, iterations);
+        if (elapsed >= targetNanoseconds) {
+            break;
+        }
+
+        // Overshoot slightly so the last step lands above the target, but never jump more than tenfold on a noisy sample.
+        const double scale = elapsed > 0.0 ? targetNanoseconds * 1.2 / elapsed : 10.0;
+        iterations = std::min(MAX_ITERATIONS, static_cast<uint64_t>(static_cast<double>(iterations) * std::clamp(scale, 2.0, 10.0)));
+    }
+    return iterations;
+}
+
+}
+
+MicroResult runMicroCase(const MicroCase &microCase, const MicroOptions &options) {
+    const uint64_t iterations = microCase.iterations ? *microCase.iterations : calibrate(microCase, options.repetitionMilliseconds * 1.0e6);
+
+    for (uint32_t i = 0; i < options.warmup; ++i) {
+        timeRepetition(microCase, iterations);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options.repetitions);
+    for (uint32_t i = 0; i < options.repetitions; ++i) {
+        samples.push_back(timeRepetition(microCase, iterations) / static_cast<double>(iterations));
+    }
+
+    MicroResult result {
+        .name = microCase.name,
+        .iterations = iterations,
+        .repetitions = options.repetitions,
+    };
+    if (samples.empty()) {
+        return result;
+    }
+
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    result.mean = sum / static_cast<double>(samples.size());
+
+    double squares = 0.0;
+    for (double sample : samples) {
+        squares += (sample - result.mean) * (sample - result.mean);
+    }
+    result.stddev = samples.size() > 1 ? std::sqrt(squares / static_cast<double>(samples.size() - 1)) : 0.0;
+
+    const auto [min, max] = std::minmax_element(samples.begin(), samples.end());
+    result.min = *min;
+    result.max = *max;
+    return result;
+}
+
+bool pinCurrentThread(uint32_t cpu) {
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void writeJson(std::ostream &out, const MicroResult &result) {
+    out << "{\"bench\":\"" << result.name << "\",\"iterations\":" << result.iterations << ",\"repetitions\":" << result.repetitions
+        << ",\"mean_ns\":" << result.mean << ",\"stddev_ns\":" << result.stddev << ",\"min_ns\":" << result.min
+        << ",\"max_ns\":" << result.max << "}";
+}
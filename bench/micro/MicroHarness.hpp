@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Keeps the compiler from discarding a value that is computed only to be measured.
+template <typename T>
+inline void keepAlive(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// One microbenchmark. `run` performs `iterations` operations and is the only timed part; `setup` and `teardown`
+// surround every repetition with the same iteration count, untimed, for work that must not be measured.
+struct MicroCase {
+    std::string name;
+    std::function<void(uint64_t iterations)> run;
+    std::function<void(uint64_t iterations)> setup;
+    std::function<void()> teardown;
+    // Fixed iterations per repetition; by default the harness picks enough to fill the repetition time.
+    std::optional<uint64_t> iterations;
+};
+
+struct MicroOptions {
+    uint32_t warmup = 3;
+    uint32_t repetitions = 10;
+    double repetitionMilliseconds = 20.0;
+    std::optional<uint32_t> cpu; // Pins the measuring thread to this CPU.
+    std::string filter;          // Runs only the cases whose name contains it.
+};
+
+// Nanoseconds per operation over the measured repetitions.
+struct MicroResult {
+    std::string name;
+    uint64_t iterations = 0;
+    uint32_t repetitions = 0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+};
+
+// Calibrates, warms up and times one case. Each repetition yields one ns/op sample, so the spread between
+// repetitions shows how far the mean can be trusted.
+MicroResult runMicroCase(const MicroCase &microCase, const MicroOptions &options);
+
+// Pins the calling thread. Threads it starts afterwards inherit the pin, so start worker pools first.
+// Returns false when pinning is unavailable or the CPU does not exist.
+bool pinCurrentThread(uint32_t cpu);
+
+// One result as a single line of JSON.
+void writeJson(std::ostream &out, const MicroResult &result);
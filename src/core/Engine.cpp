@@ -1,12 +1,18 @@
 #include "Engine.hpp"
+#include "scene/DemoScene.hpp"
 #include "ui/Primitives.hpp"
 #include "ui/UIManager.hpp"
-#include "util/Color.hpp"
+#include "util/Profiler.hpp"
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -27,6 +33,24 @@ extern "C" {
     extern const unsigned int iro_engine_icon_png_len;
 }
 
+Engine::Engine(EngineOptions options) : options(std::move(options)) {
+    scene = this->options.scene ? std::move(this->options.scene) : std::make_unique<DemoScene>();
+
+    if (!this->options.replayPath.empty()) {
+        auto replay = std::make_unique<ReplayScene>(this->options.replayPath, std::move(scene));
+        this->options.headless = true;
+        this->options.extent = replay->getExtent();
+        if (this->options.frameLimit == 0) {
+            this->options.frameLimit = replay->getFrames();
+        }
+        scene = std::move(replay);
+    }
+
+    if (this->options.headless && this->options.frameLimit == 0) {
+        this->options.frameLimit = DEFAULT_HEADLESS_FRAMES;
+    }
+}
+
 void Engine::run() {
     init();
     mainLoop();
@@ -34,33 +58,21 @@ void Engine::run() {
 }
 
 void Engine::init() {
-    glfwInit();
-    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
-    window = glfwCreateWindow(INITIAL_WIDTH, INITIAL_HEIGHT, "Iro Engine", nullptr, nullptr);
-    glfwSetWindowUserPointer(window, this);
-    glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
-
-    // Load window icon from embedded memory.
-    int iconWidth, iconHeight, iconChannels;
-    unsigned char *pixels = stbi_load_from_memory(iro_engine_icon_png, iro_engine_icon_png_len, &iconWidth, &iconHeight, &iconChannels, STBI_rgb_alpha);
-    if (pixels) {
-        GLFWimage images[1];
-        images[0].width = iconWidth;
-        images[0].height = iconHeight;
-        images[0].pixels = pixels;
-        glfwSetWindowIcon(window, 1, images);
-        stbi_image_free(pixels);
-    } else {
-        std::cerr << "Warning: Could not load window icon from embedded data.\n";
+    // Headless runs never touch GLFW, so they also work on machines without a display server.
+    if (!options.headless) {
+        createWindow();
     }
 
     createInstance();
-    createSurface();
+    if (!options.headless) {
+        createSurface();
+    }
 
-    vDevice = std::make_unique<VDevice>(instance, surface, window);
-    vSwapChain = std::make_unique<VSwapChain>(*vDevice, VkExtent2D{INITIAL_WIDTH, INITIAL_HEIGHT});
-    vRenderer = std::make_unique<VRenderer>(*vDevice, *vSwapChain, threadResources);
+    vDevice = std::make_unique<VDevice>(instance, surface, window, apiVersion);
+    vGeometry = std::make_unique<VGeometryRegistry>(*vDevice);
+    vSwapChain = std::make_unique<VSwapChain>(*vDevice, options.extent);
+    vRenderer = std::make_unique<VRenderer>(*vDevice, *vSwapChain, jobSystem, threadResources);
+    vRenderer->getOverlay().setEnabled(options.overlay);
     uiManager = std::make_unique<UIManager>();
 
     // Multi-thread command resources
@@ -84,143 +96,230 @@ void Engine::init() {
                 .level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
                 .commandBufferCount = 1
             };
-            vkAllocateCommandBuffers(vDevice->device(), &ai, &res.buffer);
+            vDevice->allocateCommandBuffers(ai, &res.buffer);
         }
     }
 
-    // UI
-
-    auto squareVerts = Primitives::Vertex::create_default_quad();
-
-    squareVerts[0].color = ColorUtil::rgba_to_uint32_aabbggrr({1.0f, 0.0f, 0.0f, 1.0f});
-    squareVerts[1].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 1.0f, 0.0f, 1.0f});
-    squareVerts[2].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 0.0f, 1.0f, 1.0f});
-    squareVerts[3].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 0.0f, 0.0f, 1.0f});
-
-    auto square = std::make_unique<Primitives::Quad>(*vDevice);
-    square->setVertices(squareVerts);
-    square->setPosition({0.70f, 0.0f});
-    square->setScale({0.5f, 0.5f});
-    uiManager->add("square", std::move(square));
-
-
-    auto triangleVerts = Primitives::Vertex::create_default_triangle();
-
-    triangleVerts[0].color = ColorUtil::rgba_to_uint32_aabbggrr({1.0f, 0.0f, 0.0f, 1.0f});
-    triangleVerts[1].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 1.0f, 0.0f, 1.0f});
-    triangleVerts[2].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 0.0f, 1.0f, 1.0f});
-
-    auto triangle = std::make_unique<Primitives::Triangle>(*vDevice);
-    triangle->setVertices(triangleVerts);
-    triangle->setPosition({-0.75f, 0});
-    triangle->setScale({0.5f, 0.5f});
-    uiManager->add("triangle", std::move(triangle));
+    // Scene
+    sceneContext.emplace(SceneContext{*uiManager, *vGeometry, *vRenderer, [this](VkExtent2D extent) { resize(extent); }});
+    scene->load(*sceneContext);
+    if (!options.capturePath.empty()) {
+        recorder = std::make_unique<SessionRecorder>(options.capturePath, vSwapChain->getExtent(), *uiManager);
+        uiManager->setObserver(recorder.get());
+    }
 
     // Discord
-    discord = std::make_unique<Discord>();
-    discord->init();
+    if (!options.headless) {
+        discord = std::make_unique<Discord>();
+        discord->init();
+    }
 }
 
-void Engine::mainLoop() {
-    double lastTime = glfwGetTime();
-    int frameCount = 0;
+bool Engine::shouldClose(uint64_t framesRendered) const {
+    if (options.frameLimit != 0 && framesRendered >= options.frameLimit) {
+        return true;
+    }
+    return window && glfwWindowShouldClose(window);
+}
 
-    while (!glfwWindowShouldClose(window)) {
-        glfwPollEvents();
-        discord->update();
+void Engine::mainLoop() {
+    // Timed with a steady clock rather than glfwGetTime, which needs GLFW and so is unavailable headless.
+    const auto start = std::chrono::steady_clock::now();
+    uint64_t framesRendered = 0;
+    std::vector<Primitives::Primitive *> visible;
+
+    IRO_PROFILE_THREAD("Main");
+    // Loading is over; from here on, Vulkan objects created or destroyed are charged to the frame that did it.
+    VResourceTracker &resources = vDevice->resources();
+    resources.markFrame();
+#ifdef IRO_TRACK_ALLOCS
+    frameAllocations.markFrame();
+#endif
 
-        const float t = glfwGetTime();
-        ++frameCount;
-        if (t - lastTime >= 1.0) {
-            std::string title = "Iro Engine - " + std::to_string(frameCount) + " FPS";
-            glfwSetWindowTitle(window, title.c_str());
-            frameCount = 0;
-            lastTime = t;
+    // Reading the budget allocates, so the overlay's figure is refreshed once per stats window, not every frame.
+    VPerfOverlay &overlay = vRenderer->getOverlay();
+    std::optional<VkDeviceSize> memoryBudget = deviceLocalBudget();
+    std::chrono::nanoseconds busyBefore = jobSystem.busyTime();
+
+    while (!shouldClose(framesRendered)) {
+        IRO_PROFILE_ZONE("Frame");
+        // Anything in the frame not tagged more specifically below is the renderer's.
+        IRO_ALLOC_TAG(Renderer);
+        const auto frameStart = std::chrono::steady_clock::now();
+        if (window) {
+            glfwPollEvents();
+        }
+        if (discord) {
+            discord->update();
         }
 
-        const float s = 0.5f + 0.02f * std::sin(t * 5.0f);
-        uiManager->get("triangle")->setScale({s, s});
+        const float t = std::chrono::duration<float>(frameStart - start).count();
+        {
+            IRO_ALLOC_TAG(UI);
+            scene->update(*sceneContext, framesRendered, t);
+        }
 
         VkCommandBuffer primary = vRenderer->beginFrame();
+        // Recorded even when the frame is skipped, since the update it follows has already run.
+        if (recorder)
+            recorder->endFrame(vSwapChain->getExtent());
         if (!primary)
             continue;
 
+        // beginFrame has just read back the GPU timings of this slot's previous frame.
+        const std::optional<double> gpuMilliseconds = vRenderer->getGpuFrameMilliseconds();
+        const std::optional<double> transferMilliseconds = vRenderer->getTransferMilliseconds();
+
+        // Uploads go in before the render pass; sprites whose textures arrived are redrawn.
+        if (vRenderer->getTextures().upload(vRenderer->getUploads()))
+            uiManager->refreshTextures();
+
+        // Promoted meshes live in new buffers, so every cached secondary must be recorded again.
+        vGeometry->beginFrame(vRenderer->getFrameIndex());
+        if (vGeometry->promote(vRenderer->getUploads(), vRenderer->getStagingRing())) {
+            for (auto &frameVec : threadResources)
+                for (auto &res : frameVec)
+                    res.recorded = false;
+        }
+
+        const VkExtent2D extent = vSwapChain->getExtent();
+        {
+            IRO_ALLOC_TAG(UI);
+            uiManager->setViewportAspect(vSwapChain->extentAspectRatio());
+            uiManager->updateLayout({static_cast<float>(extent.width), static_cast<float>(extent.height)});
+        }
+        vRenderer->getTextRenderer().prepare(*uiManager, vRenderer->getFrameIndex(), primary, vRenderer->getStagingRing());
+        const std::optional<AABB> overlayDamage = overlay.prepare(vRenderer->getFrameIndex());
+
         // Record (or reuse) secondary command buffers in parallel
         auto &frameRes = threadResources[vRenderer->getFrameIndex()];
         const std::size_t workerCount = frameRes.size();
         std::vector<VkCommandBuffer> secondaries;
         secondaries.reserve(workerCount);
 
-        std::size_t w = 0;
-        const auto &all = uiManager->getElements();
-        auto it = all.begin();
+        // Damage in window pixels: primitive edits are reported in NDC, text edits already in pixels.
+        const glm::vec2 viewport{static_cast<float>(extent.width), static_cast<float>(extent.height)};
+        std::optional<AABB> damage = vRenderer->getTextRenderer().takeDamage();
+        if (auto ndc = uiManager->takeDamage()) {
+            const AABB pixels{(ndc->min + 1.0f) * 0.5f * viewport, (ndc->max + 1.0f) * 0.5f * viewport};
+            damage = damage ? AABB::merge(*damage, pixels) : pixels;
+        }
+        if (overlayDamage) {
+            damage = damage ? AABB::merge(*damage, *overlayDamage) : *overlayDamage;
+        }
+
+        VkRect2D damageRect {};
+        if (damage) {
+            // Round outwards, with a pixel of slack for antialiased edges.
+            const int32_t x0 = static_cast<int32_t>(std::floor(damage->min.x)) - 1;
+            const int32_t y0 = static_cast<int32_t>(std::floor(damage->min.y)) - 1;
+            const int32_t x1 = static_cast<int32_t>(std::ceil(damage->max.x)) + 1;
+            const int32_t y1 = static_cast<int32_t>(std::ceil(damage->max.y)) + 1;
+            damageRect = {{x0, y0}, {static_cast<uint32_t>(std::max(0, x1 - x0)), static_cast<uint32_t>(std::max(0, y1 - y0))}};
+        }
 
-        while (it != all.end()) {
-            // Gather up to 64 primitives into one batch
-            std::vector<Primitives::Primitive *> batch;
-            batch.reserve(64);
-            for (std::size_t k = 0; k < 64 && it != all.end(); ++k, ++it)
-                batch.push_back(it->second.get());
+        vRenderer->setDamage(damageRect);
+        const VkRect2D scissor = vRenderer->getDamage();
+
+        // Only primitives overlapping the damaged region are recorded. Sorting by draw order keeps both the
+        // overlap order and batch membership stable between frames and runs, and sizing batches by worker
+        // count gives each batch its own buffer.
+        visible.clear();
+        if (vRenderer->hasDamage()) {
+            const glm::vec2 regionMin = glm::vec2(scissor.offset.x, scissor.offset.y) / viewport * 2.0f - 1.0f;
+            const glm::vec2 regionMax = glm::vec2(scissor.offset.x + scissor.extent.width, scissor.offset.y + scissor.extent.height) / viewport * 2.0f - 1.0f;
+            uiManager->queryRect(AABB{regionMin, regionMax}, visible);
+        }
+        std::sort(visible.begin(), visible.end(), [](const Primitives::Primitive *a, const Primitives::Primitive *b) {
+            return a->getDrawOrder() < b->getDrawOrder();
+        });
 
-            const std::size_t id = w++ % workerCount;
+        const std::size_t batchSize = std::max<std::size_t>(64, (visible.size() + workerCount - 1) / workerCount);
+        std::size_t batchCount = 0;
+        JobCounter recording;
+        std::atomic<uint32_t> primitivesRecorded {0};
+        std::atomic<uint32_t> primitivesReused {0};
+
+        for (std::size_t begin = 0; begin < visible.size(); begin += batchSize) {
+            const std::size_t end = std::min(visible.size(), begin + batchSize);
+            std::vector<Primitives::Primitive *> batch(visible.begin() + begin, visible.begin() + end);
+
+            const std::size_t id = batchCount++;
             jobSystem.push([&, id, batch] {
+                IRO_PROFILE_ZONE("Record batch");
+                IRO_ALLOC_TAG(Renderer);
                 auto &res = frameRes[id];
                 const VkFramebuffer fb = vRenderer->getCurrentFramebuffer();
 
-                bool needsRecord = !res.recorded || (res.framebufferUsed != fb);
+                const bool sameScissor = res.scissorUsed.offset.x == scissor.offset.x && res.scissorUsed.offset.y == scissor.offset.y &&
+                                         res.scissorUsed.extent.width == scissor.extent.width && res.scissorUsed.extent.height == scissor.extent.height;
+                const bool sameExtent = res.extentUsed.width == extent.width && res.extentUsed.height == extent.height;
+
+                // With dynamic rendering the framebuffer is always null, so rotating images keeps buffers valid.
+                bool needsRecord = !res.recorded || (res.framebufferUsed != fb) || (res.contents != batch) || !sameScissor || !sameExtent;
                 if (!needsRecord) {
                     for (auto *p : batch)
                         if (p->dirty()) { needsRecord = true; break; }
                 }
 
                 if (!needsRecord) {
-                    for (auto *p : batch) p->clearDirty();
+                    for (auto *p : batch) {
+                        vRenderer->writeInstance(*p);
+                        p->clearDirty();
+                    }
+                    primitivesReused.fetch_add(static_cast<uint32_t>(batch.size()), std::memory_order_relaxed);
                     return;
                 }
 
                 vkResetCommandBuffer(res.buffer, 0);
-
-                VkCommandBufferInheritanceInfo inh {
-                    .sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
-                    .renderPass  = vRenderer->getSwapChainRenderPass(),
-                    .subpass     = 0,
-                    .framebuffer = fb
-                };
-
-                VkCommandBufferBeginInfo bi {
-                    .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                    .flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT,
-                    .pInheritanceInfo = &inh
-                };
-                vkBeginCommandBuffer(res.buffer, &bi);
+                vRenderer->beginSecondary(res.buffer, VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
 
                 VkViewport vp {
                     0, 0,
-                    static_cast<float>(vSwapChain->getExtent().width),
-                    static_cast<float>(vSwapChain->getExtent().height),
+                    static_cast<float>(extent.width),
+                    static_cast<float>(extent.height),
                     0.0f, 1.0f
                 };
 
-                VkRect2D sc {{0, 0}, vSwapChain->getExtent()};
                 vkCmdSetViewport(res.buffer, 0, 1, &vp);
-                vkCmdSetScissor (res.buffer, 0, 1, &sc);
+                vkCmdSetScissor (res.buffer, 0, 1, &scissor);
+                vRenderer->bindPrimitiveLayer(res.buffer);
 
+                // A reused buffer writes the same queries again, so cached batches are timed too.
+                vRenderer->getGpuTimer().begin(res.buffer, VRenderer::batchScope(id));
                 for (auto *p : batch) {
                     vRenderer->draw(res.buffer, *p);
                     p->clearDirty();
                 }
+                vRenderer->getGpuTimer().end(res.buffer, VRenderer::batchScope(id));
+                primitivesRecorded.fetch_add(static_cast<uint32_t>(batch.size()), std::memory_order_relaxed);
 
                 vkEndCommandBuffer(res.buffer);
                 res.recorded        = true;
                 res.framebufferUsed = fb;
-            });
+                res.contents        = batch;
+                res.scissorUsed     = scissor;
+                res.extentUsed      = extent;
+            }, &recording);
         }
 
-        jobSystem.wait();
+        // Only this frame's recording; background jobs such as texture decodes keep running.
+        jobSystem.wait(recording);
+
+        // The damaged region is cleared before anything is drawn into it.
+        if (VkCommandBuffer clear = vRenderer->recordDamageClear())
+            secondaries.push_back(clear);
 
-        for (auto &res : frameRes)
-            if (res.recorded)
-                secondaries.push_back(res.buffer);
+        for (std::size_t id = 0; id < batchCount; ++id)
+            secondaries.push_back(frameRes[id].buffer);
+
+        // Text goes last so it draws above every primitive; the overlay is drawn in the same buffer, above the text.
+        uint32_t drawCalls = static_cast<uint32_t>(visible.size());
+        if (VkCommandBuffer text = vRenderer->recordText()) {
+            secondaries.push_back(text);
+            drawCalls += (vRenderer->getTextRenderer().getInstanceCount(vRenderer->getFrameIndex()) > 0 ? 1 : 0) +
+                         (overlay.hasContent(vRenderer->getFrameIndex()) ? 1 : 0);
+        }
 
         vRenderer->beginSwapChainRenderPass(primary);
         if (!secondaries.empty())
@@ -228,13 +327,105 @@ void Engine::mainLoop() {
         
         vRenderer->endSwapChainRenderPass(primary);
         vRenderer->endFrame();
+        resources.markFrame();
+#ifdef IRO_TRACK_ALLOCS
+        frameAllocations.markFrame();
+#endif
+        ++framesRendered;
+
+        const auto frameEnd = std::chrono::steady_clock::now();
+        const double cpuMilliseconds = std::chrono::duration<double, std::milli>(frameEnd - frameStart).count();
+        const bool windowDone = frameStats.recordFrame(cpuMilliseconds, gpuMilliseconds);
+        if (windowDone && window) {
+            const FrameStats::Summary &last = frameStats.lastWindow(FrameStats::Channel::Cpu);
+            const int fps = static_cast<int>(std::lround(static_cast<double>(last.frames) / last.seconds));
+            std::string title = "Iro Engine - " + std::to_string(fps) + " FPS, p99 " + std::to_string(static_cast<int>(std::ceil(last.p99))) + " ms";
+            glfwSetWindowTitle(window, title.c_str());
+        }
+
+        const std::chrono::nanoseconds busy = jobSystem.busyTime();
+        if (overlay.isEnabled()) {
+            if (windowDone) {
+                memoryBudget = deviceLocalBudget();
+            }
+            // Busy time also counts background jobs, which run on the same workers.
+            const double available = std::chrono::duration<double>(frameEnd - frameStart).count() * static_cast<double>(jobSystem.workerCount());
+            overlay.record(PerfSample {
+                .cpuMilliseconds = cpuMilliseconds,
+                .gpuMilliseconds = gpuMilliseconds,
+                .transferMilliseconds = transferMilliseconds,
+                .drawCalls = drawCalls,
+                .primitivesRecorded = primitivesRecorded.load(std::memory_order_relaxed),
+                .primitivesReused = primitivesReused.load(std::memory_order_relaxed),
+                .workerUtilization = available > 0.0 ? std::min(1.0, std::chrono::duration<double>(busy - busyBefore).count() / available) : 0.0,
+                .gpuMemory = resources.snapshot().live.bytes,
+                .gpuMemoryBudget = memoryBudget,
+            });
+        }
+        busyBefore = busy;
     }
 
     vkDeviceWaitIdle(vDevice->device());
+    resourceStats = resources.snapshot();
+
+    if (options.headless) {
+        const FrameStats::Summary cpu = frameStats.total(FrameStats::Channel::Cpu);
+        const FrameStats::Summary gpu = frameStats.total(FrameStats::Channel::Gpu);
+        std::cout << "Headless: rendered " << framesRendered << " frames in " << cpu.seconds << " s. CPU p50 " << cpu.p50
+                  << " ms, p99 " << cpu.p99 << " ms, max " << cpu.max << " ms, " << cpu.hitches << " hitches; GPU p50 " << gpu.p50
+                  << " ms, p99 " << gpu.p99 << " ms.\n";
+
+        // Headroom is that of the tightest device-local heap, which is where running out hurts.
+        std::optional<VkDeviceSize> headroom;
+        for (const VDevice::HeapBudget &heap : vDevice->memoryBudget()) {
+            if (heap.deviceLocal) {
+                const VkDeviceSize left = heap.budget > heap.usage ? heap.budget - heap.usage : 0;
+                headroom = headroom ? std::min(*headroom, left) : left;
+            }
+        }
+
+        constexpr double mebibyte = 1024.0 * 1024.0;
+        const double frames = static_cast<double>(std::max<uint64_t>(1, resourceStats.frames));
+        std::cout << "Vulkan: " << resourceStats.live.buffers << " buffers, " << resourceStats.live.images << " images, "
+                  << static_cast<double>(resourceStats.live.bytes) / mebibyte << " MiB live (peak "
+                  << static_cast<double>(resourceStats.peak.bytes) / mebibyte << " MiB); "
+                  << static_cast<double>(resourceStats.total.allocations) / frames << " allocations per frame, worst frame "
+                  << resourceStats.worstFrame.allocations;
+        if (headroom) {
+            std::cout << "; " << static_cast<double>(*headroom) / mebibyte << " MiB device-local headroom";
+        }
+        std::cout << ".\n";
+
+#ifdef IRO_TRACK_ALLOCS
+        std::cout << "Allocations: " << frameAllocations.allocationsPerFrame() << " per frame (" << frameAllocations.bytesPerFrame()
+                  << " bytes), worst frame " << frameAllocations.worstFrame().allocations << ";";
+        for (std::size_t tag = 0; tag < AllocTracker::TAGS; ++tag) {
+            std::cout << ' ' << AllocTracker::tagName(static_cast<AllocTracker::Tag>(tag)) << ' '
+                      << frameAllocations.allocationsPerFrame(static_cast<AllocTracker::Tag>(tag));
+        }
+        std::cout << ".\n";
+#endif
+    }
+
+    if (const char *reportPath = std::getenv(FRAME_STATS_ENV)) {
+        if (frameStats.writeReport(reportPath)) {
+            std::cout << "Frame statistics written to " << reportPath << ".\n";
+        } else {
+            std::cerr << "Warning: Could not write frame statistics to " << reportPath << ".\n";
+        }
+    }
 }
 
 void Engine::cleanup() {
+    if (recorder) {
+        uiManager->setObserver(nullptr);
+        std::cout << "Captured " << recorder->getFrames() << " frames to " << recorder->getPath() << ".\n";
+        recorder.reset();
+    }
+    sceneContext.reset();
+    scene.reset();
     uiManager.reset();
+    vGeometry.reset();
     vRenderer.reset();
     vSwapChain.reset();
 
@@ -243,19 +434,43 @@ void Engine::cleanup() {
     for (auto &vec : threadResources) {
         for (auto &res : vec) {
             if (res.pool)
-                vkDestroyCommandPool(vDevice->device(), res.pool, nullptr);
+                vDevice->destroyCommandPool(res.pool);
         }
         vec.clear();
     }
 
+    // Everything the engine created has been destroyed by now; whatever the device still counts was leaked.
+    vDevice->resources().reportLeaks(std::cerr);
     vDevice.reset();
     discord.reset();
 
-    vkDestroySurfaceKHR(instance, surface, nullptr);
+    if (surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance, surface, nullptr);
+    }
     vkDestroyInstance(instance, nullptr);
 
-    glfwDestroyWindow(window);
-    glfwTerminate();
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+
+#ifdef IRO_PROFILE
+    const char *tracePath = std::getenv(TRACE_PATH_ENV);
+    const std::string path = tracePath ? tracePath : "iro-trace.json";
+    if (Profiler::writeChromeTrace(path)) {
+        std::cout << "Profiler: wrote trace to " << path << ".\n";
+    } else {
+        std::cerr << "Warning: Could not write profiler trace to " << path << ".\n";
+    }
+#endif
+}
+
+void Engine::resize(VkExtent2D extent) {
+    if (window) {
+        glfwSetWindowSize(window, static_cast<int>(extent.width), static_cast<int>(extent.height));
+    } else {
+        vSwapChain->resizeOffscreen(extent);
+    }
 }
 
 void Engine::framebufferResizeCallback(GLFWwindow *window, int width, int height) {
@@ -263,18 +478,65 @@ void Engine::framebufferResizeCallback(GLFWwindow *window, int width, int height
     engine->vSwapChain->framebufferResized = true;
 }
 
+void Engine::keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    auto engine = reinterpret_cast<Engine *>(glfwGetWindowUserPointer(window));
+    if (key == GLFW_KEY_F3 && action == GLFW_PRESS && engine->vRenderer) {
+        engine->vRenderer->getOverlay().toggle();
+    }
+}
+
+std::optional<VkDeviceSize> Engine::deviceLocalBudget() const {
+    std::optional<VkDeviceSize> budget;
+    for (const VDevice::HeapBudget &heap : vDevice->memoryBudget()) {
+        if (heap.deviceLocal) {
+            budget = budget.value_or(0) + heap.budget;
+        }
+    }
+    return budget;
+}
+
+void Engine::createWindow() {
+    glfwInit();
+    glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    window = glfwCreateWindow(static_cast<int>(options.extent.width), static_cast<int>(options.extent.height), "Iro Engine", nullptr, nullptr);
+    glfwSetWindowUserPointer(window, this);
+    glfwSetFramebufferSizeCallback(window, framebufferResizeCallback);
+    glfwSetKeyCallback(window, keyCallback);
+
+    // Load window icon from embedded memory.
+    int iconWidth, iconHeight, iconChannels;
+    unsigned char *pixels = stbi_load_from_memory(iro_engine_icon_png, iro_engine_icon_png_len, &iconWidth, &iconHeight, &iconChannels, STBI_rgb_alpha);
+    if (pixels) {
+        GLFWimage images[1];
+        images[0].width = iconWidth;
+        images[0].height = iconHeight;
+        images[0].pixels = pixels;
+        glfwSetWindowIcon(window, 1, images);
+        stbi_image_free(pixels);
+    } else {
+        std::cerr << "Warning: Could not load window icon from embedded data.\n";
+    }
+}
+
 void Engine::createInstance() {
+    // Request 1.3 when the loader provides it so the device can expose its 1.3 features; 1.2 is the minimum.
+    uint32_t loaderVersion = VK_API_VERSION_1_0;
+    vkEnumerateInstanceVersion(&loaderVersion);
+    apiVersion = loaderVersion >= VK_API_VERSION_1_3 ? VK_API_VERSION_1_3 : VK_API_VERSION_1_2;
+
     VkApplicationInfo appInfo {
         .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
         .pApplicationName = "Iro Engine",
         .applicationVersion = VK_MAKE_VERSION(1, 0, 0),
         .pEngineName = "Iro Engine",
         .engineVersion = VK_MAKE_VERSION(1, 0, 0),
-        .apiVersion = VK_API_VERSION_1_2,
+        .apiVersion = apiVersion,
     };
 
+    // Surface extensions are only needed when there is a window to present to.
     uint32_t glfwExtensionCount = 0;
-    const char **glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    const char **glfwExtensions = options.headless ? nullptr : glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
     VkInstanceCreateInfo createInfo {
         .sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
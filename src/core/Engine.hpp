@@ -1,16 +1,41 @@
 #pragma once
 
 #include "discord/Discord.hpp"
+#include "scene/Scene.hpp"
+#include "scene/SessionLog.hpp"
 #include "ui/UIManager.hpp"
+#include "util/AllocTracker.hpp"
+#include "util/FrameStats.hpp"
 #include "util/JobSystem.hpp"
 #include "vulkan/VDevice.hpp"
+#include "vulkan/VGeometryRegistry.hpp"
 #include "vulkan/VRenderer.hpp"
 #include "vulkan/VSwapChain.hpp"
 #include "vulkan/ThreadCommandResources.hpp"
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 #include <thread>
 
+// Startup options, normally parsed from the command line.
+struct EngineOptions {
+    // Renders to offscreen images without a window, surface or presentation, e.g. for benchmarks and CI.
+    bool headless = false;
+    // Stops after this many frames; 0 runs until the window is closed. Headless runs always stop.
+    uint32_t frameLimit = 0;
+    VkExtent2D extent {800, 600};
+    // Starts with the performance overlay shown; F3 toggles it either way.
+    bool overlay = false;
+    // Records the session's UI edits and size changes to this file, for replay.
+    std::string capturePath;
+    // Replays a captured session headless, over the same scene, instead of running the scene's own update.
+    // The size and, unless set, the frame limit come from the log.
+    std::string replayPath;
+    // What to show; the built-in demo when null.
+    std::unique_ptr<Scene> scene;
+};
+
 // Encapsulates the entire application, managing the window, core components, and the main event loop.
 class Engine {
 
@@ -22,29 +47,66 @@ private:
     void createInstance();
     void createSurface();
 
+    void createWindow();
+    bool shouldClose(uint64_t framesRendered) const;
+    void resize(VkExtent2D extent);
+    // The summed budget of the device-local heaps, or nothing when the device reports none.
+    std::optional<VkDeviceSize> deviceLocalBudget() const;
+
     static void framebufferResizeCallback(GLFWwindow *window, int width, int height);
+    static void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods);
 
-    static constexpr int INITIAL_WIDTH = 800;
-    static constexpr int INITIAL_HEIGHT = 600;
+    static constexpr uint32_t DEFAULT_HEADLESS_FRAMES = 1000;
+    // Where profiling builds write their Chrome trace on exit; iro-trace.json when unset.
+    static constexpr const char *TRACE_PATH_ENV = "IRO_TRACE";
+    // When set, a report of frame-time percentiles is written there on exit (CSV for a .csv path, JSON otherwise).
+    static constexpr const char *FRAME_STATS_ENV = "IRO_FRAME_STATS";
+
+    EngineOptions options;
 
     // --- Core Components ---
-    GLFWwindow *window;
+    GLFWwindow *window = nullptr;
     VkInstance instance;
-    VkSurfaceKHR surface;
+    uint32_t apiVersion = VK_API_VERSION_1_2;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
     std::unique_ptr<Discord> discord;
 
     // --- Vulkan Abstractions ---
     std::unique_ptr<VDevice> vDevice;
+    std::unique_ptr<VGeometryRegistry> vGeometry;
     std::unique_ptr<VSwapChain> vSwapChain;
     std::unique_ptr<VRenderer> vRenderer;
 
     // --- UI Management ---
     std::unique_ptr<UIManager> uiManager;
+    std::unique_ptr<Scene> scene;
+    std::optional<SceneContext> sceneContext;
+    std::unique_ptr<SessionRecorder> recorder;
+
+    // --- Frame Timing ---
+    FrameStats frameStats;
+    VResourceTracker::Snapshot resourceStats;
+#ifdef IRO_TRACK_ALLOCS
+    AllocTracker::FrameAllocations frameAllocations;
+#endif
 
     // --- Thread Management ---
     JobSystem jobSystem;
     std::array<std::vector<ThreadCommandResources>, VSwapChain::MAX_FRAMES_IN_FLIGHT> threadResources;
 
 public:
+    explicit Engine(EngineOptions options = {});
+
     void run();
+
+    // Timings of the frames rendered so far; complete once run() returns.
+    const FrameStats &getFrameStats() const { return frameStats; }
+
+    // Vulkan objects and memory as the frame loop ended, with peaks and per-frame churn; complete once run() returns.
+    const VResourceTracker::Snapshot &getResourceStats() const { return resourceStats; }
+
+#ifdef IRO_TRACK_ALLOCS
+    // Heap allocations per frame, overall and by subsystem; complete once run() returns.
+    const AllocTracker::FrameAllocations &getFrameAllocations() const { return frameAllocations; }
+#endif
 };
@@ -1,5 +1,7 @@
 #define DISCORDPP_IMPLEMENTATION
 #include "Discord.hpp"
+#include "util/AllocTracker.hpp"
+#include "util/Profiler.hpp"
 #include <ctime>
 #include <iostream>
 
@@ -47,5 +49,7 @@ void Discord::init() {
 }
 
 void Discord::update() {
+    IRO_PROFILE_ZONE("Discord::update");
+    IRO_ALLOC_TAG(Discord);
     discordpp::RunCallbacks();
 }
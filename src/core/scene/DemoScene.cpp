@@ -0,0 +1,65 @@
+#include "DemoScene.hpp"
+#include "util/Color.hpp"
+#include <cmath>
+#include <memory>
+
+// The icon's byte array, generated by xxd and compiled separately, doubles as the logo texture.
+extern "C" {
+    extern const unsigned char iro_engine_icon_png[];
+    extern const unsigned int iro_engine_icon_png_len;
+}
+
+void DemoScene::load(SceneContext &context) {
+    auto squareVerts = Primitives::Vertex::create_default_quad();
+
+    squareVerts[0].color = ColorUtil::rgba_to_uint32_aabbggrr({1.0f, 0.0f, 0.0f, 1.0f});
+    squareVerts[1].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 1.0f, 0.0f, 1.0f});
+    squareVerts[2].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 0.0f, 1.0f, 1.0f});
+    squareVerts[3].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 0.0f, 0.0f, 1.0f});
+
+    auto square = std::make_unique<Primitives::Quad>(context.geometry);
+    square->setVertices(squareVerts);
+    square->setPosition({0.70f, 0.0f});
+    square->setScale({0.5f, 0.5f});
+    context.ui.add("square", std::move(square));
+
+    auto triangleVerts = Primitives::Vertex::create_default_triangle();
+
+    triangleVerts[0].color = ColorUtil::rgba_to_uint32_aabbggrr({1.0f, 0.0f, 0.0f, 1.0f});
+    triangleVerts[1].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 1.0f, 0.0f, 1.0f});
+    triangleVerts[2].color = ColorUtil::rgba_to_uint32_aabbggrr({0.0f, 0.0f, 1.0f, 1.0f});
+
+    auto triangle = std::make_unique<Primitives::Triangle>(context.geometry);
+    triangle->setVertices(triangleVerts);
+    triangle->setPosition({-0.75f, 0});
+    triangle->setScale({0.5f, 0.5f});
+    context.ui.add("triangle", std::move(triangle));
+
+    // The logo is decoded in the background like any other texture; until then the sprite is plain white.
+    auto logoTexture = context.renderer.getTextures().load("logo", iro_engine_icon_png, iro_engine_icon_png_len);
+    auto logo = std::make_unique<Primitives::Sprite>(context.geometry, std::move(logoTexture));
+    logo->setPosition({0.0f, 0.55f});
+    logo->setScale({0.3f, 0.3f});
+    context.ui.add("logo", std::move(logo));
+
+    const FontId sans = context.renderer.getTextRenderer().getFonts().load("sans-serif");
+    auto title = std::make_unique<Label>(sans, 32.0f, "Iro Engine");
+    title->setColor(ColorUtil::rgba_to_uint32_aabbggrr({0.1f, 0.1f, 0.1f, 1.0f}));
+    Label *titleLabel = title.get();
+    context.ui.addLabel("title", std::move(title));
+
+    // Layout: the title sits in a fixed-height header inside the padded root.
+    FlexStyle rootStyle {};
+    rootStyle.padding = {24.0f, 24.0f, 24.0f, 24.0f};
+    context.ui.getRoot().setStyle(rootStyle);
+
+    FlexStyle headerStyle {};
+    headerStyle.height = 40.0f;
+    UINode &header = context.ui.getRoot().addChild(std::make_unique<UINode>(headerStyle));
+    header.setLayoutCallback([titleLabel](const UIRect &rect) { titleLabel->setPosition(rect.position); });
+}
+
+void DemoScene::update(SceneContext &context, uint64_t frame, float seconds) {
+    const float s = 0.5f + 0.02f * std::sin(seconds * 5.0f);
+    context.ui.get("triangle")->setScale({s, s});
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "Scene.hpp"
+
+// The showcase: a gradient square, a pulsing triangle, the logo and a title label.
+class DemoScene : public Scene {
+
+public:
+    void load(SceneContext &context) override;
+    void update(SceneContext &context, uint64_t frame, float seconds) override;
+
+};
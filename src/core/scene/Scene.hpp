@@ -0,0 +1,30 @@
+#pragma once
+
+#include "core/ui/UIManager.hpp"
+#include "core/vulkan/VGeometryRegistry.hpp"
+#include "core/vulkan/VRenderer.hpp"
+#include <cstdint>
+#include <functional>
+
+// What a scene can reach while it builds and animates its content.
+struct SceneContext {
+    UIManager &ui;
+    VGeometryRegistry &geometry;
+    VRenderer &renderer;
+    // Asks for a new render size: resizes the window, or the offscreen target when headless.
+    std::function<void(VkExtent2D)> resize;
+};
+
+// The content the engine shows. Without one, the engine runs DemoScene.
+class Scene {
+
+public:
+    virtual ~Scene() = default;
+
+    // Called once, after the renderer is ready and before the first frame.
+    virtual void load(SceneContext &context) = 0;
+
+    // Called at the start of every frame. `seconds` is the time since the main loop started.
+    virtual void update(SceneContext &context, uint64_t frame, float seconds) {}
+
+};
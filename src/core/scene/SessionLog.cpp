@@ -0,0 +1,336 @@
+#include "SessionLog.hpp"
+#include "core/vulkan/VTextureCache.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+using SessionLog::Kind;
+using SessionLog::Op;
+
+namespace {
+
+uint8_t bit(Primitives::Change change) {
+    return static_cast<uint8_t>(1u << static_cast<uint8_t>(change));
+}
+
+Kind kindOf(const Primitives::Primitive &element) {
+    if (dynamic_cast<const Primitives::Sprite *>(&element)) return Kind::Sprite;
+    if (dynamic_cast<const Primitives::Quad *>(&element)) return Kind::Quad;
+    if (dynamic_cast<const Primitives::Triangle *>(&element)) return Kind::Triangle;
+    return Kind::Primitive;
+}
+
+// The header's frame count, patched in when the recorder closes.
+constexpr std::streamoff FRAMES_OFFSET = 4 * sizeof(uint32_t);
+
+// Sprites log their texture by name; an empty name is a sprite without one.
+std::shared_ptr<const VTexture> textureNamed(SceneContext &context, const std::string &name) {
+    return name.empty() ? nullptr : context.renderer.getTextures().load(name);
+}
+
+}
+
+SessionRecorder::SessionRecorder(const std::string &path, VkExtent2D extent, const UIManager &ui)
+    : path(path), out(path, std::ios::binary | std::ios::trunc), extent(extent) {
+    if (!out) {
+        throw std::runtime_error("Cannot write session log '" + path + "'.");
+    }
+
+    write(SessionLog::MAGIC);
+    write(SessionLog::VERSION);
+    write(extent.width);
+    write(extent.height);
+    write(frames);
+
+    for (const auto &[name, element] : ui.getElements()) {
+        const uint32_t id = nextId++;
+        tracked[element.get()] = {id, 0, element->getTexture()};
+        writeOp(Op::Bind, id);
+        writeString(name);
+    }
+    write(Op::End);
+}
+
+SessionRecorder::~SessionRecorder() {
+    out.seekp(FRAMES_OFFSET);
+    write(frames);
+}
+
+void SessionRecorder::writeOp(Op op, uint32_t id) {
+    write(op);
+    write(id);
+}
+
+void SessionRecorder::writeString(const std::string &value) {
+    write(static_cast<uint32_t>(value.size()));
+    out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+void SessionRecorder::writeVec2(const glm::vec2 &value) {
+    write(value.x);
+    write(value.y);
+}
+
+// Field by field, so the log does not depend on Vertex's padding.
+void SessionRecorder::writeVertices(const std::vector<Primitives::Vertex> &vertices) {
+    write(static_cast<uint32_t>(vertices.size()));
+    for (const auto &vertex : vertices) {
+        writeVec2(vertex.position);
+        write(vertex.color);
+    }
+}
+
+void SessionRecorder::writeIndices(const std::vector<uint32_t> &indices) {
+    write(static_cast<uint32_t>(indices.size()));
+    out.write(reinterpret_cast<const char *>(indices.data()), static_cast<std::streamsize>(indices.size() * sizeof(uint32_t)));
+}
+
+void SessionRecorder::elementAdded(const std::string &name, Primitives::Primitive &element) {
+    const uint32_t id = nextId++;
+    tracked[&element] = {id, 0, element.getTexture()};
+
+    // Written whole and at once, so edits later in the frame apply on top of it in replay.
+    const Kind kind = kindOf(element);
+    writeOp(Op::Add, id);
+    writeString(name);
+    write(kind);
+    if (kind == Kind::Sprite) {
+        writeString(element.getTexture() ? element.getTexture()->getName() : std::string());
+    }
+    writeVertices(element.getVertices());
+    writeIndices(element.getIndices());
+    writeVec2(element.getTransform().position);
+    writeVec2(element.getTransform().scale);
+}
+
+void SessionRecorder::elementRemoved(const std::string &name, Primitives::Primitive &element) {
+    auto it = tracked.find(&element);
+    if (it == tracked.end()) {
+        return;
+    }
+
+    writeOp(Op::Remove, it->second.id);
+    if (it->second.changes) {
+        touched.erase(std::find(touched.begin(), touched.end(), &element));
+    }
+    tracked.erase(it);
+}
+
+void SessionRecorder::elementChanged(Primitives::Primitive &element, Primitives::Change change) {
+    auto it = tracked.find(&element);
+    if (it == tracked.end()) {
+        return;
+    }
+
+    // Texture notifications also come from loads completing, which replay reproduces by itself.
+    if (change == Primitives::Change::Texture && element.getTexture() == it->second.texture) {
+        return;
+    }
+
+    if (!it->second.changes) {
+        touched.push_back(&element);
+    }
+    it->second.changes |= bit(change);
+}
+
+void SessionRecorder::endFrame(VkExtent2D newExtent) {
+    if (newExtent.width != extent.width || newExtent.height != extent.height) {
+        extent = newExtent;
+        write(Op::Extent);
+        write(extent.width);
+        write(extent.height);
+    }
+
+    for (const Primitives::Primitive *element : touched) {
+        Tracked &state = tracked.at(element);
+        if (state.changes & bit(Primitives::Change::Position)) {
+            writeOp(Op::Position, state.id);
+            writeVec2(element->getTransform().position);
+        }
+        if (state.changes & bit(Primitives::Change::Scale)) {
+            writeOp(Op::Scale, state.id);
+            writeVec2(element->getTransform().scale);
+        }
+        if (state.changes & bit(Primitives::Change::Vertices)) {
+            writeOp(Op::Vertices, state.id);
+            writeVertices(element->getVertices());
+        }
+        if (state.changes & bit(Primitives::Change::Indices)) {
+            writeOp(Op::Indices, state.id);
+            writeIndices(element->getIndices());
+        }
+        if (state.changes & bit(Primitives::Change::Texture)) {
+            state.texture = element->getTexture();
+            writeOp(Op::Texture, state.id);
+            writeString(state.texture ? state.texture->getName() : std::string());
+        }
+        state.changes = 0;
+    }
+    touched.clear();
+
+    write(Op::End);
+    ++frames;
+}
+
+template <typename T>
+T ReplayScene::read() {
+    if (log.size() - cursor < sizeof(T)) {
+        throw std::runtime_error("Session log '" + path + "' is truncated.");
+    }
+    T value;
+    std::memcpy(&value, log.data() + cursor, sizeof(T));
+    cursor += sizeof(T);
+    return value;
+}
+
+ReplayScene::ReplayScene(const std::string &path, std::unique_ptr<Scene> scene) : scene(std::move(scene)), path(path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot read session log '" + path + "'.");
+    }
+    log.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    if (read<uint32_t>() != SessionLog::MAGIC) {
+        throw std::runtime_error("'" + path + "' is not a session log.");
+    }
+    const uint32_t version = read<uint32_t>();
+    if (version != SessionLog::VERSION) {
+        throw std::runtime_error("Session log '" + path + "' has version " + std::to_string(version) + ", expected " +
+                                 std::to_string(SessionLog::VERSION) + ".");
+    }
+    extent.width = read<uint32_t>();
+    extent.height = read<uint32_t>();
+    frames = read<uint32_t>();
+}
+
+std::string ReplayScene::readString() {
+    const uint32_t size = read<uint32_t>();
+    if (log.size() - cursor < size) {
+        throw std::runtime_error("Session log '" + path + "' is truncated.");
+    }
+    std::string value(log.data() + cursor, size);
+    cursor += size;
+    return value;
+}
+
+glm::vec2 ReplayScene::readVec2() {
+    const float x = read<float>();
+    return {x, read<float>()};
+}
+
+std::vector<Primitives::Vertex> ReplayScene::readVertices() {
+    // A position and a color each; checked before sizing, so a corrupt count cannot ask for gigabytes.
+    const uint32_t count = read<uint32_t>();
+    if ((log.size() - cursor) / (2 * sizeof(float) + sizeof(uint32_t)) < count) {
+        throw std::runtime_error("Session log '" + path + "' is truncated.");
+    }
+    std::vector<Primitives::Vertex> vertices(count);
+    for (auto &vertex : vertices) {
+        vertex.position = readVec2();
+        vertex.color = read<uint32_t>();
+    }
+    return vertices;
+}
+
+std::vector<uint32_t> ReplayScene::readIndices() {
+    const uint32_t count = read<uint32_t>();
+    if ((log.size() - cursor) / sizeof(uint32_t) < count) {
+        throw std::runtime_error("Session log '" + path + "' is truncated.");
+    }
+    std::vector<uint32_t> indices(count);
+    for (auto &index : indices) {
+        index = read<uint32_t>();
+    }
+    return indices;
+}
+
+Primitives::Primitive &ReplayScene::element(uint32_t id) {
+    if (id >= elements.size() || !elements[id]) {
+        throw std::runtime_error("Session log '" + path + "' refers to unknown element " + std::to_string(id) + ".");
+    }
+    return *elements[id];
+}
+
+void ReplayScene::load(SceneContext &context) {
+    scene->load(context);
+
+    // Ids are handed out in order, so each one is the next slot.
+    while (read<Op>() == Op::Bind) {
+        read<uint32_t>();
+        const std::string name = readString();
+        elements.push_back(context.ui.get(name));
+        names.push_back(name);
+    }
+}
+
+void ReplayScene::update(SceneContext &context, uint64_t frame, float seconds) {
+    if (cursor == log.size()) {
+        return;
+    }
+
+    for (Op op = read<Op>(); op != Op::End; op = read<Op>()) {
+        if (op == Op::Extent) {
+            const uint32_t width = read<uint32_t>();
+            context.resize({width, read<uint32_t>()});
+            continue;
+        }
+
+        const uint32_t id = read<uint32_t>();
+        switch (op) {
+            case Op::Add: {
+                const std::string name = readString();
+                const Kind kind = read<Kind>();
+                const std::string texture = kind == Kind::Sprite ? readString() : std::string();
+                const std::vector<Primitives::Vertex> vertices = readVertices();
+                const std::vector<uint32_t> indices = readIndices();
+
+                std::unique_ptr<Primitives::Primitive> added;
+                switch (kind) {
+                    case Kind::Sprite: {
+                        auto sprite = std::make_unique<Primitives::Sprite>(context.geometry, textureNamed(context, texture));
+                        sprite->setVertices(vertices);
+                        added = std::move(sprite);
+                        break;
+                    }
+                    case Kind::Quad: added = std::make_unique<Primitives::Quad>(context.geometry, vertices); break;
+                    case Kind::Triangle: added = std::make_unique<Primitives::Triangle>(context.geometry, vertices); break;
+                    default: added = std::make_unique<Primitives::Primitive>(context.geometry, vertices, indices); break;
+                }
+                if (added->getIndices() != indices) {
+                    added->setIndices(indices);
+                }
+                added->setPosition(readVec2());
+                added->setScale(readVec2());
+
+                if (id >= elements.size()) {
+                    elements.resize(id + 1, nullptr);
+                    names.resize(id + 1);
+                }
+                elements[id] = added.get();
+                names[id] = name;
+                context.ui.add(name, std::move(added));
+                break;
+            }
+            case Op::Remove:
+                element(id);
+                context.ui.remove(names[id]);
+                elements[id] = nullptr;
+                break;
+            case Op::Position: element(id).setPosition(readVec2()); break;
+            case Op::Scale: element(id).setScale(readVec2()); break;
+            case Op::Vertices: element(id).setVertices(readVertices()); break;
+            case Op::Indices: element(id).setIndices(readIndices()); break;
+            case Op::Texture: {
+                auto *sprite = dynamic_cast<Primitives::Sprite *>(&element(id));
+                const std::string texture = readString();
+                if (sprite) {
+                    sprite->setTexture(textureNamed(context, texture));
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Session log '" + path + "' is corrupt.");
+        }
+    }
+}
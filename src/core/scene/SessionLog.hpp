@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Scene.hpp"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VTexture;
+
+// A compact binary record of what a session did to the UI, frame by frame, so it can be replayed headless at
+// full speed and give frame times that are comparable between builds.
+//
+// In host byte order: a header (magic, version, starting extent, frame count), a table binding ids to the
+// elements the scene loaded, then the records of each frame, each frame closed by End. Edits are coalesced
+// per frame: an element moved ten times in one update is stored once, at its final position.
+namespace SessionLog {
+
+constexpr uint32_t MAGIC = 0x50435249; // "IRCP"
+constexpr uint32_t VERSION = 1;
+
+enum class Op : uint8_t { End, Bind, Add, Remove, Position, Scale, Vertices, Indices, Texture, Extent };
+enum class Kind : uint8_t { Primitive, Triangle, Quad, Sprite };
+
+}
+
+// Captures a session while it runs. Install it as the UI's observer once the scene has loaded; loading itself
+// is not recorded, because replay loads the same scene.
+class SessionRecorder : public UIObserver {
+
+private:
+    struct Tracked {
+        uint32_t id;
+        uint8_t changes = 0; // One bit per Primitives::Change made this frame.
+        const VTexture *texture = nullptr;
+    };
+
+    template <typename T>
+    void write(const T &value) { out.write(reinterpret_cast<const char *>(&value), sizeof(T)); }
+    void writeOp(SessionLog::Op op, uint32_t id);
+    void writeString(const std::string &value);
+    void writeVec2(const glm::vec2 &value);
+    void writeVertices(const std::vector<Primitives::Vertex> &vertices);
+    void writeIndices(const std::vector<uint32_t> &indices);
+
+    std::string path;
+    std::ofstream out;
+    uint32_t frames = 0;
+    VkExtent2D extent;
+    uint32_t nextId = 0;
+    std::unordered_map<const Primitives::Primitive *, Tracked> tracked;
+    // Elements edited this frame, in the order of their first edit.
+    std::vector<const Primitives::Primitive *> touched;
+
+
+public:
+    // Starts the log at `path` with the elements `ui` holds now. Throws if the file cannot be written.
+    SessionRecorder(const std::string &path, VkExtent2D extent, const UIManager &ui);
+    // Completes the header, so a log is only valid once its recorder is gone.
+    ~SessionRecorder();
+
+    SessionRecorder(const SessionRecorder &) = delete;
+    SessionRecorder &operator=(const SessionRecorder &) = delete;
+
+    // Closes the frame, after the scene's update and once `extent` reflects any resize it asked for.
+    void endFrame(VkExtent2D extent);
+
+    uint32_t getFrames() const { return frames; }
+    const std::string &getPath() const { return path; }
+
+    void elementAdded(const std::string &name, Primitives::Primitive &element) override;
+    void elementRemoved(const std::string &name, Primitives::Primitive &element) override;
+    void elementChanged(Primitives::Primitive &element, Primitives::Change change) override;
+
+};
+
+// Replays a log over the scene it was captured from: the scene loads as usual, then every frame applies the
+// recorded edits in place of the scene's own update. Frames past the end of the log change nothing.
+class ReplayScene : public Scene {
+
+private:
+    template <typename T>
+    T read();
+    std::string readString();
+    glm::vec2 readVec2();
+    std::vector<Primitives::Vertex> readVertices();
+    std::vector<uint32_t> readIndices();
+    Primitives::Primitive &element(uint32_t id);
+
+    std::unique_ptr<Scene> scene;
+    std::string path;
+    std::vector<char> log;
+    std::size_t cursor = 0;
+    VkExtent2D extent;
+    uint32_t frames = 0;
+    // By id; null once removed.
+    std::vector<Primitives::Primitive *> elements;
+    std::vector<std::string> names;
+
+
+public:
+    // Reads the whole log up front, so replay never touches the disk. Throws if it is missing or not a log.
+    ReplayScene(const std::string &path, std::unique_ptr<Scene> scene);
+
+    // The size the capture started at, and how many frames it holds.
+    VkExtent2D getExtent() const { return extent; }
+    uint32_t getFrames() const { return frames; }
+
+    void load(SceneContext &context) override;
+    void update(SceneContext &context, uint64_t frame, float seconds) override;
+
+};
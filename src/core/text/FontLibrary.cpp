@@ -0,0 +1,221 @@
+#include "FontLibrary.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+
+#ifdef __linux__
+#include <fontconfig/fontconfig.h>
+#endif
+
+namespace {
+
+constexpr float INF = 1e20f;
+
+// One-dimensional squared Euclidean distance transform (Felzenszwalb & Huttenlocher).
+void distanceTransform1D(float *grid, std::size_t offset, std::size_t stride, std::size_t length,
+                         std::vector<float> &f, std::vector<uint16_t> &v, std::vector<float> &z) {
+    v[0] = 0;
+    z[0] = -INF;
+    z[1] = INF;
+    for (std::size_t q = 0; q < length; ++q) {
+        f[q] = grid[offset + q * stride];
+    }
+
+    std::size_t k = 0;
+    for (std::size_t q = 1; q < length; ++q) {
+        float s;
+        while (true) {
+            const std::size_t r = v[k];
+            s = (f[q] - f[r] + static_cast<float>(q * q) - static_cast<float>(r * r)) / static_cast<float>(2 * (q - r));
+            if (s > z[k] || k == 0) break;
+            --k;
+        }
+
+        ++k;
+        v[k] = static_cast<uint16_t>(q);
+        z[k] = s;
+        z[k + 1] = INF;
+    }
+
+    k = 0;
+    for (std::size_t q = 0; q < length; ++q) {
+        while (z[k + 1] < static_cast<float>(q)) ++k;
+        const std::size_t r = v[k];
+        const float d = static_cast<float>(q) - static_cast<float>(r);
+        grid[offset + q * stride] = f[r] + d * d;
+    }
+}
+
+void distanceTransform2D(std::vector<float> &grid, std::size_t width, std::size_t height) {
+    const std::size_t longest = std::max(width, height);
+    std::vector<float> f(longest);
+    std::vector<uint16_t> v(longest);
+    std::vector<float> z(longest + 1);
+
+    for (std::size_t x = 0; x < width; ++x) distanceTransform1D(grid.data(), x, width, height, f, v, z);
+    for (std::size_t y = 0; y < height; ++y) distanceTransform1D(grid.data(), y * width, 1, width, f, v, z);
+}
+
+// Converts an antialiased coverage bitmap into a distance field. Partially covered pixels seed
+// sub-pixel distances, so the field is smooth even though it is built from a raster.
+void buildDistanceField(const FT_Bitmap &bitmap, GlyphBitmap &glyph) {
+    const std::size_t spread = FontLibrary::SDF_SPREAD;
+    const std::size_t width = bitmap.width + 2 * spread;
+    const std::size_t height = bitmap.rows + 2 * spread;
+
+    std::vector<float> outer(width * height, INF);
+    std::vector<float> inner(width * height, 0.0f);
+
+    for (std::size_t y = 0; y < bitmap.rows; ++y) {
+        for (std::size_t x = 0; x < bitmap.width; ++x) {
+            const float coverage = bitmap.buffer[y * bitmap.pitch + x] / 255.0f;
+            if (coverage == 0.0f) continue;
+
+            const std::size_t i = (y + spread) * width + (x + spread);
+            if (coverage == 1.0f) {
+                outer[i] = 0.0f;
+                inner[i] = INF;
+            } else {
+                const float d = 0.5f - coverage;
+                outer[i] = d > 0.0f ? d * d : 0.0f;
+                inner[i] = d < 0.0f ? d * d : 0.0f;
+            }
+        }
+    }
+
+    distanceTransform2D(outer, width, height);
+    distanceTransform2D(inner, width, height);
+
+    // 0.5 sits on the outline; values rise towards the inside and reach 1.0 one spread deep.
+    glyph.width = static_cast<uint32_t>(width);
+    glyph.height = static_cast<uint32_t>(height);
+    glyph.pixels.resize(width * height);
+    for (std::size_t i = 0; i < width * height; ++i) {
+        const float distance = std::sqrt(outer[i]) - std::sqrt(inner[i]);
+        const float value = std::clamp(0.5f - distance / (2.0f * spread), 0.0f, 1.0f);
+        glyph.pixels[i] = static_cast<uint8_t>(std::lround(value * 255.0f));
+    }
+}
+
+// Per-thread FreeType state. FT_Face objects must not be shared between threads.
+struct ThreadFaces {
+    FT_Library library = nullptr;
+    std::unordered_map<std::string, FT_Face> faces;
+
+    ThreadFaces() {
+        if (FT_Init_FreeType(&library) != 0) {
+            throw std::runtime_error("Failed to initialize FreeType.");
+        }
+    }
+
+    ~ThreadFaces() {
+        for (auto &[key, face] : faces) FT_Done_Face(face);
+        FT_Done_FreeType(library);
+    }
+
+    FT_Face get(const FontFile &file) {
+        const std::string key = file.path + '#' + std::to_string(file.index);
+        auto it = faces.find(key);
+        if (it != faces.end()) return it->second;
+
+        FT_Face face;
+        if (FT_New_Face(library, file.path.c_str(), file.index, &face) != 0) {
+            throw std::runtime_error("Failed to open font: " + file.path);
+        }
+        FT_Set_Pixel_Sizes(face, 0, FontLibrary::BASE_SIZE);
+        faces.emplace(key, face);
+        return face;
+    }
+};
+
+} // namespace
+
+FontLibrary::FontLibrary() {
+    if (FT_Init_FreeType(&library) != 0) {
+        throw std::runtime_error("Failed to initialize FreeType.");
+    }
+}
+
+FontLibrary::~FontLibrary() {
+    FT_Done_FreeType(library);
+}
+
+FontId FontLibrary::load(const std::string &pattern) {
+    auto it = byPattern.find(pattern);
+    if (it != byPattern.end()) {
+        return it->second;
+    }
+
+    FontFile file {};
+
+    #ifdef __linux__
+    FcPattern *query = FcNameParse(reinterpret_cast<const FcChar8 *>(pattern.c_str()));
+    FcConfigSubstitute(nullptr, query, FcMatchPattern);
+    FcDefaultSubstitute(query);
+
+    FcResult result;
+    FcPattern *match = FcFontMatch(nullptr, query, &result);
+    FcPatternDestroy(query);
+
+    FcChar8 *path = nullptr;
+    if (!match || FcPatternGetString(match, FC_FILE, 0, &path) != FcResultMatch) {
+        if (match) FcPatternDestroy(match);
+        throw std::runtime_error("No font matches pattern: " + pattern);
+    }
+
+    file.path = reinterpret_cast<const char *>(path);
+    FcPatternGetInteger(match, FC_INDEX, 0, &file.index);
+    FcPatternDestroy(match);
+    #else
+    file.path = pattern;
+    #endif
+
+    FT_Face face;
+    if (FT_New_Face(library, file.path.c_str(), file.index, &face) != 0) {
+        throw std::runtime_error("Failed to open font: " + file.path);
+    }
+    FT_Set_Pixel_Sizes(face, 0, BASE_SIZE);
+
+    // Size metrics are in 26.6 fixed point.
+    FontMetrics fontMetrics {
+        .ascender = face->size->metrics.ascender / 64.0f,
+        .descender = face->size->metrics.descender / 64.0f,
+        .lineHeight = face->size->metrics.height / 64.0f,
+    };
+    FT_Done_Face(face);
+
+    const FontId id = static_cast<FontId>(files.size());
+    files.push_back(file);
+    metrics.push_back(fontMetrics);
+    byPattern.emplace(pattern, id);
+
+    return id;
+}
+
+GlyphBitmap FontLibrary::rasterize(const FontFile &file, char32_t codepoint) {
+    thread_local ThreadFaces threadFaces;
+    FT_Face face = threadFaces.get(file);
+
+    GlyphBitmap glyph {};
+    const FT_UInt glyphIndex = FT_Get_Char_Index(face, codepoint);
+    if (FT_Load_Glyph(face, glyphIndex, FT_LOAD_RENDER) != 0) {
+        return glyph;
+    }
+
+    const FT_GlyphSlot slot = face->glyph;
+    glyph.advance = slot->advance.x / 64.0f;
+
+    if (slot->bitmap.width == 0 || slot->bitmap.rows == 0) {
+        return glyph;
+    }
+
+    buildDistanceField(slot->bitmap, glyph);
+    glyph.bearingX = static_cast<float>(slot->bitmap_left) - static_cast<float>(SDF_SPREAD);
+    glyph.bearingY = -static_cast<float>(slot->bitmap_top) - static_cast<float>(SDF_SPREAD);
+    return glyph;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef struct FT_LibraryRec_ *FT_Library;
+
+using FontId = uint32_t;
+
+// Where a font lives on disk; enough for any thread to open its own FreeType face.
+struct FontFile {
+    std::string path;
+    int index = 0;
+};
+
+// Line metrics in pixels at FontLibrary::BASE_SIZE.
+struct FontMetrics {
+    float ascender = 0.0f;
+    float descender = 0.0f;
+    float lineHeight = 0.0f;
+};
+
+// A glyph rendered as a signed distance field at FontLibrary::BASE_SIZE, plus its placement metrics.
+struct GlyphBitmap {
+    std::vector<uint8_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    float bearingX = 0.0f; // Pen position to the left edge of the bitmap.
+    float bearingY = 0.0f; // Baseline to the top edge of the bitmap, negative upwards.
+    float advance = 0.0f;
+};
+
+// Discovers fonts through fontconfig and rasterizes their glyphs into distance fields with FreeType.
+class FontLibrary {
+
+private:
+    FT_Library library = nullptr;
+    std::vector<FontFile> files;
+    std::vector<FontMetrics> metrics;
+    std::unordered_map<std::string, FontId> byPattern;
+
+
+public:
+    // All glyphs are rasterized once at this em size and scaled in the shader.
+    static constexpr uint32_t BASE_SIZE = 32;
+    // Distance, in pixels, the field extends on either side of the outline.
+    static constexpr uint32_t SDF_SPREAD = 4;
+
+    FontLibrary();
+    ~FontLibrary();
+
+    FontLibrary(const FontLibrary &) = delete;
+    FontLibrary &operator=(const FontLibrary &) = delete;
+
+    // Resolves a fontconfig pattern such as "sans-serif" or "DejaVu Sans:bold"; repeated patterns return the same id.
+    FontId load(const std::string &pattern);
+
+    const FontFile &getFile(FontId font) const { return files.at(font); }
+    const FontMetrics &getMetrics(FontId font) const { return metrics.at(font); }
+
+    // Safe to call from any thread; each thread keeps its own FreeType library and faces.
+    static GlyphBitmap rasterize(const FontFile &file, char32_t codepoint);
+
+};
@@ -0,0 +1,297 @@
+#include "GlyphAtlas.hpp"
+#include "core/vulkan/VBuffer.hpp"
+#include "core/vulkan/VImage.hpp"
+#include "core/vulkan/VStagingRing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// Bilinearly resamples a bitmap that does not fit in a slot down to one that does, keeping its aspect ratio.
+// Distance fields survive resampling: the outline stays where the field crosses the midpoint.
+GlyphBitmap fitToSlot(const GlyphBitmap &bitmap, uint32_t slotSize) {
+    const float scale = static_cast<float>(slotSize) / static_cast<float>(std::max(bitmap.width, bitmap.height));
+    GlyphBitmap fitted = bitmap;
+    fitted.width = std::clamp(static_cast<uint32_t>(static_cast<float>(bitmap.width) * scale), 1u, slotSize);
+    fitted.height = std::clamp(static_cast<uint32_t>(static_cast<float>(bitmap.height) * scale), 1u, slotSize);
+    fitted.pixels.assign(fitted.width * fitted.height, 0);
+
+    auto at = [&](uint32_t x, uint32_t y) { return static_cast<float>(bitmap.pixels[y * bitmap.width + x]); };
+    for (uint32_t y = 0; y < fitted.height; ++y) {
+        const float sourceY = std::clamp((static_cast<float>(y) + 0.5f) / scale - 0.5f, 0.0f, static_cast<float>(bitmap.height - 1));
+        const uint32_t y0 = static_cast<uint32_t>(sourceY);
+        const uint32_t y1 = std::min(y0 + 1, bitmap.height - 1);
+        const float fy = sourceY - static_cast<float>(y0);
+
+        for (uint32_t x = 0; x < fitted.width; ++x) {
+            const float sourceX = std::clamp((static_cast<float>(x) + 0.5f) / scale - 0.5f, 0.0f, static_cast<float>(bitmap.width - 1));
+            const uint32_t x0 = static_cast<uint32_t>(sourceX);
+            const uint32_t x1 = std::min(x0 + 1, bitmap.width - 1);
+            const float fx = sourceX - static_cast<float>(x0);
+
+            const float top = at(x0, y0) + (at(x1, y0) - at(x0, y0)) * fx;
+            const float bottom = at(x0, y1) + (at(x1, y1) - at(x0, y1)) * fx;
+            fitted.pixels[y * fitted.width + x] = static_cast<uint8_t>(std::lround(top + (bottom - top) * fy));
+        }
+    }
+    return fitted;
+}
+
+}
+
+GlyphAtlas::GlyphAtlas(VDevice &device) : vDevice(device), pixels(SIZE * SIZE, 0) {
+    freeSlots.reserve(SLOT_COUNT);
+    regions.reserve(MAX_UPLOADS_PER_BATCH);
+    for (int32_t slot = SOLID_SLOT - 1; slot >= 0; --slot) {
+        freeSlots.push_back(slot);
+    }
+
+    GlyphBitmap solid {
+        .pixels = std::vector<uint8_t>(SLOT_SIZE * SLOT_SIZE, 0xFF),
+        .width = SLOT_SIZE,
+        .height = SLOT_SIZE,
+    };
+    writeSlot(SOLID_SLOT, solid);
+
+    stagingBuffer = std::make_unique<VBuffer>(
+        vDevice,
+        SLOT_BYTES,
+        MAX_UPLOADS_PER_BATCH,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    stagingBuffer->map();
+
+    createImage();
+
+    VkSamplerCreateInfo samplerInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxAnisotropy = 1.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+    };
+
+    if (vkCreateSampler(vDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create glyph atlas sampler.");
+    }
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    vkDestroySampler(vDevice.device(), sampler, nullptr);
+}
+
+VkImageView GlyphAtlas::getImageView() const {
+    return image->getView();
+}
+
+void GlyphAtlas::createImage() {
+    image = std::make_unique<VImage>(
+        vDevice,
+        VkExtent2D{SIZE, SIZE},
+        VK_FORMAT_R8_UNORM,
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+    );
+
+    VkCommandBuffer commandBuffer = vDevice.beginSingleTimeCommands();
+    image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    VkClearColorValue clear {};
+    VkImageSubresourceRange range {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    vkCmdClearColorImage(commandBuffer, image->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &range);
+
+    image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    vDevice.endSingleTimeCommands(commandBuffer);
+}
+
+bool GlyphAtlas::touch(uint64_t key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+
+    Entry &entry = it->second;
+    entry.lastUsedFrame = frame;
+    if (entry.slot < 0) {
+        // Either an empty glyph that never needs a slot, or one whose pixels were evicted.
+        return entry.metrics.size.x == 0.0f;
+    }
+
+    lru.splice(lru.begin(), lru, entry.lru);
+    return true;
+}
+
+void GlyphAtlas::evict(uint64_t key) {
+    Entry &entry = entries.at(key);
+    freeSlots.push_back(entry.slot);
+    lru.erase(entry.lru);
+    entry.slot = -1;
+}
+
+bool GlyphAtlas::insert(uint64_t key, const GlyphBitmap &bitmap) {
+    Entry &entry = entries[key];
+    entry.lastUsedFrame = frame;
+    entry.metrics = GlyphMetrics {
+        .size = {static_cast<float>(bitmap.width), static_cast<float>(bitmap.height)},
+        .bearing = {bitmap.bearingX, bitmap.bearingY},
+        .advance = bitmap.advance,
+    };
+
+    if (bitmap.pixels.empty() || entry.slot >= 0) {
+        return true;
+    }
+
+    if (freeSlots.empty()) {
+        const uint64_t victim = lru.back();
+        if (entries.at(victim).lastUsedFrame == frame) {
+            if (!overflowReported) {
+                std::cerr << "Warning: glyph atlas is full; some text will not be drawn this frame.\n";
+                overflowReported = true;
+            }
+            return false;
+        }
+        evict(victim);
+    }
+
+    entry.slot = freeSlots.back();
+    freeSlots.pop_back();
+    lru.push_front(key);
+    entry.lru = lru.begin();
+    ++generation;
+
+    // Wide CJK, emoji and italic glyphs can outgrow a slot. They are stored smaller and drawn at full size,
+    // rather than clipped, and their region covers exactly what was stored.
+    if (bitmap.width > SLOT_SIZE || bitmap.height > SLOT_SIZE) {
+        const GlyphBitmap fitted = fitToSlot(bitmap, SLOT_SIZE);
+        entry.texels = {static_cast<float>(fitted.width), static_cast<float>(fitted.height)};
+        writeSlot(entry.slot, fitted);
+    } else {
+        entry.texels = entry.metrics.size;
+        writeSlot(entry.slot, bitmap);
+    }
+    return true;
+}
+
+void GlyphAtlas::writeSlot(int32_t slot, const GlyphBitmap &bitmap) {
+    const uint32_t originX = (slot % SLOTS_PER_ROW) * SLOT_SIZE;
+    const uint32_t originY = (slot / SLOTS_PER_ROW) * SLOT_SIZE;
+    // Callers fit oversized bitmaps first; the clamp only guards the neighbouring slots.
+    const uint32_t width = std::min(bitmap.width, SLOT_SIZE);
+    const uint32_t height = std::min(bitmap.height, SLOT_SIZE);
+
+    for (uint32_t y = 0; y < SLOT_SIZE; ++y) {
+        uint8_t *row = &pixels[(originY + y) * SIZE + originX];
+        std::memset(row, 0, SLOT_SIZE);
+        if (y < height) {
+            std::memcpy(row, &bitmap.pixels[y * bitmap.width], width);
+        }
+    }
+
+    dirtySlots.push_back(slot);
+}
+
+const GlyphMetrics *GlyphAtlas::findMetrics(uint64_t key) const {
+    auto it = entries.find(key);
+    return it == entries.end() ? nullptr : &it->second.metrics;
+}
+
+bool GlyphAtlas::findRegion(uint64_t key, glm::vec4 &uv) const {
+    auto it = entries.find(key);
+    if (it == entries.end() || it->second.slot < 0) {
+        return false;
+    }
+
+    const Entry &entry = it->second;
+    const float x = static_cast<float>((entry.slot % SLOTS_PER_ROW) * SLOT_SIZE);
+    const float y = static_cast<float>((entry.slot / SLOTS_PER_ROW) * SLOT_SIZE);
+    uv = glm::vec4(x / SIZE, y / SIZE, (x + entry.texels.x) / SIZE, (y + entry.texels.y) / SIZE);
+    return true;
+}
+
+glm::vec4 GlyphAtlas::solidRegion() const {
+    // Inset by a quarter slot so linear filtering never reaches the neighbouring slots.
+    const float x = static_cast<float>((SOLID_SLOT % SLOTS_PER_ROW) * SLOT_SIZE + SLOT_SIZE / 4);
+    const float y = static_cast<float>((SOLID_SLOT / SLOTS_PER_ROW) * SLOT_SIZE + SLOT_SIZE / 4);
+    const float size = static_cast<float>(SLOT_SIZE / 2);
+    return glm::vec4(x / SIZE, y / SIZE, (x + size) / SIZE, (y + size) / SIZE);
+}
+
+void GlyphAtlas::copySlot(int32_t slot, uint8_t *destination) const {
+    const uint32_t originX = (slot % SLOTS_PER_ROW) * SLOT_SIZE;
+    const uint32_t originY = (slot / SLOTS_PER_ROW) * SLOT_SIZE;
+    for (uint32_t y = 0; y < SLOT_SIZE; ++y) {
+        std::memcpy(destination + y * SLOT_SIZE, &pixels[(originY + y) * SIZE + originX], SLOT_SIZE);
+    }
+}
+
+void GlyphAtlas::upload(VkCommandBuffer commandBuffer, VStagingRing &stagingRing) {
+    if (dirtySlots.empty()) {
+        return;
+    }
+
+    std::sort(dirtySlots.begin(), dirtySlots.end());
+    dirtySlots.erase(std::unique(dirtySlots.begin(), dirtySlots.end()), dirtySlots.end());
+
+    auto staging = stagingRing.allocate(dirtySlots.size() * SLOT_BYTES, 16);
+    if (!staging) {
+        // Drawing glyphs whose pixels never arrived would be worse than one stall.
+        std::cerr << "Warning: the staging ring is full; glyphs were uploaded synchronously.\n";
+        uploadImmediately();
+        return;
+    }
+
+    regions.clear();
+    auto *data = static_cast<uint8_t *>(staging->data);
+    for (std::size_t i = 0; i < dirtySlots.size(); ++i) {
+        const int32_t slot = dirtySlots[i];
+        copySlot(slot, data + i * SLOT_BYTES);
+        regions.push_back(VkBufferImageCopy {
+            .bufferOffset = staging->offset + i * SLOT_BYTES,
+            .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+            .imageOffset = {static_cast<int32_t>((slot % SLOTS_PER_ROW) * SLOT_SIZE), static_cast<int32_t>((slot / SLOTS_PER_ROW) * SLOT_SIZE), 0},
+            .imageExtent = {SLOT_SIZE, SLOT_SIZE, 1},
+        });
+    }
+
+    image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vkCmdCopyBufferToImage(commandBuffer, staging->buffer, image->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()), regions.data());
+    image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    dirtySlots.clear();
+}
+
+void GlyphAtlas::uploadImmediately() {
+    auto *staging = static_cast<uint8_t *>(stagingBuffer->getMappedMemory());
+    for (std::size_t batchStart = 0; batchStart < dirtySlots.size(); batchStart += MAX_UPLOADS_PER_BATCH) {
+        const std::size_t batchEnd = std::min(dirtySlots.size(), batchStart + MAX_UPLOADS_PER_BATCH);
+        regions.clear();
+
+        for (std::size_t i = batchStart; i < batchEnd; ++i) {
+            const int32_t slot = dirtySlots[i];
+            const VkDeviceSize offset = (i - batchStart) * SLOT_BYTES;
+            copySlot(slot, staging + offset);
+            regions.push_back(VkBufferImageCopy {
+                .bufferOffset = offset,
+                .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+                .imageOffset = {static_cast<int32_t>((slot % SLOTS_PER_ROW) * SLOT_SIZE), static_cast<int32_t>((slot / SLOTS_PER_ROW) * SLOT_SIZE), 0},
+                .imageExtent = {SLOT_SIZE, SLOT_SIZE, 1},
+            });
+        }
+
+        VkCommandBuffer commandBuffer = vDevice.beginSingleTimeCommands();
+        image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->getBuffer(), image->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               static_cast<uint32_t>(regions.size()), regions.data());
+        image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        vDevice.endSingleTimeCommands(commandBuffer);
+    }
+
+    dirtySlots.clear();
+}
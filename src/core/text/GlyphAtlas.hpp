@@ -0,0 +1,108 @@
+#pragma once
+
+#include "FontLibrary.hpp"
+#include "core/vulkan/VDevice.hpp"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class VBuffer;
+class VImage;
+class VStagingRing;
+
+// Metrics of a glyph at FontLibrary::BASE_SIZE. These outlive the glyph's atlas residency.
+struct GlyphMetrics {
+    glm::vec2 size{0.0f, 0.0f};
+    glm::vec2 bearing{0.0f, 0.0f};
+    float advance = 0.0f;
+};
+
+// Identifies a glyph independent of its rendered size, since every size samples the same distance field.
+inline uint64_t makeGlyphKey(FontId font, char32_t codepoint) {
+    return (static_cast<uint64_t>(font) << 32) | static_cast<uint64_t>(codepoint);
+}
+
+// A single-channel distance field texture divided into fixed slots, recycled in least-recently-used order.
+class GlyphAtlas {
+
+private:
+    struct Entry {
+        GlyphMetrics metrics;
+        glm::vec2 texels{0.0f, 0.0f}; // Extent in the atlas; smaller than metrics.size when downscaled to fit.
+        int32_t slot = -1;
+        uint64_t lastUsedFrame = 0;
+        std::list<uint64_t>::iterator lru;
+    };
+
+    void createImage();
+    void writeSlot(int32_t slot, const GlyphBitmap &bitmap);
+    // Copies a slot's pixels out of the CPU-side atlas into `destination`, rows packed.
+    void copySlot(int32_t slot, uint8_t *destination) const;
+    void uploadImmediately();
+    void evict(uint64_t key);
+
+    VDevice &vDevice;
+    std::unique_ptr<VImage> image;
+    std::unique_ptr<VBuffer> stagingBuffer;
+    VkSampler sampler;
+
+    std::vector<uint8_t> pixels;
+    std::unordered_map<uint64_t, Entry> entries;
+    std::list<uint64_t> lru; // Resident glyphs only, most recently used first.
+    std::vector<int32_t> freeSlots;
+    std::vector<int32_t> dirtySlots;
+    std::vector<VkBufferImageCopy> regions;
+
+    uint64_t frame = 1;
+    uint64_t generation = 0;
+    bool overflowReported = false;
+
+
+public:
+    static constexpr uint32_t SIZE = 1024;
+    static constexpr uint32_t SLOT_SIZE = 48;
+    static constexpr uint32_t SLOTS_PER_ROW = SIZE / SLOT_SIZE;
+    static constexpr uint32_t SLOT_COUNT = SLOTS_PER_ROW * SLOTS_PER_ROW;
+    static constexpr VkDeviceSize SLOT_BYTES = SLOT_SIZE * SLOT_SIZE;
+    // Slots per synchronous upload, used only when the staging ring has no room.
+    static constexpr uint32_t MAX_UPLOADS_PER_BATCH = 128;
+    // Kept fully inside the outline and never handed to a glyph, so untextured quads can share the text draw.
+    static constexpr int32_t SOLID_SLOT = SLOT_COUNT - 1;
+
+    explicit GlyphAtlas(VDevice &device);
+    ~GlyphAtlas();
+
+    GlyphAtlas(const GlyphAtlas &) = delete;
+    GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+    void beginFrame() { ++frame; }
+
+    // Marks the glyph as used this frame. Returns false if its bitmap has to be (re)rasterized.
+    bool touch(uint64_t key);
+
+    // Stores a freshly rasterized glyph, evicting the least recently used one when full.
+    // Fails only when every slot holds a glyph that was already used this frame.
+    bool insert(uint64_t key, const GlyphBitmap &bitmap);
+
+    const GlyphMetrics *findMetrics(uint64_t key) const;
+
+    // Returns u0, v0, u1, v1 of a resident glyph; glyphs without pixels (spaces) have no region.
+    bool findRegion(uint64_t key, glm::vec4 &uv) const;
+
+    // A region of SOLID_SLOT that samples as fully covered everywhere, filtering included.
+    glm::vec4 solidRegion() const;
+
+    // Records copies of the modified slots into `commandBuffer`, the frame's graphics command buffer outside
+    // a render pass, staged through `stagingRing`. The atlas is sampled by frames still in flight, so it is
+    // written on the queue that reads it and ordered after them by the layout barriers, never waited for.
+    void upload(VkCommandBuffer commandBuffer, VStagingRing &stagingRing);
+
+    // Bumped whenever a glyph gains or loses a slot, which invalidates any cached texture coordinates.
+    uint64_t getGeneration() const { return generation; }
+
+    VkImageView getImageView() const;
+    VkSampler getSampler() const { return sampler; }
+
+};
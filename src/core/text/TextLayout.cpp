@@ -0,0 +1,166 @@
+#include "TextLayout.hpp"
+#include "util/Utf8.hpp"
+#include <algorithm>
+#include <functional>
+
+std::size_t TextLayoutKeyHash::operator()(const TextLayoutKey &key) const {
+    std::size_t hash = std::hash<std::string>{}(key.text);
+    auto combine = [&hash](std::size_t value) {
+        hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    };
+
+    combine(std::hash<FontId>{}(key.font));
+    combine(std::hash<float>{}(key.size));
+    combine(std::hash<float>{}(key.wrapWidth));
+    return hash;
+}
+
+TextLayoutCache::TextLayoutCache(const FontLibrary &fontLibrary, const GlyphAtlas &glyphAtlas) : fonts(fontLibrary), atlas(glyphAtlas) {}
+
+float TextLayoutCache::advance(FontId font, char32_t codepoint, float scale) const {
+    const GlyphMetrics *glyph = atlas.findMetrics(makeGlyphKey(font, codepoint));
+    return glyph ? glyph->advance * scale : 0.0f;
+}
+
+void TextLayoutCache::layoutFrom(const TextLayoutKey &key, std::size_t index, glm::vec2 pen, TextLayout &layout) {
+    const std::string &text = key.text;
+    const FontMetrics &metrics = fonts.getMetrics(key.font);
+    const float scale = key.size / static_cast<float>(FontLibrary::BASE_SIZE);
+    const float lineHeight = metrics.lineHeight * scale;
+
+    auto newLine = [&](std::size_t byteOffset) {
+        layout.size.x = std::max(layout.size.x, pen.x);
+        pen = {0.0f, pen.y + lineHeight};
+        layout.lines.push_back({static_cast<uint32_t>(layout.glyphs.size()), static_cast<uint32_t>(byteOffset), pen.y});
+    };
+
+    bool atWordStart = true;
+    while (index < text.size()) {
+        const std::size_t start = index;
+        const char32_t codepoint = Utf8::next(text, index);
+
+        if (codepoint == U'\n') {
+            newLine(index);
+            atWordStart = true;
+            continue;
+        }
+
+        if (codepoint == U' ') {
+            atWordStart = true;
+        } else if (atWordStart) {
+            atWordStart = false;
+
+            // Greedy wrapping: move the whole word down if it would cross the wrap width.
+            if (key.wrapWidth > 0.0f && pen.x > 0.0f) {
+                float wordWidth = 0.0f;
+                std::size_t lookahead = start;
+                while (lookahead < text.size()) {
+                    const char32_t next = Utf8::next(text, lookahead);
+                    if (next == U' ' || next == U'\n') {
+                        break;
+                    }
+                    wordWidth += advance(key.font, next, scale);
+                }
+
+                if (pen.x + wordWidth > key.wrapWidth) {
+                    newLine(start);
+                }
+            }
+        }
+
+        const uint64_t glyphKey = makeGlyphKey(key.font, codepoint);
+        layout.glyphs.push_back({glyphKey, pen, static_cast<uint32_t>(start)});
+        pen.x += advance(key.font, codepoint, scale);
+        ++stats.glyphsLaidOut;
+    }
+
+    layout.size.x = std::max(layout.size.x, pen.x);
+    layout.size.y = pen.y - metrics.descender * scale;
+}
+
+std::shared_ptr<const TextLayout> TextLayoutCache::build(const TextLayoutKey &key, const TextLayoutKey *previousKey, const TextLayout *previous) {
+    auto layout = std::make_shared<TextLayout>();
+    const float scale = key.size / static_cast<float>(FontLibrary::BASE_SIZE);
+    const float baseline = fonts.getMetrics(key.font).ascender * scale;
+
+    // Only an edit to the text itself can keep earlier lines; any other change moves every glyph.
+    const bool reusable = previous && previousKey && !previous->lines.empty() && previousKey->font == key.font &&
+                          previousKey->size == key.size && previousKey->wrapWidth == key.wrapWidth;
+
+    std::size_t resumeLine = 0;
+    if (reusable) {
+        const auto mismatch = std::mismatch(key.text.begin(), key.text.end(), previousKey->text.begin(), previousKey->text.end());
+        const std::size_t firstChange = static_cast<std::size_t>(mismatch.first - key.text.begin());
+
+        while (resumeLine + 1 < previous->lines.size() && previous->lines[resumeLine + 1].byteOffset <= firstChange) {
+            ++resumeLine;
+        }
+
+        // A shorter first word could now fit at the end of the line above, so wrapped text backs up one more line.
+        if (key.wrapWidth > 0.0f && resumeLine > 0) {
+            --resumeLine;
+        }
+    }
+
+    if (resumeLine > 0) {
+        const TextLine &line = previous->lines[resumeLine];
+        layout->glyphs.assign(previous->glyphs.begin(), previous->glyphs.begin() + line.firstGlyph);
+        layout->lines.assign(previous->lines.begin(), previous->lines.begin() + resumeLine + 1);
+        for (const auto &glyph : layout->glyphs) {
+            const float right = glyph.pen.x + advance(key.font, static_cast<char32_t>(glyph.key & 0xFFFFFFFFu), scale);
+            layout->size.x = std::max(layout->size.x, right);
+        }
+
+        layoutFrom(key, line.byteOffset, {0.0f, line.baseline}, *layout);
+        ++stats.partialRebuilds;
+    } else {
+        layout->lines.push_back({0, 0, baseline});
+        layoutFrom(key, 0, {0.0f, baseline}, *layout);
+        ++stats.fullRebuilds;
+    }
+
+    layout->uniqueGlyphs.reserve(layout->glyphs.size());
+    for (const auto &glyph : layout->glyphs) {
+        layout->uniqueGlyphs.push_back(glyph.key);
+    }
+    std::sort(layout->uniqueGlyphs.begin(), layout->uniqueGlyphs.end());
+    layout->uniqueGlyphs.erase(std::unique(layout->uniqueGlyphs.begin(), layout->uniqueGlyphs.end()), layout->uniqueGlyphs.end());
+
+    return layout;
+}
+
+std::shared_ptr<const TextLayout> TextLayoutCache::get(const TextLayoutKey &key, const TextLayoutKey *previousKey, const TextLayout *previous) {
+    ++stats.lookups;
+
+    auto it = layouts.find(key);
+    if (it != layouts.end()) {
+        ++stats.hits;
+        return it->second;
+    }
+
+    auto layout = build(key, previousKey, previous);
+    layouts.emplace(key, layout);
+    return layout;
+}
+
+void TextLayoutCache::trim() {
+    if (layouts.size() <= MAX_UNUSED_LAYOUTS) {
+        return;
+    }
+
+    std::size_t unused = 0;
+    for (const auto &[key, layout] : layouts) {
+        if (layout.use_count() == 1) {
+            ++unused;
+        }
+    }
+
+    for (auto it = layouts.begin(); it != layouts.end() && unused > MAX_UNUSED_LAYOUTS;) {
+        if (it->second.use_count() == 1) {
+            it = layouts.erase(it);
+            --unused;
+        } else {
+            ++it;
+        }
+    }
+}
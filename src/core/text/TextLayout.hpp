@@ -0,0 +1,87 @@
+#pragma once
+
+#include "FontLibrary.hpp"
+#include "GlyphAtlas.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A glyph placed relative to the label origin; texture coordinates are resolved later since the atlas may move it.
+struct PositionedGlyph {
+    uint64_t key;
+    glm::vec2 pen;       // Baseline pen position in pixels.
+    uint32_t byteOffset; // Where the glyph starts in the source string.
+};
+
+// The first glyph of a line, kept so an edit can resume layout there instead of at the start of the string.
+struct TextLine {
+    uint32_t firstGlyph;
+    uint32_t byteOffset;
+    float baseline;
+};
+
+// The result of laying out one string; immutable once built and shared by every label showing the same text.
+struct TextLayout {
+    std::vector<PositionedGlyph> glyphs;
+    std::vector<TextLine> lines;
+    std::vector<uint64_t> uniqueGlyphs;
+    glm::vec2 size{0.0f, 0.0f};
+};
+
+// Everything that influences glyph positions.
+struct TextLayoutKey {
+    std::string text;
+    FontId font;
+    float size;
+    float wrapWidth;
+
+    bool operator==(const TextLayoutKey &) const = default;
+};
+
+struct TextLayoutKeyHash {
+    std::size_t operator()(const TextLayoutKey &key) const;
+};
+
+// Counters describing how much layout work the cache avoids.
+struct TextLayoutStats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    uint64_t partialRebuilds = 0;
+    uint64_t fullRebuilds = 0;
+    uint64_t glyphsLaidOut = 0;
+};
+
+// Caches positioned glyph runs by (text, font, size, wrap width). When a string changes, the lines before
+// the first edited byte are copied from the previous layout and only the remainder is laid out again.
+class TextLayoutCache {
+
+private:
+    void layoutFrom(const TextLayoutKey &key, std::size_t index, glm::vec2 pen, TextLayout &layout);
+    std::shared_ptr<const TextLayout> build(const TextLayoutKey &key, const TextLayoutKey *previousKey, const TextLayout *previous);
+    float advance(FontId font, char32_t codepoint, float scale) const;
+
+    const FontLibrary &fonts;
+    const GlyphAtlas &atlas;
+    std::unordered_map<TextLayoutKey, std::shared_ptr<const TextLayout>, TextLayoutKeyHash> layouts;
+    TextLayoutStats stats;
+
+
+public:
+    // Unreferenced layouts beyond this many are dropped by trim().
+    static constexpr std::size_t MAX_UNUSED_LAYOUTS = 4096;
+
+    TextLayoutCache(const FontLibrary &fontLibrary, const GlyphAtlas &glyphAtlas);
+
+    // Returns the layout for `key`. `previousKey`/`previous` describe what the caller showed before, if anything,
+    // and let a miss reuse the unchanged leading lines. Every glyph's metrics must already be in the atlas.
+    std::shared_ptr<const TextLayout> get(const TextLayoutKey &key, const TextLayoutKey *previousKey = nullptr, const TextLayout *previous = nullptr);
+
+    // Drops unreferenced layouts once there are more than MAX_UNUSED_LAYOUTS of them.
+    void trim();
+
+    const TextLayoutStats &getStats() const { return stats; }
+
+};
@@ -0,0 +1,314 @@
+#include "TextRenderer.hpp"
+#include "core/ui/UIManager.hpp"
+#include "core/vulkan/VBuffer.hpp"
+#include "util/Utf8.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+
+TextRenderer::TextRenderer(VDevice &device, JobSystem &jobs) : vDevice(device), jobSystem(jobs), atlas(device), layoutCache(fonts, atlas) {
+    createDescriptors();
+}
+
+TextRenderer::~TextRenderer() {
+    vkDestroyDescriptorPool(vDevice.device(), descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(vDevice.device(), descriptorSetLayout, nullptr);
+}
+
+void TextRenderer::createDescriptors() {
+    VkDescriptorSetLayoutBinding binding {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+
+    if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create text descriptor set layout.");
+    }
+
+    VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1};
+    VkDescriptorPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+
+    if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create text descriptor pool.");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = descriptorPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &descriptorSetLayout,
+    };
+
+    if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate text descriptor set.");
+    }
+
+    // The atlas image lives as long as the renderer, so the set is written once.
+    VkDescriptorImageInfo imageInfo {
+        .sampler = atlas.getSampler(),
+        .imageView = atlas.getImageView(),
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptorSet,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(vDevice.device(), 1, &write, 0, nullptr);
+}
+
+void TextRenderer::createPipeline(const RenderTarget &target) {
+    PipelineConfigInfo config {};
+    config.bindingDescriptions = {
+        {0, sizeof(GlyphInstance), VK_VERTEX_INPUT_RATE_INSTANCE},
+    };
+    config.attributeDescriptions = {
+        {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(GlyphInstance, rect)},
+        {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(GlyphInstance, uv)},
+        {2, 0, VK_FORMAT_R32_UINT, offsetof(GlyphInstance, color)},
+    };
+    config.descriptorSetLayouts = {descriptorSetLayout};
+    config.pushConstantSize = sizeof(glm::vec2);
+    config.target = target;
+
+    vPipeline = std::make_unique<VPipeline>(vDevice, "text.vert", "text.frag", config);
+}
+
+void TextRenderer::ensureInstanceCapacity(int frameIndex, std::size_t count) {
+    auto &buffer = instanceBuffers[frameIndex];
+    if (buffer && buffer->getInstanceCount() >= count) {
+        return;
+    }
+
+    uint32_t capacity = buffer ? buffer->getInstanceCount() : 1024;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+
+    // The frame that last used this buffer has already been waited on by the swap chain's fence.
+    buffer = std::make_unique<VBuffer>(
+        vDevice,
+        sizeof(GlyphInstance),
+        capacity,
+        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    buffer->map();
+}
+
+void TextRenderer::rasterizeMissing(const std::vector<uint64_t> &missing) {
+    std::vector<GlyphBitmap> bitmaps(missing.size());
+
+    // FreeType rendering dominates, so split it across the workers in contiguous chunks.
+    const std::size_t chunks = std::min(missing.size(), std::max<std::size_t>(1, jobSystem.workerCount()));
+    const std::size_t chunkSize = (missing.size() + chunks - 1) / chunks;
+
+    JobCounter counter;
+    for (std::size_t begin = 0; begin < missing.size(); begin += chunkSize) {
+        const std::size_t end = std::min(missing.size(), begin + chunkSize);
+        jobSystem.push([&, begin, end] {
+            for (std::size_t i = begin; i < end; ++i) {
+                const FontId font = static_cast<FontId>(missing[i] >> 32);
+                const char32_t codepoint = static_cast<char32_t>(missing[i] & 0xFFFFFFFFu);
+                bitmaps[i] = FontLibrary::rasterize(fonts.getFile(font), codepoint);
+            }
+        }, &counter);
+    }
+    jobSystem.wait(counter);
+
+    for (std::size_t i = 0; i < missing.size(); ++i) {
+        atlas.insert(missing[i], bitmaps[i]);
+    }
+}
+
+void TextRenderer::emitInstances(const Label &label, LabelState &state) {
+    const float scale = label.getSize() / static_cast<float>(FontLibrary::BASE_SIZE);
+    const glm::vec2 origin = label.getPosition();
+
+    addDamage(state.bounds);
+    state.instances.clear();
+    state.bounds.reset();
+    state.atlasGeneration = atlas.getGeneration();
+
+    for (const auto &glyph : state.layout->glyphs) {
+        glm::vec4 uv;
+        if (!atlas.findRegion(glyph.key, uv)) {
+            continue;
+        }
+
+        const GlyphMetrics *metrics = atlas.findMetrics(glyph.key);
+        const glm::vec2 topLeft = origin + glyph.pen + metrics->bearing * scale;
+        const glm::vec2 bottomRight = topLeft + metrics->size * scale;
+        state.instances.push_back(GlyphInstance {
+            .rect = {topLeft.x, topLeft.y, bottomRight.x, bottomRight.y},
+            .uv = uv,
+            .color = label.getColor(),
+        });
+
+        const AABB glyphBounds{topLeft, bottomRight};
+        state.bounds = state.bounds ? AABB::merge(*state.bounds, glyphBounds) : glyphBounds;
+    }
+
+    addDamage(state.bounds);
+}
+
+void TextRenderer::addDamage(const std::optional<AABB> &box) {
+    if (box) {
+        damage = damage ? AABB::merge(*damage, *box) : *box;
+    }
+}
+
+void TextRenderer::prepare(const UIManager &uiManager, int frameIndex, VkCommandBuffer commandBuffer, VStagingRing &stagingRing) {
+    const auto &labels = uiManager.getLabels();
+    atlas.beginFrame();
+    ++frame;
+
+    bool changed = false;
+
+    // Touch every glyph in use so the atlas never evicts one, and collect the ones not resident.
+    // Clean labels reuse their layout's glyph list; only edited text has to be decoded again.
+    std::vector<uint64_t> missing;
+    std::unordered_set<uint64_t> seen;
+    auto require = [&](uint64_t key) {
+        if (!atlas.touch(key) && seen.insert(key).second) {
+            missing.push_back(key);
+        }
+    };
+
+    for (const auto &[name, label] : labels) {
+        auto [it, inserted] = labelStates.try_emplace(label.get());
+        LabelState &state = it->second;
+        state.lastSeenFrame = frame;
+        changed |= inserted;
+
+        if (label->dirty() || !state.layout) {
+            const std::string &text = label->getText();
+            std::size_t index = 0;
+            while (index < text.size()) {
+                const char32_t codepoint = Utf8::next(text, index);
+                if (codepoint != U'\n') {
+                    require(makeGlyphKey(label->getFont(), codepoint));
+                }
+            }
+        } else {
+            for (uint64_t key : state.layout->uniqueGlyphs) {
+                require(key);
+            }
+        }
+    }
+
+    for (uint64_t key : pinnedGlyphs) {
+        require(key);
+    }
+
+    if (labelStates.size() != labels.size()) {
+        std::erase_if(labelStates, [this](const auto &entry) {
+            if (entry.second.lastSeenFrame == frame) {
+                return false;
+            }
+            addDamage(entry.second.bounds);
+            return true;
+        });
+        changed = true;
+    }
+
+    if (!missing.empty()) {
+        rasterizeMissing(missing);
+    }
+    atlas.upload(commandBuffer, stagingRing);
+
+    std::size_t total = 0;
+    for (const auto &[name, label] : labels) {
+        LabelState &state = labelStates.at(label.get());
+
+        if (label->dirty() || !state.layout) {
+            TextLayoutKey key{label->getText(), label->getFont(), label->getSize(), label->getWrapWidth()};
+            if (!state.layout || !(key == state.key)) {
+                state.layout = layoutCache.get(key, state.layout ? &state.key : nullptr, state.layout.get());
+                state.key = std::move(key);
+            }
+
+            emitInstances(*label, state);
+            changed = true;
+        } else if (state.atlasGeneration != atlas.getGeneration()) {
+            emitInstances(*label, state);
+            changed = true;
+        }
+
+        label->clearDirty();
+        total += state.instances.size();
+    }
+
+    layoutCache.trim();
+
+    if (changed) {
+        ++contentVersion;
+    }
+
+    instanceCounts[frameIndex] = static_cast<uint32_t>(total);
+    if (total == 0 || bufferVersions[frameIndex] == contentVersion) {
+        return;
+    }
+
+    ensureInstanceCapacity(frameIndex, total);
+    auto *destination = static_cast<GlyphInstance *>(instanceBuffers[frameIndex]->getMappedMemory());
+    for (const auto &[name, label] : labels) {
+        const auto &instances = labelStates.at(label.get()).instances;
+        std::memcpy(destination, instances.data(), instances.size() * sizeof(GlyphInstance));
+        destination += instances.size();
+    }
+    bufferVersions[frameIndex] = contentVersion;
+}
+
+void TextRenderer::pinGlyphs(FontId font, const std::string &text) {
+    std::size_t index = 0;
+    while (index < text.size()) {
+        const uint64_t key = makeGlyphKey(font, Utf8::next(text, index));
+        if (std::find(pinnedGlyphs.begin(), pinnedGlyphs.end(), key) == pinnedGlyphs.end()) {
+            pinnedGlyphs.push_back(key);
+        }
+    }
+}
+
+void TextRenderer::draw(VkCommandBuffer commandBuffer, int frameIndex, VkExtent2D extent) {
+    if (instanceCounts[frameIndex] == 0) {
+        return;
+    }
+    drawInstances(commandBuffer, *instanceBuffers[frameIndex], instanceCounts[frameIndex], extent);
+}
+
+void TextRenderer::drawInstances(VkCommandBuffer commandBuffer, const VBuffer &instanceBuffer, uint32_t count, VkExtent2D extent) {
+    if (count == 0 || !vPipeline) {
+        return;
+    }
+
+    vPipeline->bind(commandBuffer);
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vPipeline->getPipelineLayout(), 0, 1, &descriptorSet, 0, nullptr);
+
+    const glm::vec2 viewportSize{static_cast<float>(extent.width), static_cast<float>(extent.height)};
+    vkCmdPushConstants(commandBuffer, vPipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(viewportSize), &viewportSize);
+
+    VkBuffer buffers[] = {instanceBuffer.getBuffer()};
+    VkDeviceSize offsets[] = {0};
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+    vkCmdDraw(commandBuffer, 6, count, 0, 0);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "FontLibrary.hpp"
+#include "GlyphAtlas.hpp"
+#include "TextLayout.hpp"
+#include "core/ui/SpatialIndex.hpp"
+#include "core/vulkan/VDevice.hpp"
+#include "core/vulkan/VPipeline.hpp"
+#include "core/vulkan/VSwapChain.hpp"
+#include "util/JobSystem.hpp"
+#include <array>
+#include <utility>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+class Label;
+class UIManager;
+class VBuffer;
+class VStagingRing;
+
+// One glyph quad; the whole frame's text is a single instanced draw of these.
+struct GlyphInstance {
+    glm::vec4 rect; // x0, y0, x1, y1 in window pixels.
+    glm::vec4 uv;   // u0, v0, u1, v1 in the atlas.
+    uint32_t color; // AABBGGRR.
+};
+
+// Turns UIManager labels into batched, instanced SDF glyph quads sampled from a shared atlas.
+class TextRenderer {
+
+private:
+    // What was last emitted for a label, so unchanged labels cost a copy rather than a layout.
+    struct LabelState {
+        TextLayoutKey key;
+        std::shared_ptr<const TextLayout> layout;
+        std::vector<GlyphInstance> instances;
+        std::optional<AABB> bounds; // Pixel bounds of the instances, for damage tracking.
+        uint64_t atlasGeneration = 0;
+        uint64_t lastSeenFrame = 0;
+    };
+
+    void createDescriptors();
+    void ensureInstanceCapacity(int frameIndex, std::size_t count);
+    void rasterizeMissing(const std::vector<uint64_t> &missing);
+    void emitInstances(const Label &label, LabelState &state);
+    void addDamage(const std::optional<AABB> &box);
+
+    VDevice &vDevice;
+    JobSystem &jobSystem;
+    FontLibrary fonts;
+    GlyphAtlas atlas;
+    TextLayoutCache layoutCache;
+    std::unique_ptr<VPipeline> vPipeline;
+
+    // Glyphs kept resident whether or not any label uses them, for text drawn outside the labels.
+    std::vector<uint64_t> pinnedGlyphs;
+
+    std::unordered_map<const Label *, LabelState> labelStates;
+    uint64_t frame = 0;
+    uint64_t contentVersion = 1;
+    std::array<uint64_t, VSwapChain::MAX_FRAMES_IN_FLIGHT> bufferVersions{};
+    std::optional<AABB> damage;
+
+    VkDescriptorSetLayout descriptorSetLayout;
+    VkDescriptorPool descriptorPool;
+    VkDescriptorSet descriptorSet;
+
+    std::array<std::unique_ptr<VBuffer>, VSwapChain::MAX_FRAMES_IN_FLIGHT> instanceBuffers;
+    std::array<uint32_t, VSwapChain::MAX_FRAMES_IN_FLIGHT> instanceCounts{};
+
+
+public:
+    TextRenderer(VDevice &device, JobSystem &jobs);
+    ~TextRenderer();
+
+    TextRenderer(const TextRenderer &) = delete;
+    TextRenderer &operator=(const TextRenderer &) = delete;
+
+    // Must be called again whenever the render target changes.
+    void createPipeline(const RenderTarget &target);
+
+    // Rasterizes any glyphs the labels need, records their upload into `commandBuffer` (the frame's, outside
+    // the render pass) through `stagingRing`, and writes this frame's instance buffer. Only dirty labels are
+    // laid out again; the buffer is rewritten only if some label's glyphs changed.
+    void prepare(const UIManager &uiManager, int frameIndex, VkCommandBuffer commandBuffer, VStagingRing &stagingRing);
+
+    // Records a single draw for all text prepared for this frame.
+    void draw(VkCommandBuffer commandBuffer, int frameIndex, VkExtent2D extent);
+
+    // Draws glyph instances from another buffer with the text pipeline and atlas, for example the overlay's.
+    void drawInstances(VkCommandBuffer commandBuffer, const VBuffer &instanceBuffer, uint32_t count, VkExtent2D extent);
+
+    // Keeps every glyph of `text` resident from the next prepare on, so it can be placed without a label.
+    void pinGlyphs(FontId font, const std::string &text);
+    const GlyphAtlas &getAtlas() const { return atlas; }
+
+    // Returns, and resets, the pixel region whose text changed since the last call.
+    std::optional<AABB> takeDamage() { return std::exchange(damage, std::nullopt); }
+
+    FontLibrary &getFonts() { return fonts; }
+    const TextLayoutStats &getLayoutStats() const { return layoutCache.getStats(); }
+    uint32_t getInstanceCount(int frameIndex) const { return instanceCounts[frameIndex]; }
+
+};
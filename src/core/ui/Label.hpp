@@ -0,0 +1,41 @@
+#pragma once
+
+#include "core/text/FontLibrary.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+
+// A run of text placed in window pixels, measured from the top-left corner to the top of its first line.
+class Label {
+
+private:
+    std::string text_;
+    FontId font_;
+    float size_;
+    glm::vec2 position_{0.0f, 0.0f};
+    uint32_t color_ = 0xFF000000;
+    float wrapWidth_ = 0.0f; // Zero disables wrapping.
+    bool dirty_ = true;
+
+
+public:
+    Label(FontId font, float size, std::string text = {}) : text_(std::move(text)), font_(font), size_(size) {}
+
+    void setText(std::string text) { text_ = std::move(text); dirty_ = true; }
+    void setFont(FontId font) { font_ = font; dirty_ = true; }
+    void setSize(float size) { size_ = size; dirty_ = true; }
+    void setPosition(const glm::vec2 &position) { position_ = position; dirty_ = true; }
+    void setColor(uint32_t color) { color_ = color; dirty_ = true; }
+    void setWrapWidth(float width) { wrapWidth_ = width; dirty_ = true; }
+
+    const std::string &getText() const { return text_; }
+    FontId getFont() const { return font_; }
+    float getSize() const { return size_; }
+    const glm::vec2 &getPosition() const { return position_; }
+    uint32_t getColor() const { return color_; }
+    float getWrapWidth() const { return wrapWidth_; }
+
+    bool dirty() const { return dirty_; }
+    void clearDirty() { dirty_ = false; }
+
+};
@@ -1,10 +1,25 @@
 #include "Primitives.hpp"
 #include "util/Color.hpp"
 #include "core/vulkan/VBuffer.hpp"
+#include "core/vulkan/VGeometryRegistry.hpp"
+#include "core/vulkan/VInstanceTable.hpp"
+#include "core/vulkan/VTextureCache.hpp"
 
 namespace Primitives {
 
-Primitive::~Primitive() = default;
+Primitive::~Primitive() {
+    if (instanceTable) {
+        instanceTable->release(instanceHandle);
+    }
+}
+
+uint32_t Primitive::getInstanceHandle(VInstanceTable &table) const {
+    if (!instanceTable) {
+        instanceHandle = table.allocate();
+        instanceTable = &table;
+    }
+    return instanceHandle;
+}
 
 std::vector<Vertex> Vertex::create_default_triangle() {
     return {
@@ -50,62 +65,77 @@ std::array<VkVertexInputAttributeDescription, 2> Vertex::getAttributeDescription
     return attributeDescriptions;
 }
 
-Primitive::Primitive(VDevice &device, const std::vector<Vertex> &initial_vertices, const std::vector<uint32_t> &initial_indices)
-    : vDevice(device), vertices(initial_vertices), indices(initial_indices) {
-    updateVertexBuffer();
-    updateIndexBuffer();
+Primitive::Primitive(VGeometryRegistry &geometry, const std::vector<Vertex> &initial_vertices, const std::vector<uint32_t> &initial_indices)
+    : geometry(geometry), vertices(initial_vertices), indices(initial_indices) {
+    updateMesh();
+}
+
+const VBuffer &Primitive::getVertexBuffer() const {
+    return *mesh->vertexBuffer;
+}
+
+const VBuffer *Primitive::getIndexBuffer() const {
+    return mesh ? mesh->indexBuffer.get() : nullptr;
 }
 
 void Primitive::setVertices(const std::vector<Vertex> &new_vertices) {
     this->vertices = new_vertices;
-    updateVertexBuffer();
+    updateMesh();
+    notifyChanged(Change::Vertices);
 }
 
 void Primitive::setIndices(const std::vector<uint32_t> &new_indices) {
     this->indices = new_indices;
-    updateIndexBuffer();
+    updateMesh();
+    notifyChanged(Change::Indices);
 }
 
-void Primitive::updateVertexBuffer() {
+void Primitive::updateMesh() {
     vertexCount = static_cast<uint32_t>(vertices.size());
+    indexCount = static_cast<uint32_t>(indices.size());
+    dirty_ = true;
+
     if (vertexCount == 0) {
-        vertexBuffer = nullptr;
+        mesh = nullptr;
         return;
     }
 
-    uint32_t vertexSize = sizeof(vertices[0]);
-    vertexBuffer = std::make_unique<VBuffer>(
-        vDevice,
-        vertexSize,
-        vertexCount,
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
+    if (!useInstanceColors()) {
+        mesh = geometry.acquire(vertices, indices);
+        return;
+    }
 
-    vertexBuffer->map();
-    vertexBuffer->writeToBuffer(vertices.data());
-    vertexBuffer->unmap();
+    // Strip colors so every instance of the same shape resolves to one shared buffer.
+    std::vector<Vertex> shape = vertices;
+    for (auto &vertex : shape) {
+        vertex.color = 0xFFFFFFFF;
+    }
+
+    mesh = geometry.acquire(shape, indices);
 }
 
-void Primitive::updateIndexBuffer() {
-    indexCount = static_cast<uint32_t>(indices.size());
-    if (indexCount == 0) {
-        indexBuffer = nullptr;
-        return;
+Sprite::Sprite(VGeometryRegistry &geometry, std::shared_ptr<const VTexture> texture)
+    : Quad(geometry), texture(std::move(texture)) {
+    drawnReady = this->texture && this->texture->isReady();
+}
+
+void Sprite::setTexture(std::shared_ptr<const VTexture> newTexture) {
+    texture = std::move(newTexture);
+    drawnReady = texture && texture->isReady();
+    dirty_ = true;
+    notifyChanged(Change::Texture);
+}
+
+bool Sprite::refreshTexture() {
+    const bool ready = texture && texture->isReady();
+    if (ready == drawnReady) {
+        return false;
     }
 
-    uint32_t indexSize = sizeof(indices[0]);
-    indexBuffer = std::make_unique<VBuffer>(
-        vDevice,
-        indexSize,
-        indexCount,
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-    );
-
-    indexBuffer->map();
-    indexBuffer->writeToBuffer(indices.data());
-    indexBuffer->unmap();
+    drawnReady = ready;
+    dirty_ = true;
+    notifyChanged(Change::Texture);
+    return true;
 }
 
 } // namespace Primitives
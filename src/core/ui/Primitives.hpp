@@ -9,14 +9,20 @@
 #include <array>
 
 class VBuffer;
+class VGeometryRegistry;
+class VInstanceTable;
+class VTexture;
+struct VMesh;
 
 namespace Primitives {
 
+// Primitives with at most this many vertices pass their colors per instance instead of through the shared vertex buffer.
+constexpr uint32_t MAX_INSTANCE_COLORS = 4;
+
 struct alignas(16) PushConstantData {
     glm::vec2 position{0.0f, 0.0f};
     glm::vec2 scale{1.0f, 1.0f};
-    uint32_t colors[4];
-    int isBilinear;
+    uint32_t colors[MAX_INSTANCE_COLORS]; // Only pushed for variants that read them.
 };
 
 // Represents a single vertex with 2D position and a packed 32-bit color.
@@ -37,63 +43,127 @@ struct alignas(16) Transform {
     glm::vec2 scale{1.0f, 1.0f};
 };
 
+// Stretches a primitive's scale so shapes keep their proportions in a non-square viewport.
+inline glm::vec2 aspectCorrectedScale(glm::vec2 scale, float aspect) {
+    if (aspect > 1.0f) {
+        scale.x /= aspect;
+    } else {
+        scale.y *= aspect;
+    }
+    return scale;
+}
+
+class Primitive;
+
+// What an edit touched, for listeners that treat a move differently from new geometry.
+enum class Change : uint8_t { Position, Scale, Vertices, Indices, Texture };
+
+// Receives a callback whenever a primitive's transform or geometry changes.
+class PrimitiveListener {
+public:
+    virtual ~PrimitiveListener() = default;
+    virtual void primitiveChanged(Primitive &primitive, Change change) = 0;
+};
+
 // Base class for all drawable geometric shapes.
 class Primitive {
 
 protected:
-    void updateVertexBuffer();
-    void updateIndexBuffer();
+    // Swaps in the shared mesh matching the current vertices and indices.
+    void updateMesh();
 
-    VDevice &vDevice;
+    VGeometryRegistry &geometry;
     Transform transform{};
     std::vector<Vertex> vertices;
-    std::unique_ptr<VBuffer> vertexBuffer;
-    uint32_t vertexCount = 0;
-
     std::vector<uint32_t> indices;
-    std::unique_ptr<VBuffer> indexBuffer;
+    std::shared_ptr<const VMesh> mesh;
+    uint32_t vertexCount = 0;
     uint32_t indexCount = 0;
 
     bool dirty_ = true;
+    PrimitiveListener *listener = nullptr;
+    uint64_t drawOrder = 0;
+
+    // Slot in the renderer's instance table, assigned the first time the primitive is drawn bindlessly.
+    mutable VInstanceTable *instanceTable = nullptr;
+    mutable uint32_t instanceHandle = 0;
+
+    void notifyChanged(Change change) { if (listener) listener->primitiveChanged(*this, change); }
 
 
 public:
-    Primitive(VDevice &device, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices = {});
+    Primitive(VGeometryRegistry &geometry, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices = {});
     virtual ~Primitive();
 
     virtual bool useBilinearInterpolation() const { return false; }
 
-    void setPosition(const glm::vec2 &pos) { transform.position = pos; }
-    void setScale(const glm::vec2 &scl) { transform.scale = scl; }
+    // The texture to sample, if any. Textured primitives are drawn with the sprite pipeline.
+    virtual const VTexture *getTexture() const { return nullptr; }
+
+    // True when colors travel in push constants, leaving the mesh colorless and therefore shareable.
+    bool useInstanceColors() const { return vertexCount <= MAX_INSTANCE_COLORS; }
+
+    void setPosition(const glm::vec2 &pos) { transform.position = pos; dirty_ = true; notifyChanged(Change::Position); }
+    void setScale(const glm::vec2 &scl) { transform.scale = scl; dirty_ = true; notifyChanged(Change::Scale); }
     void setVertices(const std::vector<Vertex> &vertices);
     void setIndices(const std::vector<uint32_t> &indices);
 
     bool dirty() const { return dirty_; }
     void clearDirty() { dirty_ = false; }
 
-    const VBuffer &getVertexBuffer() const { return *vertexBuffer; }
+    // Only one listener is supported; UIManager installs itself when the primitive is added.
+    void setListener(PrimitiveListener *newListener) { listener = newListener; }
+
+    // Position in the draw sequence; later primitives draw over earlier ones. UIManager assigns it on add.
+    void setDrawOrder(uint64_t order) { drawOrder = order; }
+    uint64_t getDrawOrder() const { return drawOrder; }
+
+    // Returns this primitive's handle in `table`, allocating it on first use. Called while recording.
+    uint32_t getInstanceHandle(VInstanceTable &table) const;
+
+    const VBuffer &getVertexBuffer() const;
     uint32_t getVertexCount() const { return vertexCount; }
-    const VBuffer *getIndexBuffer() const { return indexBuffer.get(); }
+    const VBuffer *getIndexBuffer() const;
     uint32_t getIndexCount() const { return indexCount; }
     const Transform &getTransform() const { return transform; }
     const std::vector<Vertex>& getVertices() const { return vertices; }
+    const std::vector<uint32_t> &getIndices() const { return indices; }
 
 };
 
 class Triangle : public Primitive {
 public:
-    Triangle(VDevice &device) : Primitive(device, Vertex::create_default_triangle()) {}
-    Triangle(VDevice &device, const std::vector<Vertex> &vertices) : Primitive(device, vertices) {}
+    Triangle(VGeometryRegistry &geometry) : Primitive(geometry, Vertex::create_default_triangle()) {}
+    Triangle(VGeometryRegistry &geometry, const std::vector<Vertex> &vertices) : Primitive(geometry, vertices) {}
 };
 
 class Quad : public Primitive {
 public:
     static std::vector<uint32_t> create_default_indices();
-    Quad(VDevice &device) : Primitive(device, Vertex::create_default_quad(), create_default_indices()) {}
-    Quad(VDevice &device, const std::vector<Vertex> &vertices) : Primitive(device, vertices, create_default_indices()) {}
+    Quad(VGeometryRegistry &geometry) : Primitive(geometry, Vertex::create_default_quad(), create_default_indices()) {}
+    Quad(VGeometryRegistry &geometry, const std::vector<Vertex> &vertices) : Primitive(geometry, vertices, create_default_indices()) {}
 
     // NEW: Override the virtual function to return true for Quads.
     bool useBilinearInterpolation() const override { return true; }
 };
 
+// A quad that samples a texture, tinted by its corner colors (white by default). Until the
+// texture has finished loading a plain white texel is sampled instead.
+class Sprite : public Quad {
+
+private:
+    std::shared_ptr<const VTexture> texture;
+    bool drawnReady = false;
+
+
+public:
+    Sprite(VGeometryRegistry &geometry, std::shared_ptr<const VTexture> texture);
+
+    const VTexture *getTexture() const override { return texture.get(); }
+    void setTexture(std::shared_ptr<const VTexture> newTexture);
+
+    // Marks the sprite for redraw if its texture became ready since it was last drawn; returns true if so.
+    bool refreshTexture();
+};
+
 } // namespace Primitives
@@ -0,0 +1,253 @@
+#include "SpatialIndex.hpp"
+#include <stdexcept>
+
+int32_t SpatialIndex::allocateNode() {
+    if (freeList == NULL_NODE) {
+        nodes.emplace_back();
+        return static_cast<int32_t>(nodes.size() - 1);
+    }
+
+    const int32_t node = freeList;
+    freeList = nodes[node].parent;
+    nodes[node] = Node{};
+    return node;
+}
+
+void SpatialIndex::freeNode(int32_t node) {
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    nodes[node].item = nullptr;
+    freeList = node;
+}
+
+AABB SpatialIndex::fatten(const AABB &box) const {
+    const glm::vec2 margin{FAT_MARGIN, FAT_MARGIN};
+    return {box.min - margin, box.max + margin};
+}
+
+int32_t SpatialIndex::createProxy(const AABB &box, Primitives::Primitive *item) {
+    const int32_t proxy = allocateNode();
+    nodes[proxy].fat = fatten(box);
+    nodes[proxy].tight = box;
+    nodes[proxy].item = item;
+    nodes[proxy].height = 0;
+
+    insertLeaf(proxy);
+    ++proxyCount;
+    return proxy;
+}
+
+void SpatialIndex::destroyProxy(int32_t proxy) {
+    if (proxy < 0 || proxy >= static_cast<int32_t>(nodes.size()) || !nodes[proxy].isLeaf() || nodes[proxy].height != 0) {
+        throw std::runtime_error("SpatialIndex Error: Invalid proxy.");
+    }
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    --proxyCount;
+}
+
+bool SpatialIndex::moveProxy(int32_t proxy, const AABB &box) {
+    nodes[proxy].tight = box;
+    if (nodes[proxy].fat.contains(box)) {
+        return false;
+    }
+
+    removeLeaf(proxy);
+    nodes[proxy].fat = fatten(box);
+    insertLeaf(proxy);
+    return true;
+}
+
+void SpatialIndex::insertLeaf(int32_t leaf) {
+    if (root == NULL_NODE) {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling that minimizes the added perimeter (surface area heuristic).
+    const AABB leafBox = nodes[leaf].fat;
+    int32_t index = root;
+    while (!nodes[index].isLeaf()) {
+        const Node &node = nodes[index];
+        const float area = node.fat.perimeter();
+        const float combinedArea = AABB::merge(node.fat, leafBox).perimeter();
+
+        const float cost = 2.0f * combinedArea;
+        const float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](int32_t child) {
+            const AABB merged = AABB::merge(leafBox, nodes[child].fat);
+            if (nodes[child].isLeaf()) {
+                return merged.perimeter() + inheritanceCost;
+            }
+            return merged.perimeter() - nodes[child].fat.perimeter() + inheritanceCost;
+        };
+
+        const float cost1 = descendCost(node.child1);
+        const float cost2 = descendCost(node.child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = nodes[sibling].parent;
+    const int32_t newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].fat = AABB::merge(leafBox, nodes[sibling].fat);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != NULL_NODE) {
+        if (nodes[oldParent].child1 == sibling) {
+            nodes[oldParent].child1 = newParent;
+        } else {
+            nodes[oldParent].child2 = newParent;
+        }
+    } else {
+        root = newParent;
+    }
+
+    for (index = nodes[leaf].parent; index != NULL_NODE; index = nodes[index].parent) {
+        index = balance(index);
+
+        Node &node = nodes[index];
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        node.fat = AABB::merge(nodes[node.child1].fat, nodes[node.child2].fat);
+    }
+}
+
+void SpatialIndex::removeLeaf(int32_t leaf) {
+    if (leaf == root) {
+        root = NULL_NODE;
+        return;
+    }
+
+    const int32_t parent = nodes[leaf].parent;
+    const int32_t grandParent = nodes[parent].parent;
+    const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == NULL_NODE) {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        freeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent) {
+        nodes[grandParent].child1 = sibling;
+    } else {
+        nodes[grandParent].child2 = sibling;
+    }
+    nodes[sibling].parent = grandParent;
+    freeNode(parent);
+
+    for (int32_t index = grandParent; index != NULL_NODE; index = nodes[index].parent) {
+        index = balance(index);
+
+        Node &node = nodes[index];
+        node.fat = AABB::merge(nodes[node.child1].fat, nodes[node.child2].fat);
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+    }
+}
+
+// Rotates the taller grandchild subtree up when the children of `iA` differ in height by more than one.
+// Returns the index of the node now at iA's position.
+int32_t SpatialIndex::balance(int32_t iA) {
+    Node &A = nodes[iA];
+    if (A.isLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    const int32_t iB = A.child1;
+    const int32_t iC = A.child2;
+    Node &B = nodes[iB];
+    Node &C = nodes[iC];
+
+    auto replaceChild = [this](int32_t parent, int32_t oldChild, int32_t newChild) {
+        if (parent == NULL_NODE) {
+            root = newChild;
+        } else if (nodes[parent].child1 == oldChild) {
+            nodes[parent].child1 = newChild;
+        } else {
+            nodes[parent].child2 = newChild;
+        }
+    };
+
+    const int32_t difference = C.height - B.height;
+
+    // Rotate C up.
+    if (difference > 1) {
+        const int32_t iF = C.child1;
+        const int32_t iG = C.child2;
+        Node &F = nodes[iF];
+        Node &G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceChild(C.parent, iA, iC);
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.fat = AABB::merge(B.fat, G.fat);
+            C.fat = AABB::merge(A.fat, F.fat);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.fat = AABB::merge(B.fat, F.fat);
+            C.fat = AABB::merge(A.fat, G.fat);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+
+        return iC;
+    }
+
+    // Rotate B up.
+    if (difference < -1) {
+        const int32_t iD = B.child1;
+        const int32_t iE = B.child2;
+        Node &D = nodes[iD];
+        Node &E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceChild(B.parent, iA, iB);
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.fat = AABB::merge(C.fat, E.fat);
+            B.fat = AABB::merge(A.fat, D.fat);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.fat = AABB::merge(C.fat, D.fat);
+            B.fat = AABB::merge(A.fat, E.fat);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+
+        return iB;
+    }
+
+    return iA;
+}
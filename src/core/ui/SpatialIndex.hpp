@@ -0,0 +1,128 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Primitives { class Primitive; }
+
+// An axis-aligned bounding box. The spatial index works in normalized device coordinates; damage tracking also uses window pixels.
+struct AABB {
+    glm::vec2 min{0.0f, 0.0f};
+    glm::vec2 max{0.0f, 0.0f};
+
+    bool contains(const AABB &other) const {
+        return min.x <= other.min.x && min.y <= other.min.y && other.max.x <= max.x && other.max.y <= max.y;
+    }
+
+    bool contains(const glm::vec2 &point) const {
+        return min.x <= point.x && min.y <= point.y && point.x <= max.x && point.y <= max.y;
+    }
+
+    bool overlaps(const AABB &other) const {
+        return min.x <= other.max.x && other.min.x <= max.x && min.y <= other.max.y && other.min.y <= max.y;
+    }
+
+    float perimeter() const { return 2.0f * ((max.x - min.x) + (max.y - min.y)); }
+
+    static AABB merge(const AABB &a, const AABB &b) { return {glm::min(a.min, b.min), glm::max(a.max, b.max)}; }
+};
+
+// A dynamic bounding volume hierarchy over UI primitives (after Box2D's b2DynamicTree). Leaves store
+// enlarged boxes, so small movements do not restructure the tree, and the tree is kept balanced with rotations.
+class SpatialIndex {
+
+private:
+    static constexpr int32_t NULL_NODE = -1;
+    // Traversal stack entries kept off the heap; a balanced tree of a million leaves is about 30 high.
+    static constexpr int32_t STACK_CAPACITY = 64;
+
+    struct Node {
+        AABB fat;
+        AABB tight; // Leaves only; queries report a leaf only if this box matches.
+        Primitives::Primitive *item = nullptr;
+        int32_t parent = NULL_NODE; // Doubles as the free-list link.
+        int32_t child1 = NULL_NODE;
+        int32_t child2 = NULL_NODE;
+        int32_t height = -1;
+
+        bool isLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    int32_t balance(int32_t node);
+    AABB fatten(const AABB &box) const;
+
+    template <typename Overlaps, typename Fn>
+    void traverse(Overlaps &&overlaps, Fn &&fn) const {
+        if (root == NULL_NODE) {
+            return;
+        }
+
+        // Popping one node and pushing its two children never holds more than height + 1 entries, so a balanced
+        // tree stays on the stack array; only a degenerate one spills to the heap (as b2GrowableStack does).
+        std::array<int32_t, STACK_CAPACITY> fixed;
+        std::vector<int32_t> spill;
+        int32_t *stack = fixed.data();
+        if (height() + 1 > STACK_CAPACITY) {
+            spill.resize(static_cast<std::size_t>(height()) + 1);
+            stack = spill.data();
+        }
+
+        int32_t count = 0;
+        stack[count++] = root;
+        while (count > 0) {
+            const Node &node = nodes[stack[--count]];
+
+            if (!overlaps(node.fat)) {
+                continue;
+            }
+
+            if (node.isLeaf()) {
+                if (overlaps(node.tight)) {
+                    fn(node.item);
+                }
+            } else {
+                stack[count++] = node.child1;
+                stack[count++] = node.child2;
+            }
+        }
+    }
+
+    std::vector<Node> nodes;
+    int32_t root = NULL_NODE;
+    int32_t freeList = NULL_NODE;
+    uint32_t proxyCount = 0;
+
+
+public:
+    // How far leaf boxes are enlarged on each side, in NDC units.
+    static constexpr float FAT_MARGIN = 0.02f;
+
+    // Returns a proxy id that stays valid until destroyProxy.
+    int32_t createProxy(const AABB &box, Primitives::Primitive *item);
+    void destroyProxy(int32_t proxy);
+
+    // Updates a proxy's box. Returns true only if the tree had to be restructured.
+    bool moveProxy(int32_t proxy, const AABB &box);
+
+    template <typename Fn>
+    void queryRect(const AABB &rect, Fn &&fn) const {
+        traverse([&rect](const AABB &box) { return box.overlaps(rect); }, fn);
+    }
+
+    template <typename Fn>
+    void queryPoint(const glm::vec2 &point, Fn &&fn) const {
+        traverse([&point](const AABB &box) { return box.contains(point); }, fn);
+    }
+
+    const AABB &getBounds(int32_t proxy) const { return nodes[proxy].tight; }
+    uint32_t size() const { return proxyCount; }
+    int32_t height() const { return root == NULL_NODE ? 0 : nodes[root].height; }
+
+};
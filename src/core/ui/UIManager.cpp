@@ -1,10 +1,46 @@
 #include "UIManager.hpp"
+#include <algorithm>
+#include <utility>
 
 void UIManager::add(const std::string &name, std::unique_ptr<Primitives::Primitive> element) {
     if (elements.count(name)) {
         throw std::runtime_error("UIManager Error: An element with the name '" + name + "' already exists.");
     }
+
+    Primitives::Primitive *primitive = element.get();
+    primitive->setListener(this);
+    primitive->setDrawOrder(nextDrawOrder++);
+    const AABB bounds = boundsOf(*primitive);
+    proxies[primitive] = spatialIndex.createProxy(bounds, primitive);
+    addDamage(bounds);
+    if (auto *sprite = dynamic_cast<Primitives::Sprite *>(primitive)) {
+        sprites.push_back(sprite);
+    }
     elements[name] = std::move(element);
+    if (observer) {
+        observer->elementAdded(name, *primitive);
+    }
+}
+
+void UIManager::remove(const std::string &name) {
+    auto it = elements.find(name);
+    if (it == elements.end()) {
+        throw std::runtime_error("UIManager Error: Element with name '" + name + "' not found.");
+    }
+
+    Primitives::Primitive *primitive = it->second.get();
+    if (observer) {
+        observer->elementRemoved(name, *primitive);
+    }
+
+    auto proxy = proxies.find(primitive);
+    addDamage(spatialIndex.getBounds(proxy->second));
+    spatialIndex.destroyProxy(proxy->second);
+    proxies.erase(proxy);
+    if (auto *sprite = dynamic_cast<Primitives::Sprite *>(primitive)) {
+        sprites.erase(std::find(sprites.begin(), sprites.end(), sprite));
+    }
+    elements.erase(it);
 }
 
 Primitives::Primitive *UIManager::get(const std::string &name) {
@@ -18,3 +54,101 @@ Primitives::Primitive *UIManager::get(const std::string &name) {
 const std::unordered_map<std::string, std::unique_ptr<Primitives::Primitive>> &UIManager::getElements() const {
     return elements;
 }
+
+void UIManager::addLabel(const std::string &name, std::unique_ptr<Label> label) {
+    if (labels.count(name)) {
+        throw std::runtime_error("UIManager Error: A label with the name '" + name + "' already exists.");
+    }
+    labels[name] = std::move(label);
+}
+
+Label *UIManager::getLabel(const std::string &name) {
+    try {
+        return labels.at(name).get();
+    } catch (const std::out_of_range &) {
+        throw std::runtime_error("UIManager Error: Label with name '" + name + "' not found.");
+    }
+}
+
+const std::unordered_map<std::string, std::unique_ptr<Label>> &UIManager::getLabels() const {
+    return labels;
+}
+
+void UIManager::refreshTextures() {
+    for (Primitives::Sprite *sprite : sprites) {
+        sprite->refreshTexture();
+    }
+}
+
+void UIManager::updateLayout(const glm::vec2 &viewportSize) {
+    root.calculateLayout(UIRect{{0.0f, 0.0f}, viewportSize});
+}
+
+AABB UIManager::boundsOf(const Primitives::Primitive &primitive) const {
+    const auto &transform = primitive.getTransform();
+    const glm::vec2 scale = Primitives::aspectCorrectedScale(transform.scale, aspect);
+
+    const auto &vertices = primitive.getVertices();
+    if (vertices.empty()) {
+        return {transform.position, transform.position};
+    }
+
+    glm::vec2 localMin = vertices[0].position;
+    glm::vec2 localMax = vertices[0].position;
+    for (const auto &vertex : vertices) {
+        localMin = glm::min(localMin, vertex.position);
+        localMax = glm::max(localMax, vertex.position);
+    }
+
+    // A negative scale mirrors the shape, so take both corners before ordering them.
+    const glm::vec2 a = transform.position + localMin * scale;
+    const glm::vec2 b = transform.position + localMax * scale;
+    return {glm::min(a, b), glm::max(a, b)};
+}
+
+void UIManager::primitiveChanged(Primitives::Primitive &primitive, Primitives::Change change) {
+    if (observer) {
+        observer->elementChanged(primitive, change);
+    }
+
+    auto it = proxies.find(&primitive);
+    if (it != proxies.end()) {
+        // Both where the primitive was and where it is now have to be repainted.
+        const AABB bounds = boundsOf(primitive);
+        addDamage(spatialIndex.getBounds(it->second));
+        addDamage(bounds);
+        spatialIndex.moveProxy(it->second, bounds);
+    }
+}
+
+void UIManager::setViewportAspect(float newAspect) {
+    if (newAspect == aspect) {
+        return;
+    }
+
+    aspect = newAspect;
+    addDamage(AABB{{-1.0f, -1.0f}, {1.0f, 1.0f}});
+    for (const auto &[primitive, proxy] : proxies) {
+        spatialIndex.moveProxy(proxy, boundsOf(*primitive));
+    }
+}
+
+void UIManager::queryRect(const AABB &rect, std::vector<Primitives::Primitive *> &out) const {
+    spatialIndex.queryRect(rect, [&out](Primitives::Primitive *primitive) { out.push_back(primitive); });
+}
+
+void UIManager::queryPoint(const glm::vec2 &point, std::vector<Primitives::Primitive *> &out) const {
+    spatialIndex.queryPoint(point, [&out](Primitives::Primitive *primitive) { out.push_back(primitive); });
+}
+
+void UIManager::queryVisible(std::vector<Primitives::Primitive *> &out) const {
+    queryRect(AABB{{-1.0f, -1.0f}, {1.0f, 1.0f}}, out);
+}
+
+void UIManager::addDamage(const AABB &box) {
+    damage = damage ? AABB::merge(*damage, box) : box;
+}
+
+std::optional<AABB> UIManager::takeDamage() {
+    return std::exchange(damage, std::nullopt);
+}
@@ -1,26 +1,92 @@
 #pragma once
 
+#include "Label.hpp"
 #include "Primitives.hpp"
+#include "SpatialIndex.hpp"
+#include "UINode.hpp"
 #include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+// Told about every element added, removed or edited while installed, e.g. to capture a session for replay.
+class UIObserver {
+public:
+    virtual ~UIObserver() = default;
+    virtual void elementAdded(const std::string &name, Primitives::Primitive &element) = 0;
+    // Called before the element is destroyed.
+    virtual void elementRemoved(const std::string &name, Primitives::Primitive &element) = 0;
+    virtual void elementChanged(Primitives::Primitive &element, Primitives::Change change) = 0;
+};
 
 // Manages a collection of named UI elements for easy access and iteration.
-class UIManager {
+class UIManager : public Primitives::PrimitiveListener {
 
 private:
+    // World bounds of a primitive as drawn, i.e. with the renderer's aspect correction applied.
+    AABB boundsOf(const Primitives::Primitive &primitive) const;
+    void addDamage(const AABB &box);
+
     std::unordered_map<std::string, std::unique_ptr<Primitives::Primitive>> elements;
+    std::unordered_map<const Primitives::Primitive *, int32_t> proxies;
+    std::vector<Primitives::Sprite *> sprites;
+    SpatialIndex spatialIndex;
+    float aspect = 1.0f;
+    std::optional<AABB> damage;
+    std::unordered_map<std::string, std::unique_ptr<Label>> labels;
+    UINode root;
+    UIObserver *observer = nullptr;
+    uint64_t nextDrawOrder = 0;
 
 
 public:
     // Adds a UI element to the manager with a unique name.
     void add(const std::string &name, std::unique_ptr<Primitives::Primitive> element);
 
+    // Destroys the element with this name; its area is redrawn on the next frame.
+    void remove(const std::string &name);
+
     // Retrieves a raw pointer to a UI element by its name for modification.
     Primitives::Primitive *get(const std::string &name);
 
     // Provides read-only access to the underlying map of elements for rendering.
     const std::unordered_map<std::string, std::unique_ptr<Primitives::Primitive>> &getElements() const;
 
+    // Adds a text label with a unique name. Labels are drawn above all primitives.
+    void addLabel(const std::string &name, std::unique_ptr<Label> label);
+
+    // Retrieves a raw pointer to a label by its name for modification.
+    Label *getLabel(const std::string &name);
+
+    // Provides read-only access to the labels for text rendering.
+    const std::unordered_map<std::string, std::unique_ptr<Label>> &getLabels() const;
+
+    // Keeps the spatial index in sync with transform and geometry edits.
+    void primitiveChanged(Primitives::Primitive &primitive, Primitives::Change change) override;
+
+    // Only one observer is supported; null removes it.
+    void setObserver(UIObserver *newObserver) { observer = newObserver; }
+
+    // Redraws sprites whose textures finished loading. Call on frames where the texture cache reports progress.
+    void refreshTextures();
+
+    // Re-fits every element's bounds if the window's aspect ratio changed.
+    void setViewportAspect(float newAspect);
+
+    // Spatial queries in normalized device coordinates. Results are appended to `out` in no particular order.
+    void queryRect(const AABB &rect, std::vector<Primitives::Primitive *> &out) const;
+    void queryPoint(const glm::vec2 &point, std::vector<Primitives::Primitive *> &out) const;
+    void queryVisible(std::vector<Primitives::Primitive *> &out) const;
+
+    // Returns, and resets, the NDC region touched by primitive edits since the last call.
+    std::optional<AABB> takeDamage();
+
+    // The root of the retained layout tree; it always spans the whole window.
+    UINode &getRoot() { return root; }
+
+    // Re-runs layout for the parts of the tree that changed, or everything if the window was resized.
+    void updateLayout(const glm::vec2 &viewportSize);
+
 };
@@ -0,0 +1,199 @@
+#include "UINode.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+float mainAxis(const glm::vec2 &v, FlexDirection direction) { return direction == FlexDirection::Row ? v.x : v.y; }
+float crossAxis(const glm::vec2 &v, FlexDirection direction) { return direction == FlexDirection::Row ? v.y : v.x; }
+
+glm::vec2 fromAxes(float main, float cross, FlexDirection direction) {
+    return direction == FlexDirection::Row ? glm::vec2(main, cross) : glm::vec2(cross, main);
+}
+
+} // namespace
+
+UINode &UINode::addChild(std::unique_ptr<UINode> child) {
+    if (child->parent) {
+        throw std::runtime_error("UINode Error: Node already has a parent.");
+    }
+
+    child->parent = this;
+    children.push_back(std::move(child));
+    markDirty();
+    return *children.back();
+}
+
+std::unique_ptr<UINode> UINode::removeChild(UINode &child) {
+    auto it = std::find_if(children.begin(), children.end(), [&child](const auto &c) { return c.get() == &child; });
+    if (it == children.end()) {
+        throw std::runtime_error("UINode Error: Node is not a child of this node.");
+    }
+
+    std::unique_ptr<UINode> removed = std::move(*it);
+    children.erase(it);
+    removed->parent = nullptr;
+    markDirty();
+    return removed;
+}
+
+void UINode::setStyle(const FlexStyle &newStyle) {
+    if (style == newStyle) {
+        return;
+    }
+
+    style = newStyle;
+    markDirty();
+}
+
+void UINode::setMeasureFunc(MeasureFunc func) {
+    measureFunc = std::move(func);
+    markDirty();
+}
+
+void UINode::markDirty() {
+    // Ancestors of a dirty node are already dirty, so the walk stops at the first one found.
+    for (UINode *node = this; node; node = node->parent) {
+        if (node != this && !node->layoutValid && !node->measureCache[0].valid && !node->measureCache[1].valid) {
+            break;
+        }
+
+        node->layoutValid = false;
+        for (auto &entry : node->measureCache) {
+            entry.valid = false;
+        }
+    }
+}
+
+glm::vec2 UINode::measure(glm::vec2 available) {
+    for (const auto &entry : measureCache) {
+        if (entry.valid && entry.available == available) {
+            return entry.result;
+        }
+    }
+
+    const glm::vec2 paddingSize{style.padding.x + style.padding.z, style.padding.y + style.padding.w};
+    const glm::vec2 inner = glm::max(glm::vec2(style.width.value_or(available.x), style.height.value_or(available.y)) - paddingSize, glm::vec2(0.0f));
+
+    glm::vec2 content{0.0f, 0.0f};
+    if (measureFunc) {
+        content = measureFunc(inner);
+    } else {
+        float main = 0.0f;
+        float cross = 0.0f;
+        for (const auto &child : children) {
+            const glm::vec2 childSize = child->measure(inner);
+            main += mainAxis(childSize, style.direction);
+            cross = std::max(cross, crossAxis(childSize, style.direction));
+        }
+
+        if (children.size() > 1) {
+            main += style.gap * static_cast<float>(children.size() - 1);
+        }
+        content = fromAxes(main, cross, style.direction);
+    }
+
+    const glm::vec2 result{style.width.value_or(content.x + paddingSize.x), style.height.value_or(content.y + paddingSize.y)};
+    measureCache[nextCacheEntry] = {available, result, true};
+    nextCacheEntry = (nextCacheEntry + 1) % measureCache.size();
+    return result;
+}
+
+void UINode::calculateLayout(const UIRect &bounds) {
+    measure(bounds.size);
+    arrange(bounds);
+}
+
+void UINode::arrange(const UIRect &newRect) {
+    if (layoutValid && rect == newRect) {
+        return;
+    }
+
+    const bool moved = rect != newRect;
+    rect = newRect;
+    layoutValid = true;
+
+    if (moved && onLayout) {
+        onLayout(rect);
+    }
+
+    if (children.empty()) {
+        return;
+    }
+
+    const FlexDirection direction = style.direction;
+    const glm::vec2 origin = rect.position + glm::vec2(style.padding.x, style.padding.y);
+    const glm::vec2 inner = glm::max(rect.size - glm::vec2(style.padding.x + style.padding.z, style.padding.y + style.padding.w), glm::vec2(0.0f));
+    const float innerMain = mainAxis(inner, direction);
+    const float innerCross = crossAxis(inner, direction);
+
+    // Flex basis is the measured size; free space is then shared out by grow or shrink factors.
+    std::vector<float> mainSizes(children.size());
+    float used = style.gap * static_cast<float>(children.size() - 1);
+    float totalGrow = 0.0f;
+    float totalShrink = 0.0f;
+    for (std::size_t i = 0; i < children.size(); ++i) {
+        mainSizes[i] = mainAxis(children[i]->measure(inner), direction);
+        used += mainSizes[i];
+        totalGrow += children[i]->style.flexGrow;
+        totalShrink += children[i]->style.flexShrink * mainSizes[i];
+    }
+
+    float freeSpace = innerMain - used;
+    if (freeSpace > 0.0f && totalGrow > 0.0f) {
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            mainSizes[i] += freeSpace * children[i]->style.flexGrow / totalGrow;
+        }
+        freeSpace = 0.0f;
+    } else if (freeSpace < 0.0f && totalShrink > 0.0f) {
+        for (std::size_t i = 0; i < children.size(); ++i) {
+            mainSizes[i] = std::max(0.0f, mainSizes[i] + freeSpace * children[i]->style.flexShrink * mainSizes[i] / totalShrink);
+        }
+        freeSpace = 0.0f;
+    }
+
+    float cursor = 0.0f;
+    float spacing = style.gap;
+    switch (style.justify) {
+    case FlexJustify::Start:
+        break;
+    case FlexJustify::Center:
+        cursor = std::max(0.0f, freeSpace) * 0.5f;
+        break;
+    case FlexJustify::End:
+        cursor = std::max(0.0f, freeSpace);
+        break;
+    case FlexJustify::SpaceBetween:
+        if (children.size() > 1) {
+            spacing += std::max(0.0f, freeSpace) / static_cast<float>(children.size() - 1);
+        }
+        break;
+    }
+
+    for (std::size_t i = 0; i < children.size(); ++i) {
+        UINode &child = *children[i];
+        const bool fixedCross = (direction == FlexDirection::Row ? child.style.height : child.style.width).has_value();
+
+        float crossSize = crossAxis(child.measure(inner), direction);
+        float crossOffset = 0.0f;
+        switch (style.alignItems) {
+        case FlexAlign::Stretch:
+            if (!fixedCross) crossSize = innerCross;
+            break;
+        case FlexAlign::Start:
+            break;
+        case FlexAlign::Center:
+            crossOffset = (innerCross - crossSize) * 0.5f;
+            break;
+        case FlexAlign::End:
+            crossOffset = innerCross - crossSize;
+            break;
+        }
+
+        child.arrange(UIRect {
+            .position = origin + fromAxes(cursor, crossOffset, direction),
+            .size = fromAxes(mainSizes[i], crossSize, direction),
+        });
+        cursor += mainSizes[i] + spacing;
+    }
+}
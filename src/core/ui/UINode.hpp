@@ -0,0 +1,102 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// An axis-aligned rectangle in window pixels, origin at the top-left.
+struct UIRect {
+    glm::vec2 position{0.0f, 0.0f};
+    glm::vec2 size{0.0f, 0.0f};
+
+    bool operator==(const UIRect &) const = default;
+};
+
+enum class FlexDirection { Row, Column };
+enum class FlexJustify { Start, Center, End, SpaceBetween };
+enum class FlexAlign { Start, Center, End, Stretch };
+
+// The subset of flexbox the layout engine understands: a single, non-wrapping line of children.
+struct FlexStyle {
+    FlexDirection direction = FlexDirection::Column;
+    FlexJustify justify = FlexJustify::Start;
+    FlexAlign alignItems = FlexAlign::Stretch;
+
+    std::optional<float> width;  // Unset sizes are derived from content, or stretched by the parent.
+    std::optional<float> height;
+    float flexGrow = 0.0f;
+    float flexShrink = 1.0f;
+
+    glm::vec4 padding{0.0f, 0.0f, 0.0f, 0.0f}; // Left, top, right, bottom.
+    float gap = 0.0f;
+
+    bool operator==(const FlexStyle &) const = default;
+};
+
+// A node of the retained UI tree. Changing a node's style or content marks it and its ancestors dirty;
+// the next layout pass then revisits only dirty paths, reusing cached measurements everywhere else.
+class UINode {
+
+public:
+    // Returns the content size of a leaf given the space available to it.
+    using MeasureFunc = std::function<glm::vec2(glm::vec2 available)>;
+    // Called with the node's absolute rectangle whenever it changes.
+    using LayoutCallback = std::function<void(const UIRect &rect)>;
+
+
+private:
+    // Parents measure a child once against their own available space and again against their final size,
+    // so two entries keep both lookups warm across frames.
+    struct MeasureCacheEntry {
+        glm::vec2 available{-1.0f, -1.0f};
+        glm::vec2 result{0.0f, 0.0f};
+        bool valid = false;
+    };
+
+    glm::vec2 measure(glm::vec2 available);
+    void arrange(const UIRect &rect);
+
+    UINode *parent = nullptr;
+    std::vector<std::unique_ptr<UINode>> children;
+
+    FlexStyle style;
+    MeasureFunc measureFunc;
+    LayoutCallback onLayout;
+
+    std::array<MeasureCacheEntry, 2> measureCache;
+    std::size_t nextCacheEntry = 0;
+    UIRect rect;
+    bool layoutValid = false;
+
+
+public:
+    UINode() = default;
+    explicit UINode(const FlexStyle &style) : style(style) {}
+
+    UINode(const UINode &) = delete;
+    UINode &operator=(const UINode &) = delete;
+
+    // Takes ownership of the child and returns it for further setup.
+    UINode &addChild(std::unique_ptr<UINode> child);
+    std::unique_ptr<UINode> removeChild(UINode &child);
+
+    void setStyle(const FlexStyle &newStyle);
+    void setMeasureFunc(MeasureFunc func);
+    void setLayoutCallback(LayoutCallback callback) { onLayout = std::move(callback); }
+
+    // Invalidates this node's cached measurement, e.g. after its content changed size.
+    void markDirty();
+
+    // Lays out the tree rooted here to fill `bounds`. Clean subtrees whose rectangle is unchanged are skipped.
+    void calculateLayout(const UIRect &bounds);
+
+    bool isDirty() const { return !layoutValid; }
+    const FlexStyle &getStyle() const { return style; }
+    const UIRect &getRect() const { return rect; }
+    UINode *getParent() const { return parent; }
+    const std::vector<std::unique_ptr<UINode>> &getChildren() const { return children; }
+
+};
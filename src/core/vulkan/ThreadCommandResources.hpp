@@ -1,9 +1,15 @@
 #pragma once
 #include "Vulkan.hpp"
+#include <vector>
+
+namespace Primitives { class Primitive; }
 
 struct ThreadCommandResources {
     VkCommandPool   pool   {VK_NULL_HANDLE};
     VkCommandBuffer buffer {VK_NULL_HANDLE};
     bool            recorded{false};
     VkFramebuffer   framebufferUsed{VK_NULL_HANDLE};
+    std::vector<Primitives::Primitive *> contents; // What the buffer was last recorded with.
+    VkRect2D        scissorUsed{};
+    VkExtent2D      extentUsed{};  // The viewport is baked in, so a resize needs a new recording.
 };
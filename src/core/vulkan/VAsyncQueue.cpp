@@ -0,0 +1,205 @@
+#include "VAsyncQueue.hpp"
+#include <stdexcept>
+#include <string>
+
+VAsyncQueue::VAsyncQueue(VDevice &device, Kind kind) : vDevice(device) {
+    const QueueFamilyIndices &families = vDevice.queueFamilies();
+    graphicsFamily = families.graphicsFamily.value();
+
+    std::optional<uint32_t> dedicatedFamily;
+    if (kind == Kind::Transfer) {
+        name = "transfer";
+        producerStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        producerAccess = VK_ACCESS_TRANSFER_WRITE_BIT;
+        producerLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        dedicatedFamily = families.transferFamily;
+        queue = vDevice.transferQueue();
+    } else {
+        name = "compute";
+        producerStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        producerAccess = VK_ACCESS_SHADER_WRITE_BIT;
+        producerLayout = VK_IMAGE_LAYOUT_GENERAL;
+        dedicatedFamily = vDevice.computeQueueFamily();
+        queue = vDevice.computeQueue();
+    }
+
+    dedicated = dedicatedFamily.has_value();
+    if (!dedicated) {
+        return;
+    }
+
+    family = *dedicatedFamily;
+
+    VkCommandPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = family,
+    };
+
+    if (vkCreateCommandPool(vDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        throw std::runtime_error(std::string("Failed to create ") + name + " command pool.");
+    }
+
+    VkCommandBufferAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = commandPool,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = static_cast<uint32_t>(commandBuffers.size()),
+    };
+
+    if (vDevice.allocateCommandBuffers(allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error(std::string("Failed to allocate ") + name + " command buffers.");
+    }
+
+    VkSemaphoreCreateInfo semaphoreInfo {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    for (auto &semaphore : semaphores) {
+        if (vkCreateSemaphore(vDevice.device(), &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS) {
+            throw std::runtime_error(std::string("Failed to create ") + name + " semaphore.");
+        }
+    }
+
+    timer = std::make_unique<VGpuTimer>(vDevice, 1, family);
+    timer->setScopeName(0, kind == Kind::Transfer ? "Transfer" : "Compute");
+}
+
+VAsyncQueue::~VAsyncQueue() {
+    for (VkSemaphore semaphore : semaphores) {
+        vkDestroySemaphore(vDevice.device(), semaphore, nullptr);
+    }
+    vDevice.destroyCommandPool(commandPool);
+}
+
+void VAsyncQueue::beginFrame(int newFrameIndex, VkCommandBuffer commandBuffer) {
+    frameIndex = newFrameIndex;
+    graphicsCommandBuffer = commandBuffer;
+    recording = false;
+    pendingWait.reset();
+    imageBarriers.clear();
+    bufferBarriers.clear();
+    barrierStages = 0;
+
+    // The slot's fence covers the graphics submission that waited on this slot's last one, so its queries are done.
+    if (timer) {
+        timer->beginFrame(frameIndex, VK_NULL_HANDLE);
+    }
+}
+
+void VAsyncQueue::beginCommands() {
+    VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error(std::string("Failed to begin recording ") + name + " command buffer.");
+    }
+    recording = true;
+    timer->begin(commandBuffer, 0);
+}
+
+VkCommandBuffer VAsyncQueue::getCommandBuffer() {
+    if (!dedicated) {
+        return graphicsCommandBuffer;
+    }
+
+    if (!recording) {
+        beginCommands();
+    }
+    return commandBuffers[frameIndex];
+}
+
+void VAsyncQueue::finishImage(VkImage image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage) {
+    VkImageMemoryBarrier barrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = producerAccess,
+        .dstAccessMask = access,
+        .oldLayout = producerLayout,
+        .newLayout = layout,
+        .srcQueueFamilyIndex = dedicated ? family : VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = dedicated ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+    };
+
+    if (dedicated) {
+        // The release half; the acquire recorded by flush() repeats the same layout change.
+        VkImageMemoryBarrier release = barrier;
+        release.dstAccessMask = 0;
+        vkCmdPipelineBarrier(getCommandBuffer(), producerStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &release);
+        barrier.srcAccessMask = 0;
+    }
+
+    imageBarriers.push_back(barrier);
+    barrierStages |= stage;
+}
+
+void VAsyncQueue::finishBuffer(VkBuffer buffer, VkAccessFlags access, VkPipelineStageFlags stage) {
+    VkBufferMemoryBarrier barrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = producerAccess,
+        .dstAccessMask = access,
+        .srcQueueFamilyIndex = dedicated ? family : VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = dedicated ? graphicsFamily : VK_QUEUE_FAMILY_IGNORED,
+        .buffer = buffer,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    };
+
+    if (dedicated) {
+        VkBufferMemoryBarrier release = barrier;
+        release.dstAccessMask = 0;
+        vkCmdPipelineBarrier(getCommandBuffer(), producerStage, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &release, 0, nullptr);
+        barrier.srcAccessMask = 0;
+    }
+
+    bufferBarriers.push_back(barrier);
+    barrierStages |= stage;
+}
+
+void VAsyncQueue::flush() {
+    if (recording) {
+        VkCommandBuffer commandBuffer = commandBuffers[frameIndex];
+        timer->end(commandBuffer, 0);
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error(std::string("Failed to record ") + name + " command buffer.");
+        }
+
+        VkSubmitInfo submitInfo {
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &commandBuffer,
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &semaphores[frameIndex],
+        };
+
+        if (vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error(std::string("Failed to submit ") + name + " command buffer.");
+        }
+
+        recording = false;
+        pendingWait = SemaphoreWait{semaphores[frameIndex], barrierStages};
+    }
+
+    if (imageBarriers.empty() && bufferBarriers.empty()) {
+        return;
+    }
+
+    // One barrier for the whole frame's results: plain visibility, or the acquire half of each ownership transfer.
+    const VkPipelineStageFlags srcStage = dedicated ? static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT) : producerStage;
+    vkCmdPipelineBarrier(graphicsCommandBuffer, srcStage, barrierStages, 0, 0, nullptr,
+                         static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+                         static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+
+    imageBarriers.clear();
+    bufferBarriers.clear();
+    barrierStages = 0;
+}
+
+std::optional<SemaphoreWait> VAsyncQueue::takeWait() {
+    std::optional<SemaphoreWait> wait = pendingWait;
+    pendingWait.reset();
+    return wait;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VGpuTimer.hpp"
+#include "VSwapChain.hpp"
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Work that feeds the frame but can run beside it: uploads on a transfer-only family, or compute passes
+// (simulation, culling, mip generation) on a compute family without graphics. Such work is submitted on its
+// own queue, overlapping the previous frame's rendering, and each resource it produces is handed to the
+// graphics queue with a queue-family ownership transfer. When the device has no such family, the work is
+// recorded into the frame's own command buffer instead, ahead of the render pass.
+//
+// Resources written here should be per frame slot, or fully overwritten each time: the graphics queue
+// never hands them back, and the slot's fence is what guarantees the previous reader has finished.
+class VAsyncQueue {
+
+private:
+    void beginCommands();
+
+    VDevice &vDevice;
+    const char *name;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkPipelineStageFlags producerStage;
+    VkAccessFlags producerAccess;
+    VkImageLayout producerLayout;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    std::array<VkCommandBuffer, VSwapChain::MAX_FRAMES_IN_FLIGHT> commandBuffers{};
+    std::array<VkSemaphore, VSwapChain::MAX_FRAMES_IN_FLIGHT> semaphores{};
+    // One scope around each submission on the separate queue.
+    std::unique_ptr<VGpuTimer> timer;
+
+    uint32_t family = 0;
+    uint32_t graphicsFamily = 0;
+    bool dedicated = false;
+
+    int frameIndex = 0;
+    VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;
+    bool recording = false;
+    std::optional<SemaphoreWait> pendingWait;
+
+    // Barriers that make each result visible to graphics; with a dedicated queue they are the acquires.
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    VkPipelineStageFlags barrierStages = 0;
+
+
+public:
+    enum class Kind {
+        Transfer, // Copies; produced images must be in TRANSFER_DST_OPTIMAL when finished.
+        Compute,  // Dispatches; produced images must be in GENERAL when finished.
+    };
+
+    VAsyncQueue(VDevice &device, Kind kind);
+    ~VAsyncQueue();
+
+    VAsyncQueue(const VAsyncQueue &) = delete;
+    VAsyncQueue &operator=(const VAsyncQueue &) = delete;
+
+    // Starts a frame. `graphicsCommandBuffer` is the frame's primary, already begun. The slot's fence must
+    // have been waited on, which also covers this slot's previous submission on this queue.
+    void beginFrame(int frameIndex, VkCommandBuffer graphicsCommandBuffer);
+
+    // The command buffer this frame's work should be recorded into.
+    VkCommandBuffer getCommandBuffer();
+
+    // Declares that a just-written image will next be used in `layout`, with `access`, by `stage`.
+    void finishImage(VkImage image, VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stage);
+
+    // Declares that a just-written buffer will next be read with `access` by `stage`.
+    void finishBuffer(VkBuffer buffer, VkAccessFlags access, VkPipelineStageFlags stage);
+
+    // Submits the recorded work, if any, and records the matching barriers into the graphics command buffer.
+    // Must be called before the render pass begins.
+    void flush();
+
+    // The wait this frame's graphics submission needs, if work ran on the separate queue. Resets it.
+    std::optional<SemaphoreWait> takeWait();
+
+    // True when work really runs on its own queue rather than in the frame's command buffer.
+    bool isDedicated() const { return dedicated; }
+
+    // GPU time of this slot's previous submission on the separate queue, read back by beginFrame. Empty without
+    // a dedicated queue, without timestamp support, or when that frame submitted nothing.
+    std::optional<double> getGpuMilliseconds() const { return timer ? timer->getMilliseconds(0) : std::nullopt; }
+
+};
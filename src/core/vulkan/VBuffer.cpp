@@ -18,8 +18,7 @@ VBuffer::VBuffer(VDevice &device, VkDeviceSize instanceSize, uint32_t instanceCo
 
 VBuffer::~VBuffer() {
     unmap();
-    vkDestroyBuffer(vDevice.device(), buffer, nullptr);
-    vkFreeMemory(vDevice.device(), memory, nullptr);
+    vDevice.destroyBuffer(buffer, memory);
 }
 
 VkDeviceSize VBuffer::getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment) {
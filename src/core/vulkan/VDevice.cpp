@@ -1,6 +1,10 @@
 #include "VDevice.hpp"
 #include "VSwapChain.hpp"
+#include <algorithm>
 #include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstdio>
 #include <iostream>
 #include <set>
 
@@ -13,17 +17,58 @@ constexpr bool enableValidationLayers = false;
 constexpr std::array<const char*, 1> validationLayers = {"VK_LAYER_KHRONOS_validation"};
 constexpr std::array<const char*, 1> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 
-VDevice::VDevice(VkInstance instance, VkSurfaceKHR surface, GLFWwindow* window)
-    : instance_{instance}, surface_{surface}, window_{window} {
+// The feature structs passed to vkCreateDevice. They point at each other, so a chain is built in place
+// and never copied.
+struct VDevice::FeatureChain {
+    VkPhysicalDeviceVulkan12Features vulkan12 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+    VkPhysicalDeviceVulkan13Features vulkan13 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRendering { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR };
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2 { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR };
+    void *head = nullptr;
+
+    FeatureChain() = default;
+    FeatureChain(const FeatureChain &) = delete;
+    FeatureChain &operator=(const FeatureChain &) = delete;
+
+    void link(void *feature) {
+        static_cast<VkBaseOutStructure *>(feature)->pNext = static_cast<VkBaseOutStructure *>(head);
+        head = feature;
+    }
+};
+
+VDevice::VDevice(VkInstance instance, VkSurfaceKHR surface, GLFWwindow* window, uint32_t instanceApiVersion)
+    : instance_{instance}, instanceApiVersion_{instanceApiVersion}, surface_{surface}, window_{window} {
     pickPhysicalDevice();
     vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
     createLogicalDevice();
+    createCommandPool();
 }
 
 VDevice::~VDevice() {
+    destroyCommandPool(commandPool_);
     vkDestroyDevice(device_, nullptr);
 }
 
+namespace {
+
+const char *deviceTypeName(VkPhysicalDeviceType type) {
+    switch (type) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: return "CPU";
+        default: return "other";
+    }
+}
+
+std::string normalized(std::string text) {
+    text.erase(std::remove(text.begin(), text.end(), '-'), text.end());
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+}
+
 void VDevice::pickPhysicalDevice() {
     uint32_t deviceCount = 0;
     vkEnumeratePhysicalDevices(instance_, &deviceCount, nullptr);
@@ -34,22 +79,66 @@ void VDevice::pickPhysicalDevice() {
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
 
+    const char *overrideValue = std::getenv(DEVICE_OVERRIDE_ENV);
+    const std::string wanted = overrideValue ? normalized(overrideValue) : std::string();
+
+    uint64_t bestScore = 0;
+    VkPhysicalDevice overridden = VK_NULL_HANDLE;
     for (const auto &device : devices) {
-        if (isDeviceSuitable(device)) {
+        VkPhysicalDeviceProperties candidate;
+        vkGetPhysicalDeviceProperties(device, &candidate);
+        const std::optional<uint64_t> score = rateDevice(device);
+
+        std::cout << "GPU '" << candidate.deviceName << "' (" << deviceTypeName(candidate.deviceType) << ", "
+                  << deviceLocalMemory(device) / (1024 * 1024) << " MiB, UUID " << deviceUuid(device) << "): ";
+        if (score) {
+            std::cout << "score " << *score << "\n";
+        } else {
+            std::cout << "unsuitable\n";
+        }
+
+        if (!wanted.empty() && overridden == VK_NULL_HANDLE) {
+            const bool matches = normalized(candidate.deviceName).find(wanted) != std::string::npos
+                || normalized(deviceUuid(device)).starts_with(wanted);
+            if (matches && score) {
+                overridden = device;
+            } else if (matches) {
+                std::cerr << "Warning: " << DEVICE_OVERRIDE_ENV << " names '" << candidate.deviceName << "', which cannot be used.\n";
+            }
+        }
+
+        if (score && *score > bestScore) {
+            bestScore = *score;
             physicalDevice_ = device;
-            break;
         }
     }
 
+    if (overridden != VK_NULL_HANDLE) {
+        physicalDevice_ = overridden;
+    } else if (!wanted.empty()) {
+        std::cerr << "Warning: no usable GPU matches " << DEVICE_OVERRIDE_ENV << "='" << overrideValue << "'; using the best-rated one.\n";
+    }
+
     if (physicalDevice_ == VK_NULL_HANDLE) {
         throw std::runtime_error("Failed to find a suitable GPU.");
     }
+
+    VkPhysicalDeviceProperties chosen;
+    vkGetPhysicalDeviceProperties(physicalDevice_, &chosen);
+    std::cout << "Using GPU '" << chosen.deviceName << "'"
+              << (overridden != VK_NULL_HANDLE ? std::string(" (set by ") + DEVICE_OVERRIDE_ENV + ")" : std::string()) << "\n";
 }
 
 void VDevice::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice_);
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    if (indices.transferFamily) {
+        uniqueQueueFamilies.insert(*indices.transferFamily);
+    }
+    if (!indices.computeFamilies.empty()) {
+        uniqueQueueFamilies.insert(indices.computeFamilies.front());
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -65,12 +154,32 @@ void VDevice::createLogicalDevice() {
 
     VkPhysicalDeviceFeatures deviceFeatures {};
 
+    // Optional: lets presentation tell the compositor which parts of the image changed. Headless devices present nothing.
+    std::vector<const char *> enabledExtensions;
+    if (!headless()) {
+        enabledExtensions.assign(deviceExtensions.begin(), deviceExtensions.end());
+    }
+    incrementalPresent_ = !headless() && isExtensionAvailable(physicalDevice_, VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+    if (incrementalPresent_) {
+        enabledExtensions.push_back(VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME);
+    }
+
+    // Optional: reports how much of each heap the driver will let this process use.
+    memoryBudget_ = isExtensionAvailable(physicalDevice_, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (memoryBudget_) {
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    FeatureChain enabledFeatures;
+    negotiateFeatures(enabledFeatures, enabledExtensions);
+
     VkDeviceCreateInfo createInfo {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+        .pNext = enabledFeatures.head,
         .queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size()),
         .pQueueCreateInfos = queueCreateInfos.data(),
-        .enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size()),
-        .ppEnabledExtensionNames = deviceExtensions.data(),
+        .enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size()),
+        .ppEnabledExtensionNames = enabledExtensions.data(),
         .pEnabledFeatures = &deviceFeatures,
     };
 
@@ -85,10 +194,166 @@ void VDevice::createLogicalDevice() {
 
     vkGetDeviceQueue(device_, indices.graphicsFamily.value(), 0, &graphicsQueue_);
     vkGetDeviceQueue(device_, indices.presentFamily.value(), 0, &presentQueue_);
+
+    // Without a transfer-only family, uploads are recorded into the graphics queue's own work.
+    transferQueue_ = graphicsQueue_;
+    if (indices.transferFamily) {
+        vkGetDeviceQueue(device_, *indices.transferFamily, 0, &transferQueue_);
+    }
+
+    computeQueue_ = graphicsQueue_;
+    if (!indices.computeFamilies.empty()) {
+        vkGetDeviceQueue(device_, indices.computeFamilies.front(), 0, &computeQueue_);
+    }
+
+    queueFamilies_ = indices;
+
+    // The loader may not export the extension's commands, so both spellings are resolved through the device.
+    if (features_.dynamicRendering) {
+        const bool core13 = features_.apiVersion >= VK_API_VERSION_1_3;
+        cmdBeginRendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(device_, core13 ? "vkCmdBeginRendering" : "vkCmdBeginRenderingKHR"));
+        cmdEndRendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+            vkGetDeviceProcAddr(device_, core13 ? "vkCmdEndRendering" : "vkCmdEndRenderingKHR"));
+        features_.dynamicRendering = cmdBeginRendering_ && cmdEndRendering_;
+    }
+}
+
+void VDevice::negotiateFeatures(FeatureChain &enabled, std::vector<const char *> &extensions) {
+    features_ = DeviceFeatures{};
+    features_.apiVersion = std::min(instanceApiVersion_, properties.apiVersion);
+
+    // Everything below is layered on Vulkan 1.2; older devices keep the baseline paths.
+    if (features_.apiVersion < VK_API_VERSION_1_2) {
+        return;
+    }
+
+    // Before 1.3, dynamic rendering and synchronization2 are only available as extensions.
+    const bool core13 = features_.apiVersion >= VK_API_VERSION_1_3;
+    const bool dynamicRenderingExtension = !core13 && isExtensionAvailable(physicalDevice_, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    const bool synchronization2Extension = !core13 && isExtensionAvailable(physicalDevice_, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+
+    FeatureChain supported;
+    supported.link(&supported.vulkan12);
+    if (core13) {
+        supported.link(&supported.vulkan13);
+    }
+    if (dynamicRenderingExtension) {
+        supported.link(&supported.dynamicRendering);
+    }
+    if (synchronization2Extension) {
+        supported.link(&supported.synchronization2);
+    }
+
+    VkPhysicalDeviceFeatures2 query {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+        .pNext = supported.head,
+    };
+    vkGetPhysicalDeviceFeatures2(physicalDevice_, &query);
+
+    const VkPhysicalDeviceVulkan12Features &has12 = supported.vulkan12;
+    features_.timelineSemaphores = has12.timelineSemaphore;
+    features_.bufferDeviceAddress = has12.bufferDeviceAddress;
+    features_.hostQueryReset = has12.hostQueryReset;
+    features_.descriptorIndexing = has12.runtimeDescriptorArray
+        && has12.shaderSampledImageArrayNonUniformIndexing
+        && has12.descriptorBindingPartiallyBound
+        && has12.descriptorBindingSampledImageUpdateAfterBind
+        && has12.descriptorBindingVariableDescriptorCount;
+
+    enabled.link(&enabled.vulkan12);
+    enabled.vulkan12.timelineSemaphore = features_.timelineSemaphores;
+    enabled.vulkan12.bufferDeviceAddress = features_.bufferDeviceAddress;
+    enabled.vulkan12.hostQueryReset = features_.hostQueryReset;
+    if (features_.descriptorIndexing) {
+        enabled.vulkan12.runtimeDescriptorArray = VK_TRUE;
+        enabled.vulkan12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        enabled.vulkan12.descriptorBindingPartiallyBound = VK_TRUE;
+        enabled.vulkan12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabled.vulkan12.descriptorBindingVariableDescriptorCount = VK_TRUE;
+    }
+
+    if (core13) {
+        features_.dynamicRendering = supported.vulkan13.dynamicRendering;
+        features_.synchronization2 = supported.vulkan13.synchronization2;
+        enabled.link(&enabled.vulkan13);
+        enabled.vulkan13.dynamicRendering = features_.dynamicRendering;
+        enabled.vulkan13.synchronization2 = features_.synchronization2;
+    }
+
+    if (dynamicRenderingExtension && supported.dynamicRendering.dynamicRendering) {
+        features_.dynamicRendering = true;
+        enabled.link(&enabled.dynamicRendering);
+        enabled.dynamicRendering.dynamicRendering = VK_TRUE;
+        extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
+
+    if (synchronization2Extension && supported.synchronization2.synchronization2) {
+        features_.synchronization2 = true;
+        enabled.link(&enabled.synchronization2);
+        enabled.synchronization2.synchronization2 = VK_TRUE;
+        extensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+
+    auto state = [](bool on) { return on ? "on" : "off"; };
+    std::cout << "Vulkan " << VK_API_VERSION_MAJOR(features_.apiVersion) << "." << VK_API_VERSION_MINOR(features_.apiVersion)
+              << " features: dynamic rendering " << state(features_.dynamicRendering)
+              << ", synchronization2 " << state(features_.synchronization2)
+              << ", descriptor indexing " << state(features_.descriptorIndexing)
+              << ", buffer device address " << state(features_.bufferDeviceAddress)
+              << ", timeline semaphores " << state(features_.timelineSemaphores)
+              << ", host query reset " << state(features_.hostQueryReset) << "\n";
+}
+
+void VDevice::createCommandPool() {
+    QueueFamilyIndices indices = findQueueFamilies(physicalDevice_);
+    VkCommandPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+        .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+        .queueFamilyIndex = indices.graphicsFamily.value(),
+    };
+
+    if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool_) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create device command pool.");
+    }
+}
+
+std::optional<uint64_t> VDevice::rateDevice(VkPhysicalDevice device) {
+    if (!isDeviceSuitable(device)) {
+        return std::nullopt;
+    }
+
+    VkPhysicalDeviceProperties candidate;
+    vkGetPhysicalDeviceProperties(device, &candidate);
+
+    // Ranked by device type first, then by device-local memory, then by the optional queues and
+    // extensions the renderer can use. Each criterion only breaks ties of the ones before it.
+    uint64_t typeRank = 0;
+    switch (candidate.deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: typeRank = 4; break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: typeRank = 3; break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: typeRank = 2; break;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU: typeRank = 1; break;
+        default: break;
+    }
+
+    const uint64_t memoryMiB = std::min<uint64_t>(deviceLocalMemory(device) / (1024 * 1024), 0xFFFFFFFF);
+
+    const QueueFamilyIndices indices = findQueueFamilies(device);
+    uint64_t extras = 0;
+    extras += indices.transferFamily ? 1 : 0;
+    extras += indices.computeFamilies.empty() ? 0 : 1;
+    extras += isExtensionAvailable(device, VK_KHR_INCREMENTAL_PRESENT_EXTENSION_NAME) ? 1 : 0;
+
+    return typeRank << 40 | memoryMiB << 8 | extras;
 }
 
 bool VDevice::isDeviceSuitable(VkPhysicalDevice device) {
     QueueFamilyIndices indices = findQueueFamilies(device);
+    if (headless()) {
+        return indices.isComplete();
+    }
+
     bool extensionsSupported = checkDeviceExtensionSupport(device);
     bool swapChainAdequate = false;
 
@@ -114,6 +379,63 @@ bool VDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
     return requiredExtensions.empty();
 }
 
+bool VDevice::isExtensionAvailable(VkPhysicalDevice device, const char *name) {
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+    for (const auto &extension : availableExtensions) {
+        if (std::string(extension.extensionName) == name) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string VDevice::deviceUuid(VkPhysicalDevice device) {
+    VkPhysicalDeviceProperties basic;
+    vkGetPhysicalDeviceProperties(device, &basic);
+    if (basic.apiVersion < VK_API_VERSION_1_1) {
+        return "unknown";
+    }
+
+    VkPhysicalDeviceIDProperties id {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+    };
+    VkPhysicalDeviceProperties2 properties2 {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+        .pNext = &id,
+    };
+    vkGetPhysicalDeviceProperties2(device, &properties2);
+
+    // Formatted like the UUIDs reported by vulkaninfo and nvidia-smi.
+    std::string uuid;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; ++i) {
+        char hex[3];
+        std::snprintf(hex, sizeof(hex), "%02x", id.deviceUUID[i]);
+        uuid += hex;
+        if (i == 3 || i == 5 || i == 7 || i == 9) {
+            uuid += '-';
+        }
+    }
+    return uuid;
+}
+
+VkDeviceSize VDevice::deviceLocalMemory(VkPhysicalDevice device) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(device, &memProperties);
+
+    VkDeviceSize total = 0;
+    for (uint32_t i = 0; i < memProperties.memoryHeapCount; ++i) {
+        if (memProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            total += memProperties.memoryHeaps[i].size;
+        }
+    }
+    return total;
+}
+
 QueueFamilyIndices VDevice::findQueueFamilies(VkPhysicalDevice device) {
     QueueFamilyIndices indices;
     uint32_t queueFamilyCount = 0;
@@ -121,23 +443,40 @@ QueueFamilyIndices VDevice::findQueueFamilies(VkPhysicalDevice device) {
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-    int i = 0;
-    for (const auto &queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+    // Every family is inspected: a graphics family that can also present is preferred, and the
+    // dedicated transfer and compute families often come after the graphics one.
+    bool graphicsPresents = false;
+    for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+        const VkQueueFlags flags = queueFamilies[i].queueFlags;
+        const bool graphics = flags & VK_QUEUE_GRAPHICS_BIT;
+        const bool compute = flags & VK_QUEUE_COMPUTE_BIT;
+
+        // Without a surface nothing is presented, so the graphics family stands in as the present family.
+        VkBool32 presentSupport = headless() ? static_cast<VkBool32>(graphics) : VK_FALSE;
+        if (!headless()) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+        }
+
+        if (graphics && (!indices.graphicsFamily || (presentSupport && !graphicsPresents))) {
             indices.graphicsFamily = i;
+            graphicsPresents = presentSupport;
         }
 
-        VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-        if (presentSupport) {
+        if (presentSupport && !indices.presentFamily) {
             indices.presentFamily = i;
         }
 
-        if (indices.isComplete()) {
-            break;
+        if ((flags & VK_QUEUE_TRANSFER_BIT) && !graphics && !compute && !indices.transferFamily) {
+            indices.transferFamily = i;
         }
 
-        i++;
+        if (compute && !graphics) {
+            indices.computeFamilies.push_back(i);
+        }
+    }
+
+    if (graphicsPresents) {
+        indices.presentFamily = indices.graphicsFamily;
     }
 
     return indices;
@@ -178,6 +517,123 @@ void VDevice::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemory
     if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate buffer memory.");
     }
+    resources_.allocated(bufferMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, VResourceTracker::classify(usage));
 
     vkBindBufferMemory(device_, buffer, bufferMemory, 0);
 }
+
+void VDevice::createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory) {
+    if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create image.");
+    }
+
+    VkMemoryRequirements memRequirements;
+    vkGetImageMemoryRequirements(device_, image, &memRequirements);
+
+    VkMemoryAllocateInfo allocInfo {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = memRequirements.size;
+    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+
+    if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate image memory.");
+    }
+    resources_.allocated(imageMemory, allocInfo.allocationSize, allocInfo.memoryTypeIndex, VResourceTracker::Usage::Image);
+
+    if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to bind image memory.");
+    }
+}
+
+void VDevice::destroyBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory) {
+    vkDestroyBuffer(device_, buffer, nullptr);
+    vkFreeMemory(device_, bufferMemory, nullptr);
+    resources_.freed(bufferMemory);
+}
+
+void VDevice::destroyImage(VkImage image, VkDeviceMemory imageMemory) {
+    vkDestroyImage(device_, image, nullptr);
+    vkFreeMemory(device_, imageMemory, nullptr);
+    resources_.freed(imageMemory);
+}
+
+VkResult VDevice::allocateCommandBuffers(const VkCommandBufferAllocateInfo &allocInfo, VkCommandBuffer *commandBuffers) {
+    const VkResult result = vkAllocateCommandBuffers(device_, &allocInfo, commandBuffers);
+    if (result == VK_SUCCESS) {
+        resources_.commandBuffersAllocated(allocInfo.commandPool, allocInfo.commandBufferCount);
+    }
+    return result;
+}
+
+void VDevice::freeCommandBuffers(VkCommandPool pool, uint32_t count, const VkCommandBuffer *commandBuffers) {
+    vkFreeCommandBuffers(device_, pool, count, commandBuffers);
+    resources_.commandBuffersFreed(pool, count);
+}
+
+void VDevice::destroyCommandPool(VkCommandPool pool) {
+    vkDestroyCommandPool(device_, pool, nullptr);
+    resources_.commandPoolDestroyed(pool);
+}
+
+std::vector<VDevice::HeapBudget> VDevice::memoryBudget() {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+    VkPhysicalDeviceMemoryProperties2 query {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2,
+        .pNext = memoryBudget_ ? &budgetProperties : nullptr,
+    };
+    vkGetPhysicalDeviceMemoryProperties2(physicalDevice_, &query);
+    const VkPhysicalDeviceMemoryProperties &memory = query.memoryProperties;
+
+    std::vector<HeapBudget> heaps(memory.memoryHeapCount);
+    for (uint32_t i = 0; i < memory.memoryHeapCount; ++i) {
+        heaps[i] = {
+            .size = memory.memoryHeaps[i].size,
+            .budget = memoryBudget_ ? budgetProperties.heapBudget[i] : memory.memoryHeaps[i].size,
+            .usage = memoryBudget_ ? budgetProperties.heapUsage[i] : 0,
+            .deviceLocal = (memory.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+        };
+    }
+
+    if (!memoryBudget_) {
+        const VResourceTracker::Snapshot tracked = resources_.snapshot();
+        for (uint32_t type = 0; type < memory.memoryTypeCount; ++type) {
+            heaps[memory.memoryTypes[type].heapIndex].usage += tracked.bytesByMemoryType[type];
+        }
+    }
+    return heaps;
+}
+
+VkCommandBuffer VDevice::beginSingleTimeCommands() {
+    VkCommandBufferAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = commandPool_,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
+
+    VkCommandBuffer commandBuffer;
+    allocateCommandBuffers(allocInfo, &commandBuffer);
+
+    VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+    return commandBuffer;
+}
+
+void VDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo {
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &commandBuffer,
+    };
+
+    vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
+    vkQueueWaitIdle(graphicsQueue_);
+
+    freeCommandBuffers(commandPool_, 1, &commandBuffer);
+}
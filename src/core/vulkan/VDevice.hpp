@@ -1,32 +1,68 @@
 #pragma once
 
+#include "VResourceTracker.hpp"
 #include "Vulkan.hpp"
+#include <optional>
+#include <string>
 #include <vector>
 
 // Encapsulates a Vulkan physical device (GPU) and its corresponding logical device.
 class VDevice {
 
 private:
+    struct FeatureChain;
+
     void pickPhysicalDevice();
     void createLogicalDevice();
+    // Fills `enabled` with the optional features this device supports and adds the extensions they need.
+    void negotiateFeatures(FeatureChain &enabled, std::vector<const char *> &extensions);
+    void createCommandPool();
+
+    // Names a GPU to use instead of the best-rated one: a case-insensitive part of its name, or its UUID.
+    static constexpr const char *DEVICE_OVERRIDE_ENV = "IRO_DEVICE";
 
     // Helpers for physical device selection
+    std::optional<uint64_t> rateDevice(VkPhysicalDevice device);
     bool isDeviceSuitable(VkPhysicalDevice device);
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+    bool isExtensionAvailable(VkPhysicalDevice device, const char *name);
+    static std::string deviceUuid(VkPhysicalDevice device);
+    static VkDeviceSize deviceLocalMemory(VkPhysicalDevice device);
 
     VkPhysicalDeviceProperties properties;
     VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
     VkDevice device_;
     VkInstance instance_;
+    uint32_t instanceApiVersion_;
     VkSurfaceKHR surface_;
     GLFWwindow* window_;
 
     VkQueue graphicsQueue_;
     VkQueue presentQueue_;
+    VkQueue transferQueue_;
+    VkQueue computeQueue_;
+    QueueFamilyIndices queueFamilies_;
+    VkCommandPool commandPool_;
+    bool incrementalPresent_ = false;
+    bool memoryBudget_ = false;
+    VResourceTracker resources_;
+    DeviceFeatures features_;
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering_ = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering_ = nullptr;
 
 
 public:
-    VDevice(VkInstance instance, VkSurfaceKHR surface, GLFWwindow *window);
+    // One memory heap's size, the share of it the driver currently grants this process, and how much is in use.
+    struct HeapBudget {
+        VkDeviceSize size;
+        VkDeviceSize budget;
+        VkDeviceSize usage;
+        bool deviceLocal;
+    };
+
+    // `instanceApiVersion` is the version the instance was created with; it caps the features that can be used.
+    // A null surface (and window) creates a headless device that renders offscreen and never presents.
+    VDevice(VkInstance instance, VkSurfaceKHR surface, GLFWwindow *window, uint32_t instanceApiVersion);
     ~VDevice();
 
     VDevice(const VDevice &) = delete;
@@ -37,13 +73,48 @@ public:
     VkPhysicalDevice physicalDevice() { return physicalDevice_; }
     VkQueue graphicsQueue() { return graphicsQueue_; }
     VkQueue presentQueue() { return presentQueue_; }
+    VkQueue transferQueue() { return transferQueue_; }
+    const QueueFamilyIndices &queueFamilies() const { return queueFamilies_; }
+    bool hasDedicatedTransferQueue() const { return queueFamilies_.transferFamily.has_value(); }
+
+    // The async compute queue, or the graphics queue when no compute-only family exists.
+    VkQueue computeQueue() { return computeQueue_; }
+    std::optional<uint32_t> computeQueueFamily() const {
+        return queueFamilies_.computeFamilies.empty() ? std::nullopt : std::optional<uint32_t>(queueFamilies_.computeFamilies.front());
+    }
     VkSurfaceKHR surface() { return surface_; }
     GLFWwindow *window() { return window_; }
+    bool headless() const { return surface_ == VK_NULL_HANDLE; }
     const VkPhysicalDeviceProperties& getPhysicalDeviceProperties() const { return properties; }
+    bool supportsIncrementalPresent() const { return incrementalPresent_; }
+    const DeviceFeatures &features() const { return features_; }
+
+    // Everything created through the helpers below is counted here.
+    VResourceTracker &resources() { return resources_; }
+
+    // Per heap. With VK_EXT_memory_budget the figures come from the driver and cover the whole process;
+    // without it the budget is the heap size and the usage is what the tracker has seen allocated.
+    std::vector<HeapBudget> memoryBudget();
+
+    // Dynamic rendering entry points, from the core or the KHR names. Only valid when features().dynamicRendering is set.
+    void cmdBeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfo &info) { cmdBeginRendering_(commandBuffer, &info); }
+    void cmdEndRendering(VkCommandBuffer commandBuffer) { cmdEndRendering_(commandBuffer); }
 
     // Utility functions
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     void createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory);
+    void createImageWithInfo(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags properties, VkImage &image, VkDeviceMemory &imageMemory);
+    void destroyBuffer(VkBuffer buffer, VkDeviceMemory bufferMemory);
+    void destroyImage(VkImage image, VkDeviceMemory imageMemory);
+
+    // Command buffer allocation, counted per pool; destroying the pool releases whatever it still holds.
+    VkResult allocateCommandBuffers(const VkCommandBufferAllocateInfo &allocInfo, VkCommandBuffer *commandBuffers);
+    void freeCommandBuffers(VkCommandPool pool, uint32_t count, const VkCommandBuffer *commandBuffers);
+    void destroyCommandPool(VkCommandPool pool);
+
+    // One-off command buffers for setup work; endSingleTimeCommands blocks until the GPU has finished.
+    VkCommandBuffer beginSingleTimeCommands();
+    void endSingleTimeCommands(VkCommandBuffer commandBuffer);
 
 };
@@ -0,0 +1,278 @@
+#include "VGeometryRegistry.hpp"
+#include "VBuffer.hpp"
+#include "VStagingRing.hpp"
+#include "VAsyncQueue.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+
+VMesh::~VMesh() = default;
+
+VGeometryRegistry::VGeometryRegistry(VDevice &device) : vDevice(device) {}
+
+VGeometryRegistry::~VGeometryRegistry() {
+    if (!meshes.empty()) {
+        std::cerr << "Warning: " << meshes.size() << " mesh(es) still referenced when the geometry registry was destroyed.\n";
+    }
+}
+
+uint64_t VGeometryRegistry::hashGeometry(const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices) {
+    // FNV-1a over the meaningful fields only; Vertex has padding bytes that must not leak into the hash.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void *data, std::size_t size) {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+
+    for (const auto &vertex : vertices) {
+        mix(&vertex.position.x, sizeof(float));
+        mix(&vertex.position.y, sizeof(float));
+        mix(&vertex.color, sizeof(uint32_t));
+    }
+
+    const uint64_t separator = vertices.size();
+    mix(&separator, sizeof(separator));
+    if (!indices.empty()) {
+        mix(indices.data(), indices.size() * sizeof(uint32_t));
+    }
+
+    return hash;
+}
+
+bool VGeometryRegistry::sameGeometry(const Entry &entry, const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices) {
+    if (entry.vertices.size() != vertices.size() || entry.indices != indices) {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < vertices.size(); ++i) {
+        if (entry.vertices[i].position != vertices[i].position || entry.vertices[i].color != vertices[i].color) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::unique_ptr<VMesh> VGeometryRegistry::createMesh(const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices) {
+    auto mesh = std::make_unique<VMesh>();
+    mesh->vertexCount = static_cast<uint32_t>(vertices.size());
+    mesh->indexCount = static_cast<uint32_t>(indices.size());
+
+    if (mesh->vertexCount > 0) {
+        mesh->vertexBuffer = std::make_unique<VBuffer>(
+            vDevice,
+            sizeof(vertices[0]),
+            mesh->vertexCount,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+
+        mesh->vertexBuffer->map();
+        mesh->vertexBuffer->writeToBuffer(const_cast<Primitives::Vertex *>(vertices.data()));
+        mesh->vertexBuffer->unmap();
+    }
+
+    if (mesh->indexCount > 0) {
+        mesh->indexBuffer = std::make_unique<VBuffer>(
+            vDevice,
+            sizeof(indices[0]),
+            mesh->indexCount,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+
+        mesh->indexBuffer->map();
+        mesh->indexBuffer->writeToBuffer(const_cast<uint32_t *>(indices.data()));
+        mesh->indexBuffer->unmap();
+    }
+
+    return mesh;
+}
+
+std::shared_ptr<const VMesh> VGeometryRegistry::acquire(const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices) {
+    const uint64_t hash = hashGeometry(vertices, indices);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++stats.acquires;
+
+    auto range = meshes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (!sameGeometry(it->second, vertices, indices)) {
+            continue;
+        }
+
+        // An expired handle means the last owner is releasing it right now; fall through and upload a fresh copy.
+        if (auto shared = it->second.handle.lock()) {
+            ++stats.hits;
+            return shared;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<VMesh> mesh = createMesh(vertices, indices);
+    stats.creationTime += std::chrono::steady_clock::now() - start;
+
+    mesh->hash = hash;
+    stats.liveMeshes++;
+    if (mesh->vertexBuffer) stats.liveBytes += mesh->vertexBuffer->getBufferSize();
+    if (mesh->indexBuffer) stats.liveBytes += mesh->indexBuffer->getBufferSize();
+
+    VMesh *raw = mesh.release();
+    std::shared_ptr<const VMesh> shared(raw, [this](const VMesh *m) { release(const_cast<VMesh *>(m)); });
+    meshes.emplace(hash, Entry{raw, shared, vertices, indices});
+    promotionQueue.push_back(PromotionCandidate{shared, frame});
+    return shared;
+}
+
+void VGeometryRegistry::release(VMesh *mesh) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto range = meshes.equal_range(mesh->hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.mesh == mesh) {
+                meshes.erase(it);
+                break;
+            }
+        }
+
+        stats.liveMeshes--;
+        if (mesh->deviceLocal) stats.deviceLocalMeshes--;
+        if (mesh->vertexBuffer) stats.liveBytes -= mesh->vertexBuffer->getBufferSize();
+        if (mesh->indexBuffer) stats.liveBytes -= mesh->indexBuffer->getBufferSize();
+
+        // Frames still in flight may draw with these buffers.
+        retire(std::move(mesh->vertexBuffer));
+        retire(std::move(mesh->indexBuffer));
+    }
+
+    delete mesh;
+}
+
+void VGeometryRegistry::retire(std::unique_ptr<VBuffer> buffer) {
+    if (buffer) {
+        retired[frameIndex].push_back(std::move(buffer));
+    }
+}
+
+void VGeometryRegistry::beginFrame(int newFrameIndex) {
+    std::vector<std::unique_ptr<VBuffer>> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        frameIndex = newFrameIndex;
+        ++frame;
+        finished.swap(retired[frameIndex]);
+    }
+}
+
+bool VGeometryRegistry::promoteMesh(VAsyncQueue &uploads, VStagingRing &ring, VMesh &mesh) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    const Entry *entry = nullptr;
+    auto range = meshes.equal_range(mesh.hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second.mesh == &mesh) {
+            entry = &it->second;
+            break;
+        }
+    }
+
+    if (!entry) {
+        throw std::runtime_error("Cannot promote a mesh the geometry registry does not own.");
+    }
+
+    const VkDeviceSize vertexBytes = sizeof(Primitives::Vertex) * mesh.vertexCount;
+    const VkDeviceSize indexBytes = sizeof(uint32_t) * mesh.indexCount;
+
+    // Both halves are staged before anything is copied, so a mesh is never left half promoted.
+    std::optional<VStagingRing::Allocation> vertexStaging;
+    std::optional<VStagingRing::Allocation> indexStaging;
+    if (mesh.vertexBuffer && !(vertexStaging = ring.allocate(vertexBytes, STAGING_ALIGNMENT))) {
+        return false;
+    }
+    if (mesh.indexBuffer && !(indexStaging = ring.allocate(indexBytes, STAGING_ALIGNMENT))) {
+        return false;
+    }
+
+    // The registry keeps the source geometry, so the host-visible buffers are never read back.
+    auto copyToDevice = [&](std::unique_ptr<VBuffer> &buffer, const VStagingRing::Allocation &staging, const void *data,
+                            VkDeviceSize instanceSize, uint32_t count, VkBufferUsageFlags usage, VkAccessFlags access) {
+        const VkDeviceSize size = instanceSize * count;
+        std::memcpy(staging.data, data, size);
+
+        auto local = std::make_unique<VBuffer>(vDevice, instanceSize, count, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        VkBufferCopy region {staging.offset, 0, size};
+        vkCmdCopyBuffer(uploads.getCommandBuffer(), staging.buffer, local->getBuffer(), 1, &region);
+        uploads.finishBuffer(local->getBuffer(), access, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+        stats.liveBytes += local->getBufferSize();
+        stats.liveBytes -= buffer->getBufferSize();
+        stats.promotedBytes += size;
+        retire(std::move(buffer));
+        buffer = std::move(local);
+    };
+
+    if (vertexStaging) {
+        copyToDevice(mesh.vertexBuffer, *vertexStaging, entry->vertices.data(), sizeof(Primitives::Vertex), mesh.vertexCount,
+                     VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+    }
+    if (indexStaging) {
+        copyToDevice(mesh.indexBuffer, *indexStaging, entry->indices.data(), sizeof(uint32_t), mesh.indexCount,
+                     VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_ACCESS_INDEX_READ_BIT);
+    }
+
+    mesh.deviceLocal = true;
+    stats.deviceLocalMeshes++;
+    return true;
+}
+
+bool VGeometryRegistry::promote(VAsyncQueue &uploads, VStagingRing &ring) {
+    // Holding references keeps the due meshes alive while they are copied. Every reference locked here,
+    // including those of meshes that are skipped, is dropped only after the mutex is released: a concurrent
+    // drop may have left it the last one, and destroying that re-enters the registry through release().
+    std::vector<std::shared_ptr<const VMesh>> due;
+    std::vector<std::shared_ptr<const VMesh>> skipped;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        VkDeviceSize budget = PROMOTION_BUDGET_PER_FRAME;
+        while (!promotionQueue.empty() && frame - promotionQueue.front().createdFrame >= PROMOTE_AFTER_FRAMES) {
+            auto shared = promotionQueue.front().handle.lock();
+            const VkDeviceSize bytes = shared ? sizeof(Primitives::Vertex) * shared->vertexCount + sizeof(uint32_t) * shared->indexCount : 0;
+
+            // Meshes too large for the ring stay host-visible rather than blocking the queue forever.
+            if (shared && bytes + 2 * STAGING_ALIGNMENT <= ring.getCapacity()) {
+                if (bytes > budget && !due.empty()) {
+                    skipped.push_back(std::move(shared));
+                    break;
+                }
+                budget -= std::min(budget, bytes);
+                due.push_back(std::move(shared));
+            } else if (shared) {
+                skipped.push_back(std::move(shared));
+            }
+            promotionQueue.pop_front();
+        }
+    }
+    skipped.clear();
+
+    std::size_t promoted = 0;
+    for (; promoted < due.size(); ++promoted) {
+        if (!promoteMesh(uploads, ring, const_cast<VMesh &>(*due[promoted]))) {
+            break;
+        }
+    }
+
+    // Meshes that did not fit in the ring this frame are retried first next frame.
+    if (promoted < due.size()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t i = due.size(); i-- > promoted;) {
+            promotionQueue.push_front(PromotionCandidate{due[i], 0});
+        }
+    }
+
+    return promoted > 0;
+}
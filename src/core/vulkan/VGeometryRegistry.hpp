@@ -0,0 +1,104 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VSwapChain.hpp"
+#include "core/ui/Primitives.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class VBuffer;
+class VStagingRing;
+class VAsyncQueue;
+
+// An immutable vertex/index buffer pair shared by every primitive with identical geometry.
+struct VMesh {
+    std::unique_ptr<VBuffer> vertexBuffer;
+    std::unique_ptr<VBuffer> indexBuffer;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    uint64_t hash = 0;
+    bool deviceLocal = false; // Set once the mesh has been promoted out of host-visible memory.
+
+    ~VMesh();
+};
+
+// Aggregate counters describing how much sharing the geometry registry achieves.
+struct VGeometryStats {
+    uint64_t acquires = 0;
+    uint64_t hits = 0;
+    uint32_t liveMeshes = 0;
+    VkDeviceSize liveBytes = 0;
+    uint32_t deviceLocalMeshes = 0;
+    VkDeviceSize promotedBytes = 0;
+    std::chrono::nanoseconds creationTime{0};
+};
+
+// Deduplicates meshes by content hash and reference-counts them, so identical shapes are uploaded once.
+// New meshes start in host-visible memory; those that survive a while are copied into device-local memory.
+class VGeometryRegistry {
+
+private:
+    struct Entry {
+        VMesh *mesh;
+        std::weak_ptr<const VMesh> handle;
+        std::vector<Primitives::Vertex> vertices;
+        std::vector<uint32_t> indices;
+    };
+
+    struct PromotionCandidate {
+        std::weak_ptr<const VMesh> handle;
+        uint64_t createdFrame;
+    };
+
+    // Meshes younger than this are assumed to be transient, e.g. shapes edited every frame.
+    static constexpr uint64_t PROMOTE_AFTER_FRAMES = 30;
+    static constexpr VkDeviceSize PROMOTION_BUDGET_PER_FRAME = 8 * 1024 * 1024;
+    static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    static uint64_t hashGeometry(const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices);
+    static bool sameGeometry(const Entry &entry, const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices);
+
+    std::unique_ptr<VMesh> createMesh(const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices);
+    void release(VMesh *mesh);
+    bool promoteMesh(VAsyncQueue &uploads, VStagingRing &ring, VMesh &mesh);
+    void retire(std::unique_ptr<VBuffer> buffer);
+
+    VDevice &vDevice;
+    std::mutex mutex;
+    std::unordered_multimap<uint64_t, Entry> meshes;
+    VGeometryStats stats;
+
+    uint64_t frame = 0;
+    int frameIndex = 0;
+    std::deque<PromotionCandidate> promotionQueue;
+    // Buffers that recorded command buffers may still read; freed when their frame slot comes round again.
+    std::array<std::vector<std::unique_ptr<VBuffer>>, VSwapChain::MAX_FRAMES_IN_FLIGHT> retired;
+
+
+public:
+    explicit VGeometryRegistry(VDevice &device);
+    ~VGeometryRegistry();
+
+    VGeometryRegistry(const VGeometryRegistry &) = delete;
+    VGeometryRegistry &operator=(const VGeometryRegistry &) = delete;
+
+    // Returns the shared mesh for this geometry, uploading it only if no live copy exists.
+    std::shared_ptr<const VMesh> acquire(const std::vector<Primitives::Vertex> &vertices, const std::vector<uint32_t> &indices);
+
+    // Frees buffers retired the last time this frame slot was used. Call once the slot's fence has been waited on.
+    void beginFrame(int frameIndex);
+
+    // Records copies of long-lived meshes into device-local buffers. Returns true if any mesh moved,
+    // in which case previously recorded command buffers reference stale buffers.
+    bool promote(VAsyncQueue &uploads, VStagingRing &ring);
+
+    VGeometryStats getStats();
+    VDevice &device() { return vDevice; }
+
+};
@@ -0,0 +1,163 @@
+#include "VGpuTimer.hpp"
+#include "util/Profiler.hpp"
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+VGpuTimer::VGpuTimer(VDevice &device, uint32_t scopeCount, std::optional<uint32_t> family)
+    : vDevice(device), scopeCount(scopeCount), names(scopeCount), milliseconds(scopeCount) {
+    for (uint32_t i = 0; i < scopeCount; ++i) {
+        names[i] = "GPU scope " + std::to_string(i);
+    }
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vDevice.physicalDevice(), &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(vDevice.physicalDevice(), &familyCount, families.data());
+
+    const uint32_t graphicsFamily = vDevice.queueFamilies().graphicsFamily.value();
+    const uint32_t timedFamily = family.value_or(graphicsFamily);
+    graphics = timedFamily == graphicsFamily;
+    const std::string queue = graphics ? "The graphics queue" : "Queue family " + std::to_string(timedFamily);
+
+    const uint32_t validBits = families[timedFamily].timestampValidBits;
+    if (validBits == 0) {
+        std::cerr << "Warning: " << queue << " does not support timestamps; its GPU timings are unavailable.\n";
+        return;
+    }
+    if (!graphics && !vDevice.features().hostQueryReset) {
+        std::cerr << "Warning: " << queue << " needs host query reset for timestamps; its GPU timings are unavailable.\n";
+        return;
+    }
+
+    validMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t{1} << validBits) - 1;
+    nanosecondsPerTick = vDevice.getPhysicalDeviceProperties().limits.timestampPeriod;
+
+    VkQueryPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = scopeCount * 2,
+    };
+
+    for (VkQueryPool &pool : pools) {
+        if (vkCreateQueryPool(vDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create timestamp query pool.");
+        }
+    }
+
+#ifdef IRO_PROFILE
+    // The calibration submission runs on the graphics queue, so only its timer can be placed on the CPU timeline.
+    if (graphics) {
+        calibrate();
+    }
+#endif
+}
+
+VGpuTimer::~VGpuTimer() {
+    for (VkQueryPool pool : pools) {
+        if (pool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(vDevice.device(), pool, nullptr);
+        }
+    }
+}
+
+void VGpuTimer::setScopeName(uint32_t scope, std::string name) {
+    names[scope] = std::move(name);
+}
+
+void VGpuTimer::calibrate() {
+    // A timestamp written by a one-off submission lies between the CPU times taken around it; the tightest
+    // of a few tries gives the offset between the two clocks to within a fraction of a submission.
+    int64_t bestSpan = std::numeric_limits<int64_t>::max();
+    for (int attempt = 0; attempt < 5; ++attempt) {
+        VkCommandBuffer commandBuffer = vDevice.beginSingleTimeCommands();
+        vkCmdResetQueryPool(commandBuffer, pools[0], 0, 1);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pools[0], 0);
+
+        const int64_t before = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        vDevice.endSingleTimeCommands(commandBuffer);
+        const int64_t after = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        uint64_t ticks = 0;
+        if (vkGetQueryPoolResults(vDevice.device(), pools[0], 0, 1, sizeof(ticks), &ticks, sizeof(ticks), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+            continue;
+        }
+
+        const int64_t gpu = static_cast<int64_t>(static_cast<double>(ticks & validMask) * nanosecondsPerTick);
+        if (after - before < bestSpan) {
+            bestSpan = after - before;
+            gpuToCpuOffset = before + (after - before) / 2 - gpu;
+            calibrated = true;
+        }
+    }
+}
+
+void VGpuTimer::beginFrame(int index, VkCommandBuffer commandBuffer) {
+    if (!isSupported()) {
+        return;
+    }
+
+    if (submitted[index]) {
+        collect(index);
+    }
+
+    frameIndex = index;
+    if (commandBuffer == VK_NULL_HANDLE) {
+        vkResetQueryPool(vDevice.device(), pools[index], 0, scopeCount * 2);
+    } else {
+        vkCmdResetQueryPool(commandBuffer, pools[index], 0, scopeCount * 2);
+    }
+    submitted[index] = true;
+}
+
+void VGpuTimer::collect(int index) {
+    // Each query yields its value followed by its availability; scopes not recorded that frame stay unavailable.
+    struct Result {
+        uint64_t value;
+        uint64_t available;
+    };
+    std::vector<Result> results(scopeCount * 2);
+
+    const VkResult status = vkGetQueryPoolResults(vDevice.device(), pools[index], 0, scopeCount * 2, results.size() * sizeof(Result),
+                                                  results.data(), sizeof(Result), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (status != VK_SUCCESS && status != VK_NOT_READY) {
+        return;
+    }
+
+#ifdef IRO_PROFILE
+    Profiler::Track &trace = Profiler::track("GPU");
+#endif
+
+    for (uint32_t scope = 0; scope < scopeCount; ++scope) {
+        const Result &begin = results[scope * 2];
+        const Result &end = results[scope * 2 + 1];
+        if (!begin.available || !end.available) {
+            milliseconds[scope].reset();
+            continue;
+        }
+
+        const uint64_t ticks = ((end.value & validMask) - (begin.value & validMask)) & validMask;
+        milliseconds[scope] = static_cast<double>(ticks) * nanosecondsPerTick / 1.0e6;
+
+#ifdef IRO_PROFILE
+        if (!calibrated) {
+            continue;
+        }
+        const uint64_t start = static_cast<uint64_t>(static_cast<double>(begin.value & validMask) * nanosecondsPerTick + gpuToCpuOffset);
+        trace.record(Profiler::intern(names[scope]), start, start + static_cast<uint64_t>(static_cast<double>(ticks) * nanosecondsPerTick));
+#endif
+    }
+}
+
+void VGpuTimer::begin(VkCommandBuffer commandBuffer, uint32_t scope) const {
+    if (isSupported()) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pools[frameIndex], scope * 2);
+    }
+}
+
+void VGpuTimer::end(VkCommandBuffer commandBuffer, uint32_t scope) const {
+    if (isSupported()) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pools[frameIndex], scope * 2 + 1);
+    }
+}
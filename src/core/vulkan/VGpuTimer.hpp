@@ -0,0 +1,67 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VSwapChain.hpp"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// GPU timestamps around numbered scopes. Each frame slot owns a query pool with a begin and end query per
+// scope; a slot's results are read when the slot comes around again, after its fence has been waited on,
+// so reading them never stalls. Scopes that were not recorded in a frame simply have no result.
+//
+// Timers for the graphics queue reset their queries in the frame's primary. Timers for another family (the
+// transfer queue, which cannot reset queries in its own commands) reset them from the host instead.
+class VGpuTimer {
+
+private:
+    void calibrate();
+    void collect(int frameIndex);
+
+    VDevice &vDevice;
+    bool graphics = true;
+    std::array<VkQueryPool, VSwapChain::MAX_FRAMES_IN_FLIGHT> pools {};
+    std::array<bool, VSwapChain::MAX_FRAMES_IN_FLIGHT> submitted {};
+    uint32_t scopeCount;
+    std::vector<std::string> names;
+    int frameIndex = 0;
+
+    double nanosecondsPerTick = 0.0;
+    uint64_t validMask = 0;
+    // Added to a GPU time in nanoseconds to place it on the steady_clock timeline of CPU profiler zones.
+    int64_t gpuToCpuOffset = 0;
+    bool calibrated = false;
+
+    // From the most recently collected frame.
+    std::vector<std::optional<double>> milliseconds;
+
+
+public:
+    // Times work on `family`, the graphics family by default.
+    VGpuTimer(VDevice &device, uint32_t scopeCount, std::optional<uint32_t> family = std::nullopt);
+    ~VGpuTimer();
+
+    VGpuTimer(const VGpuTimer &) = delete;
+    VGpuTimer &operator=(const VGpuTimer &) = delete;
+
+    // False when the queue has no timestamp support, or cannot have its queries reset; every other call is then a no-op.
+    bool isSupported() const { return pools[0] != VK_NULL_HANDLE; }
+
+    // Names the scope in traces.
+    void setScopeName(uint32_t scope, std::string name);
+
+    // Reads the results this slot produced last time round and resets its queries. Call once the slot's fence
+    // has been waited on, with the frame's primary command buffer before any render pass begins, or with
+    // VK_NULL_HANDLE to reset from the host when the timer is not on the graphics family.
+    void beginFrame(int frameIndex, VkCommandBuffer commandBuffer);
+
+    // Write the scope's timestamps into this frame's pool. Safe from worker threads, each with its own command buffer.
+    void begin(VkCommandBuffer commandBuffer, uint32_t scope) const;
+    void end(VkCommandBuffer commandBuffer, uint32_t scope) const;
+
+    uint32_t getScopeCount() const { return scopeCount; }
+    std::optional<double> getMilliseconds(uint32_t scope) const { return milliseconds[scope]; }
+
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "VDevice.hpp"
+
+// A device-local 2D image with its memory and a default color view.
+class VImage {
+
+private:
+    VDevice &vDevice;
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+
+    VkExtent2D extent;
+    VkFormat format;
+
+
+public:
+    VImage(VDevice &device, VkExtent2D extent, VkFormat format, VkImageUsageFlags usage);
+    ~VImage();
+
+    VImage(const VImage &) = delete;
+    VImage &operator=(const VImage &) = delete;
+
+    // Records a full-image layout transition with conservative stage and access masks.
+    void transitionLayout(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+    VkImage getImage() const { return image; }
+    VkImageView getView() const { return view; }
+    VkExtent2D getExtent() const { return extent; }
+    VkFormat getFormat() const { return format; }
+
+};
@@ -0,0 +1,97 @@
+#include "VInstanceTable.hpp"
+#include "VBuffer.hpp"
+#include <cstring>
+#include <stdexcept>
+
+VInstanceTable::VInstanceTable(VDevice &device) : vDevice(device) {
+    VkDescriptorSetLayoutBinding binding {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+
+    if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create instance table descriptor set layout.");
+    }
+
+    VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VSwapChain::MAX_FRAMES_IN_FLIGHT};
+    VkDescriptorPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .maxSets = VSwapChain::MAX_FRAMES_IN_FLIGHT,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+
+    if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create instance table descriptor pool.");
+    }
+
+    for (int i = 0; i < VSwapChain::MAX_FRAMES_IN_FLIGHT; ++i) {
+        buffers[i] = std::make_unique<VBuffer>(
+            vDevice,
+            sizeof(InstanceRecord),
+            CAPACITY,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        buffers[i]->map();
+
+        VkDescriptorSetAllocateInfo allocInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .descriptorPool = descriptorPool,
+            .descriptorSetCount = 1,
+            .pSetLayouts = &descriptorSetLayout,
+        };
+
+        if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &descriptorSets[i]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate instance table descriptor set.");
+        }
+
+        VkDescriptorBufferInfo bufferInfo = buffers[i]->descriptorInfo();
+        VkWriteDescriptorSet write {
+            .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+            .dstSet = descriptorSets[i],
+            .dstBinding = 0,
+            .descriptorCount = 1,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .pBufferInfo = &bufferInfo,
+        };
+        vkUpdateDescriptorSets(vDevice.device(), 1, &write, 0, nullptr);
+    }
+}
+
+VInstanceTable::~VInstanceTable() {
+    vkDestroyDescriptorPool(vDevice.device(), descriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(vDevice.device(), descriptorSetLayout, nullptr);
+}
+
+uint32_t VInstanceTable::allocate() {
+    std::lock_guard<std::mutex> lock(handlesMutex);
+    if (!freeHandles.empty()) {
+        const uint32_t handle = freeHandles.back();
+        freeHandles.pop_back();
+        return handle;
+    }
+
+    if (nextHandle == CAPACITY) {
+        throw std::runtime_error("Instance table is full.");
+    }
+    return nextHandle++;
+}
+
+void VInstanceTable::release(uint32_t handle) {
+    std::lock_guard<std::mutex> lock(handlesMutex);
+    freeHandles.push_back(handle);
+}
+
+void VInstanceTable::write(int frameIndex, uint32_t handle, const InstanceRecord &record) {
+    auto *records = static_cast<InstanceRecord *>(buffers[frameIndex]->getMappedMemory());
+    std::memcpy(&records[handle], &record, sizeof(InstanceRecord));
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VSwapChain.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class VBuffer;
+
+// One primitive's draw parameters as the bindless shaders read them (std430, 40 bytes).
+struct InstanceRecord {
+    glm::vec2 position{0.0f, 0.0f};
+    glm::vec2 scale{1.0f, 1.0f};
+    uint32_t colors[4]{};
+    uint32_t textureIndex = 0; // Into the bindless texture array; 0 is the white fallback.
+    uint32_t flags = 0;
+
+    static constexpr uint32_t BILINEAR = 1u << 0;
+    static constexpr uint32_t INSTANCE_COLORS = 1u << 1;
+};
+static_assert(sizeof(InstanceRecord) == 40, "InstanceRecord must match the std430 layout in ui.vert and ui.frag.");
+
+// Per-instance data for bindless drawing: a storage buffer of InstanceRecords per frame slot, addressed by
+// small integer handles. A draw passes its handle as firstInstance, so it needs no push constants.
+class VInstanceTable {
+
+private:
+    VDevice &vDevice;
+    std::array<std::unique_ptr<VBuffer>, VSwapChain::MAX_FRAMES_IN_FLIGHT> buffers;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    std::array<VkDescriptorSet, VSwapChain::MAX_FRAMES_IN_FLIGHT> descriptorSets{};
+
+    std::mutex handlesMutex;
+    std::vector<uint32_t> freeHandles;
+    uint32_t nextHandle = 0;
+
+
+public:
+    // Records per frame slot (40 bytes each); room for the 100k-primitive benchmark scenes.
+    static constexpr uint32_t CAPACITY = 1u << 17;
+
+    explicit VInstanceTable(VDevice &device);
+    ~VInstanceTable();
+
+    VInstanceTable(const VInstanceTable &) = delete;
+    VInstanceTable &operator=(const VInstanceTable &) = delete;
+
+    // Handles are reused once released. Both are safe to call from recording jobs.
+    uint32_t allocate();
+    void release(uint32_t handle);
+
+    // Writes the record for this frame slot. Jobs may write concurrently as long as their handles differ.
+    void write(int frameIndex, uint32_t handle, const InstanceRecord &record);
+
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    VkDescriptorSet getDescriptorSet(int frameIndex) const { return descriptorSets[frameIndex]; }
+
+};
@@ -0,0 +1,184 @@
+#include "VPerfOverlay.hpp"
+#include "VBuffer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+
+namespace {
+
+// AABBGGRR, like every other color the renderer passes around.
+constexpr uint32_t BACKGROUND = 0xC0202020;
+constexpr uint32_t TEXT = 0xFFFFFFFF;
+constexpr uint32_t GUIDE = 0x80FFFFFF;
+constexpr uint32_t FAST = 0xFF50C850;
+constexpr uint32_t SLOW = 0xFF32C8E6;
+constexpr uint32_t HITCH = 0xFF3C46E6;
+constexpr uint32_t GPU = 0xFFF0A050;
+
+constexpr double MEBIBYTE = 1024.0 * 1024.0;
+constexpr float FRAME_60HZ = 1000.0f / 60.0f;
+
+}
+
+VPerfOverlay::VPerfOverlay(VDevice &device, TextRenderer &text) : vDevice(device), textRenderer(text) {}
+
+VPerfOverlay::~VPerfOverlay() = default;
+
+void VPerfOverlay::initialize() {
+    try {
+        font = textRenderer.getFonts().load("monospace");
+    } catch (const std::exception &e) {
+        std::cerr << "Warning: The performance overlay has no font (" << e.what() << "); it stays hidden.\n";
+        enabled = false;
+        return;
+    }
+
+    std::string printable;
+    for (char c = ' '; c <= '~'; ++c) {
+        printable.push_back(c);
+    }
+    textRenderer.pinGlyphs(*font, printable);
+
+    instances.reserve(MAX_INSTANCES);
+    for (auto &buffer : buffers) {
+        buffer = std::make_unique<VBuffer>(
+            vDevice,
+            sizeof(GlyphInstance),
+            MAX_INSTANCES,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+        );
+        buffer->map();
+    }
+}
+
+void VPerfOverlay::record(const PerfSample &sample) {
+    latest = sample;
+    cpuHistory[historyNext] = static_cast<float>(sample.cpuMilliseconds);
+    gpuHistory[historyNext] = static_cast<float>(sample.gpuMilliseconds.value_or(0.0));
+    historyNext = (historyNext + 1) % HISTORY;
+}
+
+void VPerfOverlay::addRect(float x0, float y0, float x1, float y1, uint32_t color) {
+    if (instances.size() < MAX_INSTANCES) {
+        instances.push_back(GlyphInstance {
+            .rect = {x0, y0, x1, y1},
+            .uv = textRenderer.getAtlas().solidRegion(),
+            .color = color,
+        });
+    }
+}
+
+float VPerfOverlay::addText(float x, float y, const char *text, uint32_t color) {
+    const GlyphAtlas &atlas = textRenderer.getAtlas();
+    const float scale = TEXT_SIZE / static_cast<float>(FontLibrary::BASE_SIZE);
+    const float baseline = y + textRenderer.getFonts().getMetrics(*font).ascender * scale;
+
+    for (const char *c = text; *c; ++c) {
+        const uint64_t key = makeGlyphKey(*font, static_cast<char32_t>(static_cast<unsigned char>(*c)));
+        const GlyphMetrics *metrics = atlas.findMetrics(key);
+        if (!metrics) {
+            continue;
+        }
+
+        glm::vec4 uv;
+        if (atlas.findRegion(key, uv) && instances.size() < MAX_INSTANCES) {
+            const glm::vec2 topLeft = glm::vec2(x, baseline) + metrics->bearing * scale;
+            const glm::vec2 bottomRight = topLeft + metrics->size * scale;
+            instances.push_back(GlyphInstance {
+                .rect = {topLeft.x, topLeft.y, bottomRight.x, bottomRight.y},
+                .uv = uv,
+                .color = color,
+            });
+        }
+        x += metrics->advance * scale;
+    }
+    return x;
+}
+
+std::optional<AABB> VPerfOverlay::prepare(int frameIndex) {
+    if (enabled && !font) {
+        initialize();
+    }
+
+    counts[frameIndex] = 0;
+    const float width = PADDING * 2.0f + HISTORY * BAR_WIDTH;
+    const float lineHeight = font ? textRenderer.getFonts().getMetrics(*font).lineHeight * TEXT_SIZE / static_cast<float>(FontLibrary::BASE_SIZE) : 0.0f;
+    const float height = PADDING * 3.0f + GRAPH_HEIGHT + TEXT_LINES * lineHeight;
+    const AABB bounds {{MARGIN, MARGIN}, {MARGIN + width, MARGIN + height}};
+
+    if (!enabled) {
+        return std::exchange(shown, false) ? std::optional<AABB>(bounds) : std::nullopt;
+    }
+    shown = true;
+
+    instances.clear();
+    addRect(bounds.min.x, bounds.min.y, bounds.max.x, bounds.max.y, BACKGROUND);
+
+    // Oldest frame on the left; CPU bars colored by how close they come to a missed 60 Hz frame, GPU time inset.
+    const float graphLeft = MARGIN + PADDING;
+    const float graphBottom = MARGIN + PADDING + GRAPH_HEIGHT;
+    auto barHeight = [](float milliseconds) { return std::min(milliseconds / GRAPH_MILLISECONDS, 1.0f) * GRAPH_HEIGHT; };
+
+    for (uint32_t i = 0; i < HISTORY; ++i) {
+        const uint32_t entry = (historyNext + i) % HISTORY;
+        const float x = graphLeft + static_cast<float>(i) * BAR_WIDTH;
+        const float cpu = cpuHistory[entry];
+        const uint32_t color = cpu <= FRAME_60HZ ? FAST : cpu <= 2.0f * FRAME_60HZ ? SLOW : HITCH;
+        if (cpu > 0.0f) {
+            addRect(x, graphBottom - barHeight(cpu), x + BAR_WIDTH, graphBottom, color);
+        }
+        if (gpuHistory[entry] > 0.0f) {
+            addRect(x, graphBottom - barHeight(gpuHistory[entry]), x + BAR_WIDTH * 0.5f, graphBottom, GPU);
+        }
+    }
+    const float guide = graphBottom - barHeight(FRAME_60HZ);
+    addRect(graphLeft, guide, graphLeft + HISTORY * BAR_WIDTH, guide + 1.0f, GUIDE);
+
+    // snprintf into a fixed buffer keeps the text free of allocations.
+    char line[128];
+    float y = graphBottom + PADDING;
+
+    if (latest.gpuMilliseconds) {
+        std::snprintf(line, sizeof(line), "CPU %5.2f ms  GPU %5.2f ms", latest.cpuMilliseconds, *latest.gpuMilliseconds);
+    } else {
+        std::snprintf(line, sizeof(line), "CPU %5.2f ms  GPU n/a", latest.cpuMilliseconds);
+    }
+    addText(graphLeft, y, line, TEXT);
+    y += lineHeight;
+
+    std::snprintf(line, sizeof(line), "Draws %u  rec %u  reuse %u", latest.drawCalls, latest.primitivesRecorded, latest.primitivesReused);
+    addText(graphLeft, y, line, TEXT);
+    y += lineHeight;
+
+    // Transfer time shares the short workers line, so the panel keeps its width.
+    if (latest.transferMilliseconds) {
+        std::snprintf(line, sizeof(line), "Workers %3.0f%% busy  xfer %5.2f ms", latest.workerUtilization * 100.0, *latest.transferMilliseconds);
+    } else {
+        std::snprintf(line, sizeof(line), "Workers %3.0f%% busy", latest.workerUtilization * 100.0);
+    }
+    addText(graphLeft, y, line, TEXT);
+    y += lineHeight;
+
+    if (latest.gpuMemoryBudget) {
+        std::snprintf(line, sizeof(line), "GPU mem %.1f of %.0f MiB", static_cast<double>(latest.gpuMemory) / MEBIBYTE,
+                      static_cast<double>(*latest.gpuMemoryBudget) / MEBIBYTE);
+    } else {
+        std::snprintf(line, sizeof(line), "GPU mem %.1f MiB", static_cast<double>(latest.gpuMemory) / MEBIBYTE);
+    }
+    addText(graphLeft, y, line, TEXT);
+
+    // The slot's previous frame has been waited on, so its buffer is free to overwrite.
+    std::memcpy(buffers[frameIndex]->getMappedMemory(), instances.data(), instances.size() * sizeof(GlyphInstance));
+    counts[frameIndex] = static_cast<uint32_t>(instances.size());
+    return bounds;
+}
+
+void VPerfOverlay::draw(VkCommandBuffer commandBuffer, int frameIndex, VkExtent2D extent) {
+    if (hasContent(frameIndex)) {
+        textRenderer.drawInstances(commandBuffer, *buffers[frameIndex], counts[frameIndex], extent);
+    }
+}
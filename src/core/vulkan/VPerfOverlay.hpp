@@ -0,0 +1,90 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VSwapChain.hpp"
+#include "core/text/TextRenderer.hpp"
+#include "core/ui/SpatialIndex.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+class VBuffer;
+
+// One frame's figures for the overlay.
+struct PerfSample {
+    double cpuMilliseconds = 0.0;
+    std::optional<double> gpuMilliseconds;
+    std::optional<double> transferMilliseconds; // Uploads on a dedicated transfer queue, beside the frame.
+    uint32_t drawCalls = 0;
+    uint32_t primitivesRecorded = 0; // Drawn from secondaries recorded this frame...
+    uint32_t primitivesReused = 0;   // ...and from cached ones replayed as they were.
+    double workerUtilization = 0.0;  // 0..1, over every job worker.
+    VkDeviceSize gpuMemory = 0;      // Live device memory the engine allocated.
+    std::optional<VkDeviceSize> gpuMemoryBudget;
+};
+
+// A performance HUD in the top-left corner: a frame-time graph, the CPU/GPU split, draw calls, secondary
+// reuse, worker utilization and GPU memory. Text and bars are glyph instances drawn with the text pipeline,
+// so the whole overlay is one instanced draw. Its buffers are allocated when it is first shown and reused
+// after that, so a visible overlay costs no allocations per frame.
+class VPerfOverlay {
+
+private:
+    static constexpr uint32_t HISTORY = 120;
+    static constexpr uint32_t MAX_INSTANCES = 1024;
+    static constexpr float MARGIN = 8.0f;
+    static constexpr float PADDING = 6.0f;
+    static constexpr float BAR_WIDTH = 2.0f;
+    static constexpr float GRAPH_HEIGHT = 60.0f;
+    // The graph's full height, in milliseconds: two frames at 60 Hz.
+    static constexpr float GRAPH_MILLISECONDS = 1000.0f / 30.0f;
+    static constexpr float TEXT_SIZE = 13.0f;
+    static constexpr uint32_t TEXT_LINES = 4;
+
+    void initialize();
+    void addRect(float x0, float y0, float x1, float y1, uint32_t color);
+    // Places single-line text with its top at `y`; returns the pen position after the last glyph.
+    float addText(float x, float y, const char *text, uint32_t color);
+
+    VDevice &vDevice;
+    TextRenderer &textRenderer;
+    std::optional<FontId> font;
+    bool enabled = false;
+    bool shown = false; // Whether the previous frame drew it, so hiding it can erase it.
+
+    std::array<float, HISTORY> cpuHistory {};
+    std::array<float, HISTORY> gpuHistory {};
+    uint32_t historyNext = 0;
+    PerfSample latest;
+
+    std::vector<GlyphInstance> instances;
+    std::array<std::unique_ptr<VBuffer>, VSwapChain::MAX_FRAMES_IN_FLIGHT> buffers;
+    std::array<uint32_t, VSwapChain::MAX_FRAMES_IN_FLIGHT> counts {};
+
+
+public:
+    VPerfOverlay(VDevice &device, TextRenderer &text);
+    ~VPerfOverlay();
+
+    VPerfOverlay(const VPerfOverlay &) = delete;
+    VPerfOverlay &operator=(const VPerfOverlay &) = delete;
+
+    void setEnabled(bool enable) { enabled = enable; }
+    void toggle() { enabled = !enabled; }
+    bool isEnabled() const { return enabled; }
+
+    // Adds a frame to the graph and makes it the one the text describes.
+    void record(const PerfSample &sample);
+
+    // Writes this frame's instances. Call after the text renderer's prepare, which makes the glyphs resident.
+    // Returns the window-pixel region to redraw: the overlay while shown, and once more after it is hidden.
+    std::optional<AABB> prepare(int frameIndex);
+
+    // Records the overlay's single draw; nothing when it is hidden.
+    void draw(VkCommandBuffer commandBuffer, int frameIndex, VkExtent2D extent);
+
+    bool hasContent(int frameIndex) const { return enabled && counts[frameIndex] > 0; }
+
+};
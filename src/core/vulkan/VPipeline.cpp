@@ -12,18 +12,56 @@ extern "C" {
     extern const unsigned int spirv_core_vert_len;
     extern const unsigned char spirv_core_frag[];
     extern const unsigned int spirv_core_frag_len;
+    extern const unsigned char spirv_sprite_frag[];
+    extern const unsigned int spirv_sprite_frag_len;
+    extern const unsigned char spirv_text_vert[];
+    extern const unsigned int spirv_text_vert_len;
+    extern const unsigned char spirv_text_frag[];
+    extern const unsigned int spirv_text_frag_len;
+    extern const unsigned char spirv_ui_vert[];
+    extern const unsigned int spirv_ui_vert_len;
+    extern const unsigned char spirv_ui_frag[];
+    extern const unsigned int spirv_ui_frag_len;
 }
 
 // Map shader names to their embedded byte data for easy lookup.
 static const std::map<std::string, std::pair<const unsigned char *, unsigned int>>
     shaderData = {
         {"core.vert", {spirv_core_vert, spirv_core_vert_len}},
-        {"core.frag", {spirv_core_frag, spirv_core_frag_len}}
+        {"core.frag", {spirv_core_frag, spirv_core_frag_len}},
+        {"sprite.frag", {spirv_sprite_frag, spirv_sprite_frag_len}},
+        {"text.vert", {spirv_text_vert, spirv_text_vert_len}},
+        {"text.frag", {spirv_text_frag, spirv_text_frag_len}},
+        {"ui.vert", {spirv_ui_vert, spirv_ui_vert_len}},
+        {"ui.frag", {spirv_ui_frag, spirv_ui_frag_len}}
     };
 
-VPipeline::VPipeline(VDevice &device, const std::string &vertShaderName, const std::string &fragShaderName, VkRenderPass renderPass)
+PipelineConfigInfo PipelineConfigInfo::primitives(const RenderTarget &target) {
+    auto attributeDescriptions = Primitives::Vertex::getAttributeDescriptions();
+
+    PipelineConfigInfo config {};
+    config.bindingDescriptions = {Primitives::Vertex::getBindingDescription()};
+    config.attributeDescriptions.assign(attributeDescriptions.begin(), attributeDescriptions.end());
+    config.pushConstantSize = sizeof(Primitives::PushConstantData);
+    config.target = target;
+    return config;
+}
+
+void PipelineConfigInfo::specialize(uint32_t constantId, uint32_t value) {
+    specializationEntries.push_back({
+        .constantID = constantId,
+        .offset = static_cast<uint32_t>(specializationData.size() * sizeof(uint32_t)),
+        .size = sizeof(uint32_t),
+    });
+    specializationData.push_back(value);
+}
+
+VPipeline::VPipeline(VDevice &device, const std::string &vertShaderName, const std::string &fragShaderName, const RenderTarget &target)
+    : VPipeline(device, vertShaderName, fragShaderName, PipelineConfigInfo::primitives(target)) {}
+
+VPipeline::VPipeline(VDevice &device, const std::string &vertShaderName, const std::string &fragShaderName, const PipelineConfigInfo &config)
     : vDevice(device) {
-    createGraphicsPipeline(vertShaderName, fragShaderName, renderPass);
+    createGraphicsPipeline(vertShaderName, fragShaderName, config);
 }
 
 VPipeline::~VPipeline() {
@@ -51,7 +89,7 @@ VkShaderModule VPipeline::createShaderModule(const std::vector<char> &code) {
     return shaderModule;
 }
 
-void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const std::string &fragShaderName, VkRenderPass renderPass) {
+void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const std::string &fragShaderName, const PipelineConfigInfo &config) {
     if (shaderData.find(vertShaderName) == shaderData.end() || shaderData.find(fragShaderName) == shaderData.end()) {
         throw std::runtime_error("Could not find shader: " + vertShaderName + " or " + fragShaderName);
     }
@@ -70,28 +108,36 @@ void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const
     );
     VkShaderModule fragShaderModule = createShaderModule(fragShaderCode);
 
+    VkSpecializationInfo specializationInfo {
+        .mapEntryCount = static_cast<uint32_t>(config.specializationEntries.size()),
+        .pMapEntries = config.specializationEntries.data(),
+        .dataSize = config.specializationData.size() * sizeof(uint32_t),
+        .pData = config.specializationData.data(),
+    };
+    const VkSpecializationInfo *specialization = config.specializationEntries.empty() ? nullptr : &specializationInfo;
+
     VkPipelineShaderStageCreateInfo vertShaderStageInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = VK_SHADER_STAGE_VERTEX_BIT,
         .module = vertShaderModule,
         .pName = "main",
+        .pSpecializationInfo = specialization,
     };
     VkPipelineShaderStageCreateInfo fragShaderStageInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
         .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
         .module = fragShaderModule,
         .pName = "main",
+        .pSpecializationInfo = specialization,
     };
     VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
 
-    auto bindingDescription = Primitives::Vertex::getBindingDescription();
-    auto attributeDescriptions = Primitives::Vertex::getAttributeDescriptions();
     VkPipelineVertexInputStateCreateInfo vertexInputInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-        .vertexBindingDescriptionCount = 1,
-        .pVertexBindingDescriptions = &bindingDescription,
-        .vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size()),
-        .pVertexAttributeDescriptions = attributeDescriptions.data(),
+        .vertexBindingDescriptionCount = static_cast<uint32_t>(config.bindingDescriptions.size()),
+        .pVertexBindingDescriptions = config.bindingDescriptions.data(),
+        .vertexAttributeDescriptionCount = static_cast<uint32_t>(config.attributeDescriptions.size()),
+        .pVertexAttributeDescriptions = config.attributeDescriptions.data(),
     };
 
     VkPipelineInputAssemblyStateCreateInfo inputAssembly {
@@ -152,11 +198,13 @@ void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const
     VkPushConstantRange pushConstantRange {};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     pushConstantRange.offset = 0;
-    pushConstantRange.size = sizeof(Primitives::PushConstantData);
+    pushConstantRange.size = config.pushConstantSize;
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .pushConstantRangeCount = 1,
+        .setLayoutCount = static_cast<uint32_t>(config.descriptorSetLayouts.size()),
+        .pSetLayouts = config.descriptorSetLayouts.data(),
+        .pushConstantRangeCount = config.pushConstantSize > 0 ? 1u : 0u,
         .pPushConstantRanges = &pushConstantRange,
     };
 
@@ -164,8 +212,16 @@ void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const
         throw std::runtime_error("Failed to create pipeline layout.");
     }
 
+    // Without a render pass, the pipeline only needs to know the format it renders into.
+    VkPipelineRenderingCreateInfo renderingInfo {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &config.target.colorFormat,
+    };
+
     VkGraphicsPipelineCreateInfo pipelineInfo {
         .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+        .pNext = config.target.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr,
         .stageCount = 2,
         .pStages = shaderStages,
         .pVertexInputState = &vertexInputInfo,
@@ -176,7 +232,7 @@ void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const
         .pColorBlendState = &colorBlending,
         .pDynamicState = &dynamicState,
         .layout = pipelineLayout,
-        .renderPass = renderPass,
+        .renderPass = config.target.renderPass,
         .subpass = 0,
     };
 
@@ -187,3 +243,26 @@ void VPipeline::createGraphicsPipeline(const std::string &vertShaderName, const
     vkDestroyShaderModule(vDevice.device(), fragShaderModule, nullptr);
     vkDestroyShaderModule(vDevice.device(), vertShaderModule, nullptr);
 }
+
+VPipelineVariants::VPipelineVariants(VDevice &device, std::string vertShaderName, std::string fragShaderName, PipelineConfigInfo config, uint32_t constantCount)
+    : vDevice(device), vertShaderName(std::move(vertShaderName)), fragShaderName(std::move(fragShaderName)),
+      baseConfig(std::move(config)), constantCount(constantCount) {}
+
+VPipeline &VPipelineVariants::get(uint32_t key) {
+    std::lock_guard<std::mutex> lock(variantsMutex);
+    auto &pipeline = variants[key];
+    if (!pipeline) {
+        PipelineConfigInfo config = baseConfig;
+        for (uint32_t id = 0; id < constantCount; ++id) {
+            config.specialize(id, (key >> id) & 1u);
+        }
+        pipeline = std::make_unique<VPipeline>(vDevice, vertShaderName, fragShaderName, config);
+    }
+    return *pipeline;
+}
+
+void VPipelineVariants::buildAll() {
+    for (uint32_t key = 0; key < (1u << constantCount); ++key) {
+        get(key);
+    }
+}
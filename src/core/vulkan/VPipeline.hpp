@@ -1,14 +1,35 @@
 #pragma once
 
 #include "VDevice.hpp"
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+// The parts of a graphics pipeline that differ between passes; everything else is shared state.
+struct PipelineConfigInfo {
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts;
+    uint32_t pushConstantSize = 0;
+    RenderTarget target;
+
+    // Specialization constants, applied to both stages; a stage ignores IDs it does not declare.
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    std::vector<uint32_t> specializationData;
+
+    void specialize(uint32_t constantId, uint32_t value);
+
+    // Configuration for drawing Primitives::Vertex geometry with Primitives::PushConstantData.
+    static PipelineConfigInfo primitives(const RenderTarget &target);
+};
+
 // Creates and manages a Vulkan graphics pipeline, including shader loading, vertex input descriptions, and pipeline state configuration.
 class VPipeline {
 
 private:
-    void createGraphicsPipeline(const std::string &vertShaderName, const std::string &fragShaderName, VkRenderPass renderPass);
+    void createGraphicsPipeline(const std::string &vertShaderName, const std::string &fragShaderName, const PipelineConfigInfo &config);
     VkShaderModule createShaderModule(const std::vector<char> &code);
 
     VDevice &vDevice;
@@ -17,7 +38,8 @@ private:
 
 
 public:
-    VPipeline(VDevice &device, const std::string &vertShaderName, const std::string &fragShaderName, VkRenderPass renderPass);
+    VPipeline(VDevice &device, const std::string &vertShaderName, const std::string &fragShaderName, const RenderTarget &target);
+    VPipeline(VDevice &device, const std::string &vertShaderName, const std::string &fragShaderName, const PipelineConfigInfo &config);
     ~VPipeline();
 
     VPipeline(const VPipeline &) = delete;
@@ -27,3 +49,32 @@ public:
     VkPipelineLayout getPipelineLayout() const { return pipelineLayout; }
 
 };
+
+// Specializations of one shader pair, built on first use and cached by key. Bit i of a key sets the
+// boolean specialization constant with ID i, so shaders drop branches on it at pipeline creation.
+class VPipelineVariants {
+
+private:
+    VDevice &vDevice;
+    std::string vertShaderName;
+    std::string fragShaderName;
+    PipelineConfigInfo baseConfig;
+    uint32_t constantCount;
+
+    std::mutex variantsMutex;
+    std::unordered_map<uint32_t, std::unique_ptr<VPipeline>> variants;
+
+
+public:
+    VPipelineVariants(VDevice &device, std::string vertShaderName, std::string fragShaderName, PipelineConfigInfo config, uint32_t constantCount);
+
+    VPipelineVariants(const VPipelineVariants &) = delete;
+    VPipelineVariants &operator=(const VPipelineVariants &) = delete;
+
+    // Safe to call from recording jobs; building a missing variant blocks the caller.
+    VPipeline &get(uint32_t key);
+
+    // Builds every variant up front so none is created mid-frame.
+    void buildAll();
+
+};
@@ -1,17 +1,39 @@
 #include "VRenderer.hpp"
 #include "VBuffer.hpp"
+#include "util/Profiler.hpp"
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <stdexcept>
+#include <string>
+
+VRenderer::VRenderer(VDevice &device, VSwapChain &swapChain, JobSystem &jobSystem, std::array<std::vector<ThreadCommandResources>, VSwapChain::MAX_FRAMES_IN_FLIGHT> &threadRes)
+    : vDevice(device), vSwapChain(swapChain), textRenderer(std::make_unique<TextRenderer>(device, jobSystem)),
+      overlay(std::make_unique<VPerfOverlay>(device, *textRenderer)),
+      stagingRing(std::make_unique<VStagingRing>(device, STAGING_RING_SIZE)),
+      uploads(std::make_unique<VAsyncQueue>(device, VAsyncQueue::Kind::Transfer)),
+      compute(std::make_unique<VAsyncQueue>(device, VAsyncQueue::Kind::Compute)),
+      textures(std::make_unique<VTextureCache>(device, jobSystem, *stagingRing)), engineThreadResources(threadRes) {
+    if (textures->isBindless()) {
+        instances = std::make_unique<VInstanceTable>(device);
+    }
+
+    // Batches never outnumber the workers that record them (see Engine::mainLoop).
+    gpuTimer = std::make_unique<VGpuTimer>(device, batchScope(jobSystem.workerCount()));
+    gpuTimer->setScopeName(GPU_SCOPE_DRAW, "Draw");
+    gpuTimer->setScopeName(GPU_SCOPE_CLEAR, "Damage clear");
+    gpuTimer->setScopeName(GPU_SCOPE_TEXT, "Text");
+    for (std::size_t batch = 0; batch < jobSystem.workerCount(); ++batch) {
+        gpuTimer->setScopeName(batchScope(batch), "Batch " + std::to_string(batch));
+    }
 
-VRenderer::VRenderer(VDevice &device, VSwapChain &swapChain, std::array<std::vector<ThreadCommandResources>, VSwapChain::MAX_FRAMES_IN_FLIGHT> &threadRes)
-    : vDevice(device), vSwapChain(swapChain), engineThreadResources(threadRes) {
     recreateSwapChain();
     createCommandPool();
     createCommandBuffers();
 }
 
 VRenderer::~VRenderer() {
-    vkDestroyCommandPool(vDevice.device(), commandPool, nullptr);
+    vDevice.destroyCommandPool(commandPool);
 }
 
 VkCommandBuffer VRenderer::getCurrentCommandBuffer() const {
@@ -37,11 +59,37 @@ void VRenderer::recreateSwapChain() {
 
     vSwapChain.recreate();
 
+    // With dynamic rendering, pipelines and recorded secondaries only depend on the image format, which
+    // normally survives recreation. A new render pass invalidates both.
+    const RenderTarget target = vSwapChain.getRenderTarget();
+    if (primitivePipelines && target == pipelineTarget) {
+        return;
+    }
+    pipelineTarget = target;
+
     for (auto &frameVec : engineThreadResources) // engineThreadResources is
         for (auto &res : frameVec)               // the array you already
             res.recorded = false;
 
-    vPipeline = std::make_unique<VPipeline>(vDevice, "core.vert", "core.frag", vSwapChain.getRenderPass());
+    textRenderer->createPipeline(target);
+
+    PipelineConfigInfo spriteConfig = PipelineConfigInfo::primitives(target);
+    spriteConfig.descriptorSetLayouts = {textures->getDescriptorSetLayout()};
+    primitivePipelines = std::make_unique<VPipelineVariants>(vDevice, "core.vert", "core.frag", PipelineConfigInfo::primitives(target), VARIANT_CONSTANTS);
+    spritePipelines = std::make_unique<VPipelineVariants>(vDevice, "core.vert", "sprite.frag", spriteConfig, VARIANT_CONSTANTS);
+
+    // Variants are only needed without the bindless path; build them now rather than while recording.
+    if (!instances) {
+        primitivePipelines->buildAll();
+        spritePipelines->buildAll();
+    }
+
+    if (instances) {
+        PipelineConfigInfo bindlessConfig = PipelineConfigInfo::primitives(target);
+        bindlessConfig.pushConstantSize = 0;
+        bindlessConfig.descriptorSetLayouts = {textures->getBindlessLayout(), instances->getDescriptorSetLayout()};
+        bindlessPipeline = std::make_unique<VPipeline>(vDevice, "ui.vert", "ui.frag", bindlessConfig);
+    }
 }
 
 void VRenderer::createCommandPool() {
@@ -64,12 +112,26 @@ void VRenderer::createCommandBuffers() {
     allocInfo.commandPool = commandPool;
     allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
 
-    if (vkAllocateCommandBuffers(vDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+    if (vDevice.allocateCommandBuffers(allocInfo, commandBuffers.data()) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate command buffers.");
     }
+
+    textCommandBuffers.resize(VSwapChain::MAX_FRAMES_IN_FLIGHT);
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+    allocInfo.commandBufferCount = static_cast<uint32_t>(textCommandBuffers.size());
+
+    if (vDevice.allocateCommandBuffers(allocInfo, textCommandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate text command buffers.");
+    }
+
+    clearCommandBuffers.resize(VSwapChain::MAX_FRAMES_IN_FLIGHT);
+    if (vDevice.allocateCommandBuffers(allocInfo, clearCommandBuffers.data()) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate clear command buffers.");
+    }
 }
 
 VkCommandBuffer VRenderer::beginFrame() {
+    IRO_PROFILE_ZONE("VRenderer::beginFrame");
     if(m_isFrameStarted) {
         throw std::runtime_error("Cannot call beginFrame while already in progress.");
     }
@@ -85,6 +147,9 @@ VkCommandBuffer VRenderer::beginFrame() {
     }
 
     m_isFrameStarted = true;
+    m_damage = {{0, 0}, vSwapChain.getExtent()};
+
+
     auto commandBuffer = getCurrentCommandBuffer();
     VkCommandBufferBeginInfo beginInfo {};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -93,6 +158,12 @@ VkCommandBuffer VRenderer::beginFrame() {
         throw std::runtime_error("Failed to begin recording command buffer.");
     }
 
+    // acquireNextImage waited on this slot's fence, so its staging space and transfer commands can be reused.
+    stagingRing->beginFrame(m_currentFrameIndex);
+    gpuTimer->beginFrame(m_currentFrameIndex, commandBuffer);
+    uploads->beginFrame(m_currentFrameIndex, commandBuffer);
+    compute->beginFrame(m_currentFrameIndex, commandBuffer);
+
     return commandBuffer;
 }
 
@@ -106,7 +177,14 @@ void VRenderer::endFrame() {
         throw std::runtime_error("Failed to record command buffer.");
     }
 
-    auto result = vSwapChain.submitCommandBuffers(&commandBuffer, &m_currentImageIndex);
+    std::vector<SemaphoreWait> waits;
+    for (VAsyncQueue *queue : {uploads.get(), compute.get()}) {
+        if (auto wait = queue->takeWait()) {
+            waits.push_back(*wait);
+        }
+    }
+
+    auto result = vSwapChain.submitCommandBuffers(&commandBuffer, &m_currentImageIndex, vSwapChain.usesCanvas() ? &m_damage : nullptr, waits);
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || vSwapChain.framebufferResized) {
         vSwapChain.framebufferResized = false;
         recreateSwapChain();
@@ -127,28 +205,41 @@ void VRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
         throw std::runtime_error("Cannot begin render pass on command buffer from a different frame.");
     }
 
+    // Uploads and compute passes recorded this frame are submitted, and handed to the graphics queue, before any drawing.
+    uploads->flush();
+    compute->flush();
+    gpuTimer->begin(commandBuffer, GPU_SCOPE_DRAW);
+
+    // Nothing changed on the canvas; endSwapChainRenderPass will still copy it to the swap chain.
+    if (vSwapChain.usesCanvas() && !hasDamage()) {
+        return;
+    }
+
+    if (vSwapChain.usesDynamicRendering()) {
+        const VkRect2D area = vSwapChain.usesCanvas() ? m_damage : VkRect2D{{0, 0}, vSwapChain.getExtent()};
+        vSwapChain.beginRendering(commandBuffer, m_currentImageIndex, area, CLEAR_COLOR);
+        return;
+    }
+
     VkRenderPassBeginInfo renderPassInfo {};
     renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
     renderPassInfo.renderPass = vSwapChain.getRenderPass();
     renderPassInfo.framebuffer = vSwapChain.getFrameBuffer(m_currentImageIndex);
-    renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = vSwapChain.getExtent();
 
     std::array<VkClearValue, 1> clearValues {};
-    clearValues[0].color = {1.0f, 1.0f, 1.0f, 1.0f};
-    renderPassInfo.clearValueCount = 1;
-    renderPassInfo.pClearValues = clearValues.data();
+    clearValues[0].color = CLEAR_COLOR;
 
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    if (vSwapChain.usesCanvas()) {
+        // The canvas is loaded, not cleared; pixels outside the render area are left as they were.
+        renderPassInfo.renderArea = m_damage;
+    } else {
+        renderPassInfo.renderArea.offset = {0, 0};
+        renderPassInfo.renderArea.extent = vSwapChain.getExtent();
+        renderPassInfo.clearValueCount = 1;
+        renderPassInfo.pClearValues = clearValues.data();
+    }
 
-    // VkViewport viewport {};
-    // viewport.x = 0.0f;
-    // viewport.y = 0.0f;
-    // viewport.width = static_cast<float>(vSwapChain.getExtent().width);
-    // viewport.height = static_cast<float>(vSwapChain.getExtent().height);
-    // viewport.minDepth = 0.0f;
-    // viewport.maxDepth = 1.0f;
-    // VkRect2D scissor {{0, 0}, vSwapChain.getExtent()};
+    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
 }
 
 void VRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
@@ -160,45 +251,120 @@ void VRenderer::endSwapChainRenderPass(VkCommandBuffer commandBuffer) {
         throw std::runtime_error("Cannot end render pass on command buffer from a different frame.");
     }
 
-    vkCmdEndRenderPass(commandBuffer);
+    auto endRendering = [&] {
+        if (vSwapChain.usesDynamicRendering()) {
+            vSwapChain.endRendering(commandBuffer, m_currentImageIndex);
+        } else {
+            vkCmdEndRenderPass(commandBuffer);
+        }
+    };
+
+    if (!vSwapChain.usesCanvas()) {
+        endRendering();
+        gpuTimer->end(commandBuffer, GPU_SCOPE_DRAW);
+        return;
+    }
+
+    if (hasDamage()) {
+        endRendering();
+    }
+
+    vSwapChain.recordCanvasCopy(commandBuffer, m_currentImageIndex);
+    gpuTimer->end(commandBuffer, GPU_SCOPE_DRAW);
+}
+
+void VRenderer::bindPrimitiveLayer(VkCommandBuffer commandBuffer) {
+    if (!instances) {
+        return;
+    }
+
+    bindlessPipeline->bind(commandBuffer);
+    const std::array<VkDescriptorSet, 2> sets = {textures->getBindlessSet(), instances->getDescriptorSet(m_currentFrameIndex)};
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, bindlessPipeline->getPipelineLayout(), 0,
+                            static_cast<uint32_t>(sets.size()), sets.data(), 0, nullptr);
+}
+
+void VRenderer::writeInstance(const Primitives::Primitive &primitive) {
+    if (!instances || primitive.getVertexCount() == 0) {
+        return;
+    }
+
+    InstanceRecord record {};
+    record.position = primitive.getTransform().position;
+    record.scale = Primitives::aspectCorrectedScale(primitive.getTransform().scale, vSwapChain.extentAspectRatio());
+
+    if (primitive.useInstanceColors()) {
+        record.flags |= InstanceRecord::INSTANCE_COLORS;
+        for (uint32_t i = 0; i < primitive.getVertexCount(); ++i) {
+            record.colors[i] = primitive.getVertices()[i].color;
+        }
+    }
+
+    if (primitive.useBilinearInterpolation() && primitive.getVertexCount() == 4) {
+        record.flags |= InstanceRecord::BILINEAR;
+    }
+
+    // Until it is ready, and for untextured primitives, this stays 0: the white fallback.
+    if (const VTexture *texture = primitive.getTexture(); texture && texture->isReady()) {
+        record.textureIndex = texture->getBindlessIndex();
+    }
+
+    instances->write(m_currentFrameIndex, primitive.getInstanceHandle(*instances), record);
 }
 
 void VRenderer::draw(VkCommandBuffer commandBuffer, const Primitives::Primitive &primitive) {
     if (primitive.getVertexCount() == 0)
         return;
 
-    vPipeline->bind(commandBuffer);
+    // Bindless: the pipeline and sets are already bound, and the instance handle travels as firstInstance.
+    if (instances) {
+        writeInstance(primitive);
+        const uint32_t handle = primitive.getInstanceHandle(*instances);
+
+        VkBuffer buffers[] = {primitive.getVertexBuffer().getBuffer()};
+        VkDeviceSize offsets[] = {0};
+        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+        if (primitive.getIndexCount() > 0) {
+            vkCmdBindIndexBuffer(commandBuffer, primitive.getIndexBuffer()->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            vkCmdDrawIndexed(commandBuffer, primitive.getIndexCount(), 1, 0, 0, handle);
+        } else {
+            vkCmdDraw(commandBuffer, primitive.getVertexCount(), 1, 0, handle);
+        }
+        return;
+    }
+
+    const VTexture *texture = primitive.getTexture();
+    const uint32_t variant = variantKey(primitive);
+    VPipeline &pipeline = (texture ? spritePipelines : primitivePipelines)->get(variant);
+    pipeline.bind(commandBuffer);
+
+    if (texture) {
+        const VkDescriptorSet set = texture->isReady() ? texture->getDescriptorSet() : textures->getFallback().getDescriptorSet();
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getPipelineLayout(), 0, 1, &set, 0, nullptr);
+    }
 
     Primitives::PushConstantData pushData{};
 
     // Set transform data from the primitive.
     pushData.position = primitive.getTransform().position;
-    pushData.scale = primitive.getTransform().scale;
-
-    float aspect = vSwapChain.extentAspectRatio();
-    if (aspect > 1.0f) {
-        pushData.scale.x /= aspect;
-    } else {
-        pushData.scale.y *= aspect;
-    }
-
-    if (primitive.useBilinearInterpolation() && primitive.getVertexCount() == 4) {
-        pushData.isBilinear = 1;
-        // Load the four corner colors from the primitive's vertex data.
-        // Assumes vertex order in C++ is BL, BR, TR, TL.
-        pushData.colors[0] = primitive.getVertices()[0].color;
-        pushData.colors[1] = primitive.getVertices()[1].color;
-        pushData.colors[2] = primitive.getVertices()[2].color;
-        pushData.colors[3] = primitive.getVertices()[3].color;
-    } else {
-        pushData.isBilinear = 0;
+    pushData.scale = Primitives::aspectCorrectedScale(primitive.getTransform().scale, vSwapChain.extentAspectRatio());
+
+    // Small primitives share a colorless mesh, so their per-vertex colors travel with the instance.
+    // For quads the vertex order in C++ is BL, BR, TR, TL, which the bilinear path relies on.
+    if (primitive.useInstanceColors()) {
+        for (uint32_t i = 0; i < primitive.getVertexCount(); ++i) {
+            pushData.colors[i] = primitive.getVertices()[i].color;
+        }
     }
 
     VkBuffer buffers[] = {primitive.getVertexBuffer().getBuffer()};
     VkDeviceSize offsets[] = {0};
     vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
 
-    vkCmdPushConstants(commandBuffer, vPipeline->getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Primitives::PushConstantData), &pushData);
+    // The whole block, even for variants that never read the colors: the shaders still declare them, and
+    // specialization does not change what a module statically uses.
+    vkCmdPushConstants(commandBuffer, pipeline.getPipelineLayout(), VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(pushData), &pushData);
 
     if (primitive.getIndexCount() > 0) {
         vkCmdBindIndexBuffer(commandBuffer, primitive.getIndexBuffer()->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
@@ -207,3 +373,121 @@ void VRenderer::draw(VkCommandBuffer commandBuffer, const Primitives::Primitive
         vkCmdDraw(commandBuffer, primitive.getVertexCount(), 1, 0, 0);
     }
 }
+
+uint32_t VRenderer::variantKey(const Primitives::Primitive &primitive) {
+    uint32_t key = 0;
+    if (primitive.useBilinearInterpolation() && primitive.getVertexCount() == 4) {
+        key |= VARIANT_BILINEAR;
+    }
+    if (primitive.useInstanceColors()) {
+        key |= VARIANT_INSTANCE_COLORS;
+    }
+    return key;
+}
+
+void VRenderer::beginSecondary(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags) const {
+    const RenderTarget target = vSwapChain.getRenderTarget();
+
+    VkCommandBufferInheritanceRenderingInfo rendering {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &target.colorFormat,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+    };
+
+    VkCommandBufferInheritanceInfo inheritance {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .pNext = target.renderPass == VK_NULL_HANDLE ? &rendering : nullptr,
+        .renderPass = target.renderPass,
+        .subpass = 0,
+        .framebuffer = getCurrentFramebuffer(),
+    };
+
+    VkCommandBufferBeginInfo beginInfo {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | flags,
+        .pInheritanceInfo = &inheritance,
+    };
+
+    if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to begin recording secondary command buffer.");
+    }
+}
+
+VkCommandBuffer VRenderer::recordText() {
+    if(!m_isFrameStarted) {
+        throw std::runtime_error("Cannot record text when frame not in progress.");
+    }
+
+    const bool hasText = textRenderer->getInstanceCount(m_currentFrameIndex) > 0 || overlay->hasContent(m_currentFrameIndex);
+    if (!hasText || !hasDamage()) {
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBuffer commandBuffer = textCommandBuffers[m_currentFrameIndex];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    beginSecondary(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+    const VkExtent2D extent = vSwapChain.getExtent();
+    VkViewport viewport {0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &m_damage);
+
+    gpuTimer->begin(commandBuffer, GPU_SCOPE_TEXT);
+    textRenderer->draw(commandBuffer, m_currentFrameIndex, extent);
+    overlay->draw(commandBuffer, m_currentFrameIndex, extent);
+    gpuTimer->end(commandBuffer, GPU_SCOPE_TEXT);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record text command buffer.");
+    }
+
+    return commandBuffer;
+}
+
+void VRenderer::setDamage(const VkRect2D &rect) {
+    if(!m_isFrameStarted) {
+        throw std::runtime_error("Cannot set damage when frame not in progress.");
+    }
+
+    const VkExtent2D extent = vSwapChain.getExtent();
+    if (!vSwapChain.usesCanvas() || !vSwapChain.takeCanvasValidity()) {
+        m_damage = {{0, 0}, extent};
+        return;
+    }
+
+    const int32_t x0 = std::clamp(rect.offset.x, 0, static_cast<int32_t>(extent.width));
+    const int32_t y0 = std::clamp(rect.offset.y, 0, static_cast<int32_t>(extent.height));
+    const int32_t x1 = std::clamp(rect.offset.x + static_cast<int32_t>(rect.extent.width), x0, static_cast<int32_t>(extent.width));
+    const int32_t y1 = std::clamp(rect.offset.y + static_cast<int32_t>(rect.extent.height), y0, static_cast<int32_t>(extent.height));
+    m_damage = {{x0, y0}, {static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0)}};
+}
+
+VkCommandBuffer VRenderer::recordDamageClear() {
+    if (!vSwapChain.usesCanvas() || !hasDamage()) {
+        return VK_NULL_HANDLE;
+    }
+
+    VkCommandBuffer commandBuffer = clearCommandBuffers[m_currentFrameIndex];
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    beginSecondary(commandBuffer, VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+    VkClearAttachment attachment {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .colorAttachment = 0,
+    };
+    attachment.clearValue.color = CLEAR_COLOR;
+
+    VkClearRect clearRect {m_damage, 0, 1};
+    gpuTimer->begin(commandBuffer, GPU_SCOPE_CLEAR);
+    vkCmdClearAttachments(commandBuffer, 1, &attachment, 1, &clearRect);
+    gpuTimer->end(commandBuffer, GPU_SCOPE_CLEAR);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to record clear command buffer.");
+    }
+
+    return commandBuffer;
+}
@@ -2,9 +2,17 @@
 
 #include "ThreadCommandResources.hpp"
 #include "VDevice.hpp"
+#include "VGpuTimer.hpp"
+#include "VInstanceTable.hpp"
+#include "VPerfOverlay.hpp"
 #include "VPipeline.hpp"
+#include "VStagingRing.hpp"
 #include "VSwapChain.hpp"
+#include "VTextureCache.hpp"
+#include "VAsyncQueue.hpp"
+#include "core/text/TextRenderer.hpp"
 #include "core/ui/Primitives.hpp"
+#include "util/JobSystem.hpp"
 #include <memory>
 #include <vector>
 
@@ -16,22 +24,53 @@ private:
     void createCommandBuffers();
     void recreateSwapChain();
 
+    // Specialization constant bits shared by core.vert, core.frag and sprite.frag.
+    static constexpr uint32_t VARIANT_BILINEAR = 1u << 0;
+    static constexpr uint32_t VARIANT_INSTANCE_COLORS = 1u << 1;
+    static constexpr uint32_t VARIANT_CONSTANTS = 2;
+    static uint32_t variantKey(const Primitives::Primitive &primitive);
+
+    // GPU timer scopes: the whole draw (render pass plus canvas copy), the clear and text secondaries, then one per batch.
+    static constexpr uint32_t GPU_SCOPE_DRAW = 0;
+    static constexpr uint32_t GPU_SCOPE_CLEAR = 1;
+    static constexpr uint32_t GPU_SCOPE_TEXT = 2;
+    static constexpr uint32_t GPU_SCOPE_BATCHES = 3;
+
     VDevice &vDevice;
     VSwapChain &vSwapChain;
-    std::unique_ptr<VPipeline> vPipeline;
+    // Push-constant path: specialized per primitive (see variantKey), untextured and textured.
+    std::unique_ptr<VPipelineVariants> primitivePipelines;
+    std::unique_ptr<TextRenderer> textRenderer;
+    std::unique_ptr<VPerfOverlay> overlay;
+    std::unique_ptr<VStagingRing> stagingRing;
+    std::unique_ptr<VAsyncQueue> uploads;
+    std::unique_ptr<VAsyncQueue> compute;
+    std::unique_ptr<VTextureCache> textures;
+    std::unique_ptr<VPipelineVariants> spritePipelines;
+    // Bindless path, when descriptor indexing is available: one pipeline and two sets for every primitive.
+    std::unique_ptr<VInstanceTable> instances;
+    std::unique_ptr<VPipeline> bindlessPipeline;
+    RenderTarget pipelineTarget;
+    std::unique_ptr<VGpuTimer> gpuTimer;
 
     VkCommandPool commandPool;
     std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<VkCommandBuffer> textCommandBuffers;
+    std::vector<VkCommandBuffer> clearCommandBuffers;
 
     std::array<std::vector<ThreadCommandResources>, VSwapChain::MAX_FRAMES_IN_FLIGHT> &engineThreadResources;
 
+    VkRect2D m_damage {};
     uint32_t m_currentImageIndex;
     int m_currentFrameIndex = 0;
     bool m_isFrameStarted = false;
 
 
 public:
-    VRenderer(VDevice &device, VSwapChain &swapChain, std::array<std::vector<ThreadCommandResources>, VSwapChain::MAX_FRAMES_IN_FLIGHT> &threadRes);
+    static constexpr VkClearColorValue CLEAR_COLOR {{1.0f, 1.0f, 1.0f, 1.0f}};
+    static constexpr VkDeviceSize STAGING_RING_SIZE = 64 * 1024 * 1024;
+
+    VRenderer(VDevice &device, VSwapChain &swapChain, JobSystem &jobSystem, std::array<std::vector<ThreadCommandResources>, VSwapChain::MAX_FRAMES_IN_FLIGHT> &threadRes);
     ~VRenderer();
 
     VRenderer(const VRenderer &) = delete;
@@ -42,6 +81,19 @@ public:
     VkCommandBuffer getCurrentCommandBuffer() const;
     VkFramebuffer getCurrentFramebuffer() const;
     VkRenderPass getSwapChainRenderPass() const { return vSwapChain.getRenderPass(); }
+    TextRenderer &getTextRenderer() { return *textRenderer; }
+    VPerfOverlay &getOverlay() { return *overlay; }
+    VTextureCache &getTextures() { return *textures; }
+    VStagingRing &getStagingRing() { return *stagingRing; }
+    VAsyncQueue &getUploads() { return *uploads; }
+    VAsyncQueue &getCompute() { return *compute; }
+    VGpuTimer &getGpuTimer() { return *gpuTimer; }
+    // The timer scope of the secondary command buffer that records batch `batch` of a frame.
+    static uint32_t batchScope(std::size_t batch) { return GPU_SCOPE_BATCHES + static_cast<uint32_t>(batch); }
+    // GPU time of the last measured frame's rendering, if timestamps are supported.
+    std::optional<double> getGpuFrameMilliseconds() const { return gpuTimer->getMilliseconds(GPU_SCOPE_DRAW); }
+    // GPU time of the same frame's uploads, when they ran on a dedicated transfer queue.
+    std::optional<double> getTransferMilliseconds() const { return uploads->getGpuMilliseconds(); }
 
     VkCommandBuffer beginFrame();
     void endFrame();
@@ -49,4 +101,30 @@ public:
     void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
     void draw(VkCommandBuffer commandBuffer, const Primitives::Primitive &primitive);
 
+    // With the bindless path, binds the shared pipeline and sets once for a run of draw calls; otherwise
+    // does nothing and draw binds per primitive.
+    void bindPrimitiveLayer(VkCommandBuffer commandBuffer);
+    bool usesBindless() const { return instances != nullptr; }
+
+    // Refreshes the primitive's instance record for this frame without recording anything; a no-op
+    // without the bindless path. Lets reused command buffers pick up the current parameters.
+    void writeInstance(const Primitives::Primitive &primitive);
+
+    // Begins a secondary command buffer that continues this frame's rendering into the swap chain target.
+    // Safe to call from worker threads.
+    void beginSecondary(VkCommandBuffer commandBuffer, VkCommandBufferUsageFlags flags) const;
+
+    // Records this frame's text, and the performance overlay above it, into their own secondary command buffer;
+    // returns null when there is neither.
+    VkCommandBuffer recordText();
+
+    // Limits this frame's redraw to `rect` (window pixels). Without a persistent canvas, or when its
+    // contents were lost, the whole image is redrawn regardless. Call after beginFrame.
+    void setDamage(const VkRect2D &rect);
+    const VkRect2D &getDamage() const { return m_damage; }
+    bool hasDamage() const { return m_damage.extent.width > 0 && m_damage.extent.height > 0; }
+
+    // Records the clear of the damaged region; returns null when the whole target is cleared by the render pass.
+    VkCommandBuffer recordDamageClear();
+
 };
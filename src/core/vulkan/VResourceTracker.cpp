@@ -0,0 +1,183 @@
+#include "VResourceTracker.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr double MEBIBYTE = 1024.0 * 1024.0;
+
+void writeFrameJson(std::ostream &out, const VResourceTracker::FrameDelta &delta) {
+    out << "{\"allocations\":" << delta.allocations << ",\"frees\":" << delta.frees << ",\"allocated_bytes\":" << delta.allocatedBytes
+        << ",\"freed_bytes\":" << delta.freedBytes << ",\"command_buffers\":" << delta.commandBuffers << "}";
+}
+
+void writeCountsJson(std::ostream &out, const VResourceTracker::Counts &counts) {
+    out << "{\"buffers\":" << counts.buffers << ",\"images\":" << counts.images << ",\"allocations\":" << counts.allocations
+        << ",\"command_buffers\":" << counts.commandBuffers << ",\"bytes\":" << counts.bytes << "}";
+}
+
+}
+
+VResourceTracker::Usage VResourceTracker::classify(VkBufferUsageFlags usage) {
+    if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) return Usage::Vertex;
+    if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) return Usage::Index;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) return Usage::Uniform;
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) return Usage::Storage;
+    if (usage & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) return Usage::Staging;
+    return Usage::Other;
+}
+
+const char *VResourceTracker::usageName(Usage usage) {
+    switch (usage) {
+        case Usage::Vertex: return "vertex";
+        case Usage::Index: return "index";
+        case Usage::Uniform: return "uniform";
+        case Usage::Storage: return "storage";
+        case Usage::Staging: return "staging";
+        case Usage::Image: return "image";
+        default: return "other";
+    }
+}
+
+void VResourceTracker::add(FrameDelta &sum, const FrameDelta &delta) {
+    sum.allocations += delta.allocations;
+    sum.frees += delta.frees;
+    sum.allocatedBytes += delta.allocatedBytes;
+    sum.freedBytes += delta.freedBytes;
+    sum.commandBuffers += delta.commandBuffers;
+}
+
+void VResourceTracker::allocated(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType, Usage usage) {
+    std::lock_guard<std::mutex> lock(mutex);
+    allocations[memory] = {size, memoryType, usage};
+
+    Counts &live = state.live;
+    Counts &peak = state.peak;
+    (usage == Usage::Image ? live.images : live.buffers) += 1;
+    ++live.allocations;
+    live.bytes += size;
+    state.bytesByMemoryType[memoryType] += size;
+    state.bytesByUsage[static_cast<std::size_t>(usage)] += size;
+
+    peak.buffers = std::max(peak.buffers, live.buffers);
+    peak.images = std::max(peak.images, live.images);
+    peak.allocations = std::max(peak.allocations, live.allocations);
+    peak.bytes = std::max(peak.bytes, live.bytes);
+
+    ++frame.allocations;
+    frame.allocatedBytes += size;
+}
+
+void VResourceTracker::freed(VkDeviceMemory memory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = allocations.find(memory);
+    if (it == allocations.end()) {
+        return;
+    }
+
+    const Allocation allocation = it->second;
+    allocations.erase(it);
+
+    Counts &live = state.live;
+    (allocation.usage == Usage::Image ? live.images : live.buffers) -= 1;
+    --live.allocations;
+    live.bytes -= allocation.size;
+    state.bytesByMemoryType[allocation.memoryType] -= allocation.size;
+    state.bytesByUsage[static_cast<std::size_t>(allocation.usage)] -= allocation.size;
+
+    ++frame.frees;
+    frame.freedBytes += allocation.size;
+}
+
+void VResourceTracker::commandBuffersAllocated(VkCommandPool pool, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    poolBuffers[pool] += count;
+    state.live.commandBuffers += count;
+    state.peak.commandBuffers = std::max(state.peak.commandBuffers, state.live.commandBuffers);
+    frame.commandBuffers += count;
+}
+
+void VResourceTracker::commandBuffersFreed(VkCommandPool pool, uint32_t count) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = poolBuffers.find(pool);
+    if (it == poolBuffers.end()) {
+        return;
+    }
+
+    const uint64_t released = std::min<uint64_t>(count, it->second);
+    it->second -= released;
+    state.live.commandBuffers -= released;
+}
+
+void VResourceTracker::commandPoolDestroyed(VkCommandPool pool) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = poolBuffers.find(pool);
+    if (it == poolBuffers.end()) {
+        return;
+    }
+
+    state.live.commandBuffers -= it->second;
+    poolBuffers.erase(it);
+}
+
+VResourceTracker::FrameDelta VResourceTracker::markFrame() {
+    std::lock_guard<std::mutex> lock(mutex);
+    const FrameDelta delta = frame;
+    frame = {};
+
+    if (!framing) {
+        framing = true;
+        return {};
+    }
+
+    ++state.frames;
+    state.lastFrame = delta;
+    add(state.total, delta);
+    if (delta.allocations > state.worstFrame.allocations) {
+        state.worstFrame = delta;
+    }
+    return delta;
+}
+
+VResourceTracker::Snapshot VResourceTracker::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return state;
+}
+
+bool VResourceTracker::reportLeaks(std::ostream &out) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Counts &live = state.live;
+    if (live.allocations == 0 && live.commandBuffers == 0) {
+        return false;
+    }
+
+    out << "Warning: Vulkan objects still alive at shutdown: " << live.buffers << " buffers, " << live.images << " images, "
+        << live.allocations << " memory allocations (" << static_cast<double>(live.bytes) / MEBIBYTE << " MiB), "
+        << live.commandBuffers << " command buffers.\n";
+
+    for (std::size_t usage = 0; usage < USAGES; ++usage) {
+        if (state.bytesByUsage[usage] != 0) {
+            out << "  " << usageName(static_cast<Usage>(usage)) << ": " << state.bytesByUsage[usage] << " bytes\n";
+        }
+    }
+    for (std::size_t type = 0; type < VK_MAX_MEMORY_TYPES; ++type) {
+        if (state.bytesByMemoryType[type] != 0) {
+            out << "  memory type " << type << ": " << state.bytesByMemoryType[type] << " bytes\n";
+        }
+    }
+    return true;
+}
+
+void VResourceTracker::writeJson(std::ostream &out, const Snapshot &snapshot) {
+    out << "{\"live\":";
+    writeCountsJson(out, snapshot.live);
+    out << ",\"peak\":";
+    writeCountsJson(out, snapshot.peak);
+
+    const double frames = static_cast<double>(std::max<uint64_t>(1, snapshot.frames));
+    out << ",\"frames\":" << snapshot.frames
+        << ",\"allocations_per_frame\":" << static_cast<double>(snapshot.total.allocations) / frames
+        << ",\"allocated_bytes_per_frame\":" << static_cast<double>(snapshot.total.allocatedBytes) / frames
+        << ",\"worst_frame\":";
+    writeFrameJson(out, snapshot.worstFrame);
+    out << "}";
+}
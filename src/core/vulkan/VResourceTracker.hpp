@@ -0,0 +1,91 @@
+#pragma once
+
+#include "Vulkan.hpp"
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+// Counts the buffers, images, memory allocations and command buffers that are alive, as VDevice creates and
+// destroys them. Live values, high-water marks and the churn of each frame are kept, so allocations in the
+// frame loop show up and anything still alive at shutdown can be reported as a leak.
+class VResourceTracker {
+
+public:
+    // What a memory allocation backs; buffers are classified by the first matching usage flag in this order.
+    enum class Usage { Vertex, Index, Uniform, Storage, Staging, Image, Other };
+    static constexpr std::size_t USAGES = 7;
+
+    struct Counts {
+        uint64_t buffers = 0;
+        uint64_t images = 0;
+        uint64_t allocations = 0;
+        uint64_t commandBuffers = 0;
+        VkDeviceSize bytes = 0;
+    };
+
+    // What was created and destroyed between two calls to markFrame().
+    struct FrameDelta {
+        uint64_t allocations = 0;
+        uint64_t frees = 0;
+        VkDeviceSize allocatedBytes = 0;
+        VkDeviceSize freedBytes = 0;
+        uint64_t commandBuffers = 0; // Allocated.
+    };
+
+    struct Snapshot {
+        Counts live;
+        Counts peak; // Each field's own high-water mark.
+        std::array<VkDeviceSize, VK_MAX_MEMORY_TYPES> bytesByMemoryType {};
+        std::array<VkDeviceSize, USAGES> bytesByUsage {};
+        uint64_t frames = 0;
+        FrameDelta lastFrame;
+        FrameDelta worstFrame; // The frame with the most allocations.
+        FrameDelta total;      // Summed over every marked frame.
+    };
+
+
+private:
+    struct Allocation {
+        VkDeviceSize size;
+        uint32_t memoryType;
+        Usage usage;
+    };
+
+    static void add(FrameDelta &sum, const FrameDelta &delta);
+
+    mutable std::mutex mutex;
+    std::unordered_map<VkDeviceMemory, Allocation> allocations;
+    std::unordered_map<VkCommandPool, uint64_t> poolBuffers;
+    Snapshot state;
+    FrameDelta frame;
+    bool framing = false;
+
+
+public:
+    static Usage classify(VkBufferUsageFlags usage);
+    static const char *usageName(Usage usage);
+
+    // Memory bound to a new buffer or, for Usage::Image, a new image.
+    void allocated(VkDeviceMemory memory, VkDeviceSize size, uint32_t memoryType, Usage usage);
+    void freed(VkDeviceMemory memory);
+
+    void commandBuffersAllocated(VkCommandPool pool, uint32_t count);
+    void commandBuffersFreed(VkCommandPool pool, uint32_t count);
+    // Destroying a pool frees every command buffer still allocated from it.
+    void commandPoolDestroyed(VkCommandPool pool);
+
+    // Ends a frame: returns what it created and destroyed and starts counting the next one. Anything before
+    // the first call, such as loading, is not attributed to a frame.
+    FrameDelta markFrame();
+
+    Snapshot snapshot() const;
+
+    // Lists whatever is still alive. Returns false, writing nothing, when everything has been destroyed.
+    bool reportLeaks(std::ostream &out) const;
+
+    // The live, peak and per-frame figures of a snapshot as a JSON object.
+    static void writeJson(std::ostream &out, const Snapshot &snapshot);
+
+};
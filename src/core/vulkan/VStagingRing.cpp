@@ -0,0 +1,50 @@
+#include "VStagingRing.hpp"
+#include "VBuffer.hpp"
+#include <stdexcept>
+
+VStagingRing::VStagingRing(VDevice &device, VkDeviceSize capacity) : vDevice(device), capacity(capacity) {
+    if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+        throw std::runtime_error("Staging ring capacity must be a power of two.");
+    }
+
+    buffer = std::make_unique<VBuffer>(
+        vDevice,
+        capacity,
+        1,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+    );
+    buffer->map();
+}
+
+VStagingRing::~VStagingRing() = default;
+
+void VStagingRing::beginFrame(int frameIndex) {
+    // The slots after this one are, oldest first, the frames still in flight. Everything allocated
+    // before the oldest of them started belongs to a finished submission.
+    const uint64_t oldestInFlight = frameStarts[(frameIndex + 1) % VSwapChain::MAX_FRAMES_IN_FLIGHT];
+    tail = std::max(tail, oldestInFlight);
+    frameStarts[frameIndex] = head;
+}
+
+std::optional<VStagingRing::Allocation> VStagingRing::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    if (size == 0 || size > capacity || alignment > capacity) {
+        return std::nullopt;
+    }
+
+    auto alignUp = [](uint64_t value, uint64_t to) { return (value + to - 1) / to * to; };
+    uint64_t start = alignUp(head, alignment);
+
+    // Allocations never straddle the end of the buffer; skip to the start instead.
+    if (start % capacity + size > capacity) {
+        start = alignUp(start, capacity);
+    }
+
+    if (start + size - tail > capacity) {
+        return std::nullopt;
+    }
+
+    head = start + size;
+    const VkDeviceSize offset = start % capacity;
+    return Allocation{buffer->getBuffer(), offset, static_cast<char *>(buffer->getMappedMemory()) + offset};
+}
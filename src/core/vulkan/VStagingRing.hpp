@@ -0,0 +1,50 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VSwapChain.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+class VBuffer;
+
+// A persistently mapped, host-visible upload buffer used as a ring. Space handed out during a frame
+// is reclaimed once that frame's fence has signalled, so uploads never wait on the GPU.
+class VStagingRing {
+
+private:
+    VDevice &vDevice;
+    std::unique_ptr<VBuffer> buffer;
+    VkDeviceSize capacity;
+
+    // Offsets are virtual (monotonic); the physical offset is the virtual one modulo capacity.
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    std::array<uint64_t, VSwapChain::MAX_FRAMES_IN_FLIGHT> frameStarts{};
+
+
+public:
+    struct Allocation {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        void *data;
+    };
+
+    // `capacity` must be a power of two so that aligned virtual offsets stay aligned physically.
+    VStagingRing(VDevice &device, VkDeviceSize capacity);
+    ~VStagingRing();
+
+    VStagingRing(const VStagingRing &) = delete;
+    VStagingRing &operator=(const VStagingRing &) = delete;
+
+    // Releases the space used by the last submission of this frame slot. Call once the slot's fence has been waited on.
+    void beginFrame(int frameIndex);
+
+    // Returns nothing when the ring is too full this frame; the caller should retry next frame.
+    std::optional<Allocation> allocate(VkDeviceSize size, VkDeviceSize alignment);
+
+    VkDeviceSize getCapacity() const { return capacity; }
+    VkDeviceSize getUsed() const { return head - tail; }
+
+};
@@ -1,5 +1,7 @@
 #include "VSwapChain.hpp"
+#include "util/Profiler.hpp"
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <limits>
 #include <stdexcept>
@@ -14,14 +16,34 @@ VSwapChain::~VSwapChain() {
 }
 
 void VSwapChain::init() {
-    createSwapChain();
+    dynamicRendering = vDevice.features().dynamicRendering;
+    headless = vDevice.headless();
+    if (headless) {
+        createOffscreenImages();
+    } else {
+        createSwapChain();
+    }
     createImageViews();
-    createRenderPass();
-    createFramebuffers();
+    if (!dynamicRendering) {
+        createRenderPass();
+        createFramebuffers();
+    }
     createSyncObjects();
+    createCanvas();
 }
 
 void VSwapChain::cleanupSwapChain() {
+    if (canvasFramebuffer != VK_NULL_HANDLE) {
+        vkDestroyFramebuffer(vDevice.device(), canvasFramebuffer, nullptr);
+        canvasFramebuffer = VK_NULL_HANDLE;
+    }
+
+    if (canvasRenderPass != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(vDevice.device(), canvasRenderPass, nullptr);
+        canvasRenderPass = VK_NULL_HANDLE;
+    }
+    canvas.reset();
+
     for (auto framebuffer : swapChainFramebuffers) {
         vkDestroyFramebuffer(vDevice.device(), framebuffer, nullptr);
     }
@@ -31,7 +53,9 @@ void VSwapChain::cleanupSwapChain() {
         vkDestroyImageView(vDevice.device(), imageView, nullptr);
     }
     swapChainImageViews.clear();
-    
+    offscreenImages.clear();
+    swapChainImages.clear();
+
     if (swapChain != VK_NULL_HANDLE) {
         vkDestroySwapchainKHR(vDevice.device(), swapChain, nullptr);
         swapChain = VK_NULL_HANDLE;
@@ -61,6 +85,13 @@ void VSwapChain::cleanupSwapChain() {
 }
 
 void VSwapChain::recreate() {
+    if (headless) {
+        vkDeviceWaitIdle(vDevice.device());
+        cleanupSwapChain();
+        init();
+        return;
+    }
+
     int width = 0, height = 0;
     glfwGetFramebufferSize(vDevice.window(), &width, &height);
     
@@ -77,14 +108,22 @@ void VSwapChain::recreate() {
 }
 
 VkResult VSwapChain::acquireNextImage(uint32_t *pImageIndex) {
+    IRO_PROFILE_ZONE("VSwapChain::acquireNextImage");
     vkWaitForFences(vDevice.device(), 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    if (headless) {
+        *pImageIndex = nextOffscreenImage;
+        nextOffscreenImage = (nextOffscreenImage + 1) % HEADLESS_IMAGE_COUNT;
+        return VK_SUCCESS;
+    }
+
     return vkAcquireNextImageKHR(
         vDevice.device(), swapChain, UINT64_MAX,
         imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, pImageIndex
     );
 }
 
-VkResult VSwapChain::submitCommandBuffers(const VkCommandBuffer *pCommandBuffers, const uint32_t *pImageIndex) {
+VkResult VSwapChain::submitCommandBuffers(const VkCommandBuffer *pCommandBuffers, const uint32_t *pImageIndex, const VkRect2D *damage,
+                                          const std::vector<SemaphoreWait> &extraWaits) {
     if (imagesInFlight[*pImageIndex] != VK_NULL_HANDLE) {
         vkWaitForFences(vDevice.device(), 1, &imagesInFlight[*pImageIndex], VK_TRUE, UINT64_MAX);
     }
@@ -94,21 +133,40 @@ VkResult VSwapChain::submitCommandBuffers(const VkCommandBuffer *pCommandBuffers
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    // With a canvas, the acquired image is first written by a copy rather than by the render pass.
+    // Offscreen images are not acquired, so there is nothing to wait for.
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<VkPipelineStageFlags> waitStages;
+    if (!headless) {
+        waitSemaphores.push_back(imageAvailableSemaphores[currentFrame]);
+        waitStages.push_back(canvas ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+    for (const SemaphoreWait &wait : extraWaits) {
+        waitSemaphores.push_back(wait.semaphore);
+        waitStages.push_back(wait.stage);
+    }
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = pCommandBuffers;
 
+    // A signalled semaphore nobody waits on could not be signalled again, so headless frames signal only the fence.
     VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[*pImageIndex]};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = headless ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     vkResetFences(vDevice.device(), 1, &inFlightFences[currentFrame]);
-    if (vkQueueSubmit(vDevice.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to submit draw command buffer.");
+    {
+        IRO_PROFILE_ZONE("vkQueueSubmit");
+        if (vkQueueSubmit(vDevice.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to submit draw command buffer.");
+        }
+    }
+
+    if (headless) {
+        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        return VK_SUCCESS;
     }
 
     VkPresentInfoKHR presentInfo{};
@@ -119,7 +177,25 @@ VkResult VSwapChain::submitCommandBuffers(const VkCommandBuffer *pCommandBuffers
     presentInfo.pSwapchains = &swapChain;
     presentInfo.pImageIndices = pImageIndex;
 
-    auto result = vkQueuePresentKHR(vDevice.presentQueue(), &presentInfo);
+    VkRectLayerKHR damageRect {};
+    VkPresentRegionKHR region {};
+    VkPresentRegionsKHR regions {};
+    if (damage && vDevice.supportsIncrementalPresent() && damage->extent.width > 0 && damage->extent.height > 0) {
+        damageRect = {damage->offset, damage->extent, 0};
+        region = {1, &damageRect};
+        regions = {
+            .sType = VK_STRUCTURE_TYPE_PRESENT_REGIONS_KHR,
+            .swapchainCount = 1,
+            .pRegions = &region,
+        };
+        presentInfo.pNext = &regions;
+    }
+
+    VkResult result;
+    {
+        IRO_PROFILE_ZONE("vkQueuePresentKHR");
+        result = vkQueuePresentKHR(vDevice.presentQueue(), &presentInfo);
+    }
 
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     return result;
@@ -144,7 +220,7 @@ void VSwapChain::createSwapChain() {
         .imageColorSpace = surfaceFormat.colorSpace,
         .imageExtent = extent,
         .imageArrayLayers = 1,
-        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+        .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT),
         .preTransform = swapChainSupport.capabilities.currentTransform,
         .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
         .presentMode = presentMode,
@@ -173,6 +249,24 @@ void VSwapChain::createSwapChain() {
 
     swapChainImageFormat = surfaceFormat.format;
     swapChainExtent = extent;
+    canvasSupported = (createInfo.imageUsage & VK_IMAGE_USAGE_TRANSFER_DST_BIT) != 0;
+}
+
+void VSwapChain::createOffscreenImages() {
+    // Transfer source so frames can be read back, transfer destination so the canvas can be copied in.
+    for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; ++i) {
+        offscreenImages.push_back(std::make_unique<VImage>(
+            vDevice,
+            windowExtent,
+            HEADLESS_FORMAT,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+        ));
+        swapChainImages.push_back(offscreenImages.back()->getImage());
+    }
+
+    swapChainImageFormat = HEADLESS_FORMAT;
+    swapChainExtent = windowExtent;
+    canvasSupported = true;
 }
 
 void VSwapChain::createImageViews() {
@@ -207,7 +301,7 @@ void VSwapChain::createRenderPass() {
         .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
         .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-        .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+        .finalLayout = finalLayout(),
     };
 
     VkAttachmentReference colorAttachmentRef{
@@ -293,6 +387,197 @@ void VSwapChain::createSyncObjects() {
     }
 }
 
+void VSwapChain::createCanvas() {
+    if (!canvasSupported) {
+        return;
+    }
+
+    canvas = std::make_unique<VImage>(
+        vDevice,
+        swapChainExtent,
+        swapChainImageFormat,
+        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
+    );
+
+    // Between frames the canvas rests in TRANSFER_SRC, ready to be copied to the next acquired image.
+    VkCommandBuffer commandBuffer = vDevice.beginSingleTimeCommands();
+    canvas->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    vDevice.endSingleTimeCommands(commandBuffer);
+    canvasContentsValid = false;
+
+    if (dynamicRendering) {
+        return;
+    }
+
+    VkAttachmentDescription colorAttachment {
+        .format = swapChainImageFormat,
+        .samples = VK_SAMPLE_COUNT_1_BIT,
+        .loadOp = VK_ATTACHMENT_LOAD_OP_LOAD,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+        .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+        .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+        .initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        .finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+    };
+
+    VkAttachmentReference colorAttachmentRef {
+        .attachment = 0,
+        .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    };
+
+    VkSubpassDescription subpass {
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorAttachmentRef,
+    };
+
+    // The previous frame's copy must finish reading before this pass writes, and this pass's
+    // writes must land before the copy that follows it.
+    std::array<VkSubpassDependency, 2> dependencies {{
+        {
+            .srcSubpass = VK_SUBPASS_EXTERNAL,
+            .dstSubpass = 0,
+            .srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        },
+        {
+            .srcSubpass = 0,
+            .dstSubpass = VK_SUBPASS_EXTERNAL,
+            .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+            .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+        },
+    }};
+
+    VkRenderPassCreateInfo renderPassInfo {
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = 1,
+        .pAttachments = &colorAttachment,
+        .subpassCount = 1,
+        .pSubpasses = &subpass,
+        .dependencyCount = static_cast<uint32_t>(dependencies.size()),
+        .pDependencies = dependencies.data(),
+    };
+
+    if (vkCreateRenderPass(vDevice.device(), &renderPassInfo, nullptr, &canvasRenderPass) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create canvas render pass.");
+    }
+
+    VkImageView attachments[] = {canvas->getView()};
+    VkFramebufferCreateInfo framebufferInfo {
+        .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+        .renderPass = canvasRenderPass,
+        .attachmentCount = 1,
+        .pAttachments = attachments,
+        .width = swapChainExtent.width,
+        .height = swapChainExtent.height,
+        .layers = 1,
+    };
+
+    if (vkCreateFramebuffer(vDevice.device(), &framebufferInfo, nullptr, &canvasFramebuffer) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create canvas framebuffer.");
+    }
+}
+
+bool VSwapChain::takeCanvasValidity() {
+    const bool valid = canvasContentsValid;
+    canvasContentsValid = true;
+    return valid;
+}
+
+void VSwapChain::recordCanvasCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    VkImageMemoryBarrier toTransfer {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = swapChainImages[imageIndex],
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+    };
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkImageCopy region {
+        .srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .srcOffset = {0, 0, 0},
+        .dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .dstOffset = {0, 0, 0},
+        .extent = {swapChainExtent.width, swapChainExtent.height, 1},
+    };
+    vkCmdCopyImage(commandBuffer, canvas->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    VkImageMemoryBarrier toPresent = toTransfer;
+    toPresent.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toPresent.dstAccessMask = 0;
+    toPresent.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toPresent.newLayout = finalLayout();
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &toPresent);
+}
+
+void VSwapChain::beginRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex, const VkRect2D &area, const VkClearColorValue &clear) {
+    // Mirrors the render passes: the canvas is loaded from TRANSFER_SRC once the previous copy has read it,
+    // while a swap chain image starts undefined and is cleared.
+    VkImageMemoryBarrier toAttachment {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .oldLayout = canvas ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = canvas ? canvas->getImage() : swapChainImages[imageIndex],
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+    };
+    const VkPipelineStageFlags srcStage = canvas
+        ? VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
+        : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, 0, nullptr, 0, nullptr, 1, &toAttachment);
+
+    VkRenderingAttachmentInfo colorAttachment {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .imageView = canvas ? canvas->getView() : swapChainImageViews[imageIndex],
+        .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .loadOp = canvas ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR,
+        .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+    };
+    colorAttachment.clearValue.color = clear;
+
+    VkRenderingInfo renderingInfo {
+        .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+        .flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT,
+        .renderArea = area,
+        .layerCount = 1,
+        .colorAttachmentCount = 1,
+        .pColorAttachments = &colorAttachment,
+    };
+    vDevice.cmdBeginRendering(commandBuffer, renderingInfo);
+}
+
+void VSwapChain::endRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+    vDevice.cmdEndRendering(commandBuffer);
+
+    // The canvas goes back to TRANSFER_SRC for the copy that follows; a swap chain image is ready to present.
+    VkImageMemoryBarrier toFinal {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+        .dstAccessMask = canvas ? static_cast<VkAccessFlags>(VK_ACCESS_TRANSFER_READ_BIT) : 0u,
+        .oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        .newLayout = canvas ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : finalLayout(),
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = canvas ? canvas->getImage() : swapChainImages[imageIndex],
+        .subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+    };
+    const VkPipelineStageFlags dstStage = canvas ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &toFinal);
+}
+
 SwapChainSupportDetails VSwapChain::querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface) {
     SwapChainSupportDetails details;
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface, &details.capabilities);
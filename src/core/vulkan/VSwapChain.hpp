@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VDevice.hpp"
+#include "VImage.hpp"
 #include <memory>
 #include <vector>
 
@@ -11,22 +12,37 @@ private:
     void init();
     void cleanupSwapChain();
     void createSwapChain();
+    void createOffscreenImages();
     void createImageViews();
     void createRenderPass();
     void createFramebuffers();
     void createSyncObjects();
+    void createCanvas();
 
     // Helpers for selecting optimal swap chain settings.
     VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR> &availablePresentModes);
     VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
+    // The layout a finished frame is left in: ready to present, or ready to be read back when headless.
+    VkImageLayout finalLayout() const { return headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
+
+    static constexpr uint32_t HEADLESS_IMAGE_COUNT = 3;
+    static constexpr VkFormat HEADLESS_FORMAT = VK_FORMAT_B8G8R8A8_SRGB;
 
     VDevice &vDevice;
     VkExtent2D windowExtent;
 
-    VkSwapchainKHR swapChain;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::shared_ptr<VSwapChain> oldSwapChain;
-    VkRenderPass renderPass;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+
+    // With dynamic rendering there are no render passes or framebuffers; layouts are transitioned by hand.
+    bool dynamicRendering = false;
+
+    // Without a surface, frames rotate through offscreen images of the requested extent and nothing is presented.
+    bool headless = false;
+    std::vector<std::unique_ptr<VImage>> offscreenImages;
+    uint32_t nextOffscreenImage = 0;
 
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
@@ -34,6 +50,14 @@ private:
     VkFormat swapChainImageFormat;
     VkExtent2D swapChainExtent;
 
+    // A persistent color target that keeps last frame's pixels, so only damaged regions need redrawing.
+    // It is copied to the acquired image every frame; unavailable if swap chain images cannot be copy targets.
+    std::unique_ptr<VImage> canvas;
+    VkRenderPass canvasRenderPass = VK_NULL_HANDLE;
+    VkFramebuffer canvasFramebuffer = VK_NULL_HANDLE;
+    bool canvasSupported = false;
+    bool canvasContentsValid = false;
+
     // Per-frame synchronization objects.
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
@@ -53,9 +77,19 @@ public:
 
     bool framebufferResized = false;
 
-    // Accessors
-    VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
-    VkRenderPass getRenderPass() { return renderPass; }
+    // Accessors. With a canvas, rendering targets it instead of the swap chain images. The render pass
+    // and framebuffers are null with dynamic rendering.
+    VkFramebuffer getFrameBuffer(int index) {
+        if (dynamicRendering) {
+            return VK_NULL_HANDLE;
+        }
+        return canvas ? canvasFramebuffer : swapChainFramebuffers[index];
+    }
+    VkRenderPass getRenderPass() { return canvas ? canvasRenderPass : renderPass; }
+    RenderTarget getRenderTarget() { return {getRenderPass(), swapChainImageFormat}; }
+    bool usesCanvas() const { return canvas != nullptr; }
+    bool usesDynamicRendering() const { return dynamicRendering; }
+    bool isHeadless() const { return headless; }
     VkExtent2D getExtent() { return swapChainExtent; }
     size_t imageCount() { return swapChainImages.size(); }
     float extentAspectRatio() {
@@ -64,8 +98,28 @@ public:
 
     // Methods
     void recreate();
+    // Headless only: renders at `extent` from the next recreation on, which is requested through framebufferResized.
+    void resizeOffscreen(VkExtent2D extent) {
+        windowExtent = extent;
+        framebufferResized = true;
+    }
     VkResult acquireNextImage(uint32_t *pImageIndex);
-    VkResult submitCommandBuffers(const VkCommandBuffer *pCommandBuffers, const uint32_t *pImageIndex);
+
+    // `damage`, if given, is passed to the presentation engine as the only changed region. `extraWaits` are
+    // semaphores from other queues (uploads, async compute) that this frame's work depends on.
+    VkResult submitCommandBuffers(const VkCommandBuffer *pCommandBuffers, const uint32_t *pImageIndex, const VkRect2D *damage = nullptr,
+                                  const std::vector<SemaphoreWait> &extraWaits = {});
+
+    // Returns false once after creation or recreation, when the canvas holds no valid pixels yet.
+    bool takeCanvasValidity();
+
+    // Records the copy of the canvas into the acquired image and its transition for presentation.
+    void recordCanvasCopy(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+    // Dynamic rendering counterparts of vkCmdBeginRenderPass and vkCmdEndRenderPass for the current target,
+    // including the layout transitions the render pass would have done. `clear` is only used without a canvas.
+    void beginRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex, const VkRect2D &area, const VkClearColorValue &clear);
+    void endRendering(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 
     static SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
 
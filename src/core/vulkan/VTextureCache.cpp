@@ -0,0 +1,446 @@
+#include "VTextureCache.hpp"
+#include "VBuffer.hpp"
+#include "VImage.hpp"
+#include "lib/stb_image.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+VTexture::VTexture(std::string name) : name(std::move(name)) {}
+
+VTexture::~VTexture() = default;
+
+VTextureCache::VTextureCache(VDevice &device, JobSystem &jobs, VStagingRing &ring) : vDevice(device), jobSystem(jobs), stagingRing(ring) {
+    createDescriptors();
+    if (vDevice.features().descriptorIndexing) {
+        createBindlessDescriptors();
+    }
+    createFallback();
+}
+
+VTextureCache::~VTextureCache() {
+    // Decode jobs write into textures owned by this cache, so they must finish first.
+    jobSystem.wait(decodeJobs);
+    for (const Decoded &entry : decoded) {
+        stbi_image_free(entry.pixels);
+    }
+
+    textures.clear();
+    fallback.reset();
+
+    for (VkDescriptorPool pool : descriptorPools) {
+        vkDestroyDescriptorPool(vDevice.device(), pool, nullptr);
+    }
+    vkDestroyDescriptorPool(vDevice.device(), bindlessPool, nullptr);
+    vkDestroyDescriptorSetLayout(vDevice.device(), bindlessLayout, nullptr);
+    vkDestroyDescriptorSetLayout(vDevice.device(), descriptorSetLayout, nullptr);
+    vkDestroySampler(vDevice.device(), sampler, nullptr);
+}
+
+void VTextureCache::createDescriptors() {
+    VkSamplerCreateInfo samplerInfo {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_LINEAR,
+        .minFilter = VK_FILTER_LINEAR,
+        .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+        .maxAnisotropy = 1.0f,
+        .borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK,
+    };
+
+    if (vkCreateSampler(vDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create texture sampler.");
+    }
+
+    VkDescriptorSetLayoutBinding binding {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = 1,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+
+    if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create texture descriptor set layout.");
+    }
+}
+
+void VTextureCache::createBindlessDescriptors() {
+    // Slots are written as textures arrive, including while earlier frames using the set are in flight.
+    const VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = 1,
+        .pBindingFlags = &bindingFlags,
+    };
+
+    VkDescriptorSetLayoutBinding binding {
+        .binding = 0,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .descriptorCount = MAX_BINDLESS_TEXTURES,
+        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+    };
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &flagsInfo,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = 1,
+        .pBindings = &binding,
+    };
+
+    if (vkCreateDescriptorSetLayout(vDevice.device(), &layoutInfo, nullptr, &bindlessLayout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless texture descriptor set layout.");
+    }
+
+    VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_BINDLESS_TEXTURES};
+    VkDescriptorPoolCreateInfo poolInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = 1,
+        .pPoolSizes = &poolSize,
+    };
+
+    if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &bindlessPool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create bindless texture descriptor pool.");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = bindlessPool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &bindlessLayout,
+    };
+
+    if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &bindlessSet) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate bindless texture descriptor set.");
+    }
+}
+
+void VTextureCache::registerBindless(VTexture &texture) {
+    if (!isBindless()) {
+        return;
+    }
+
+    if (nextBindlessIndex == MAX_BINDLESS_TEXTURES) {
+        std::cerr << "Warning: bindless texture array is full; '" << texture.getName() << "' is drawn with the fallback.\n";
+        return;
+    }
+
+    texture.bindlessIndex = nextBindlessIndex++;
+
+    VkDescriptorImageInfo imageInfo {
+        .sampler = sampler,
+        .imageView = texture.image->getView(),
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = bindlessSet,
+        .dstBinding = 0,
+        .dstArrayElement = texture.bindlessIndex,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(vDevice.device(), 1, &write, 0, nullptr);
+}
+
+VkDescriptorSet VTextureCache::allocateDescriptorSet(VkImageView view) {
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkDescriptorSetAllocateInfo allocInfo {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &descriptorSetLayout,
+    };
+
+    if (!descriptorPools.empty()) {
+        allocInfo.descriptorPool = descriptorPools.back();
+    }
+
+    // Pools are fixed-size, so a full one is simply followed by another.
+    if (descriptorPools.empty() || vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &set) != VK_SUCCESS) {
+        VkDescriptorPoolSize poolSize {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, SETS_PER_POOL};
+        VkDescriptorPoolCreateInfo poolInfo {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = SETS_PER_POOL,
+            .poolSizeCount = 1,
+            .pPoolSizes = &poolSize,
+        };
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(vDevice.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create texture descriptor pool.");
+        }
+        descriptorPools.push_back(pool);
+
+        allocInfo.descriptorPool = pool;
+        if (vkAllocateDescriptorSets(vDevice.device(), &allocInfo, &set) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate texture descriptor set.");
+        }
+    }
+
+    VkDescriptorImageInfo imageInfo {
+        .sampler = sampler,
+        .imageView = view,
+        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+
+    VkWriteDescriptorSet write {
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = set,
+        .dstBinding = 0,
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        .pImageInfo = &imageInfo,
+    };
+    vkUpdateDescriptorSets(vDevice.device(), 1, &write, 0, nullptr);
+
+    return set;
+}
+
+void VTextureCache::createFallback() {
+    unsigned char white[4] = {255, 255, 255, 255};
+    fallback = std::make_unique<VTexture>("fallback");
+    uploadImmediately(Decoded{fallback.get(), white, 1, 1});
+    fallback->descriptorSet = allocateDescriptorSet(fallback->image->getView());
+    registerBindless(*fallback); // Always slot 0.
+    fallback->ready = true;
+}
+
+void VTextureCache::uploadImmediately(const Decoded &entry) {
+    const VkDeviceSize size = static_cast<VkDeviceSize>(entry.width) * entry.height * 4;
+    VBuffer staging(vDevice, size, 1, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    staging.map();
+    staging.writeToBuffer(entry.pixels, size);
+
+    VTexture &texture = *entry.texture;
+    texture.width = entry.width;
+    texture.height = entry.height;
+    texture.image = std::make_unique<VImage>(vDevice, VkExtent2D{entry.width, entry.height}, VK_FORMAT_R8G8B8A8_SRGB,
+                                             VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+    VkBufferImageCopy region {
+        .bufferOffset = 0,
+        .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .imageExtent = {entry.width, entry.height, 1},
+    };
+
+    VkCommandBuffer commandBuffer = vDevice.beginSingleTimeCommands();
+    texture.image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vkCmdCopyBufferToImage(commandBuffer, staging.getBuffer(), texture.image->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    texture.image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    vDevice.endSingleTimeCommands(commandBuffer);
+}
+
+std::shared_ptr<VTexture> VTextureCache::track(const std::string &name) {
+    auto texture = std::make_shared<VTexture>(name);
+    textures.emplace(name, texture);
+
+    if (inFlight++ == 0) {
+        stats = {};
+        burstStart = std::chrono::steady_clock::now();
+    }
+    ++stats.requested;
+    return texture;
+}
+
+void VTextureCache::queueDecoded(VTexture *texture, unsigned char *pixels, int width, int height) {
+    if (!pixels) {
+        std::cerr << "Warning: Could not load texture '" << texture->getName() << "': " << stbi_failure_reason() << "\n";
+    }
+
+    std::lock_guard<std::mutex> lock(decodedMutex);
+    decoded.push_back(Decoded{texture, pixels, static_cast<uint32_t>(width), static_cast<uint32_t>(height)});
+}
+
+std::shared_ptr<const VTexture> VTextureCache::load(const std::string &path) {
+    if (auto it = textures.find(path); it != textures.end()) {
+        return it->second;
+    }
+
+    auto texture = track(path);
+    jobSystem.pushBackground([this, target = texture.get(), path] {
+        int width = 0, height = 0, channels = 0;
+        unsigned char *pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        queueDecoded(target, pixels, width, height);
+    }, &decodeJobs);
+
+    return texture;
+}
+
+std::shared_ptr<const VTexture> VTextureCache::load(const std::string &name, const unsigned char *data, std::size_t size) {
+    if (auto it = textures.find(name); it != textures.end()) {
+        return it->second;
+    }
+
+    auto texture = track(name);
+    jobSystem.pushBackground([this, target = texture.get(), data, size] {
+        int width = 0, height = 0, channels = 0;
+        unsigned char *pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, STBI_rgb_alpha);
+        queueDecoded(target, pixels, width, height);
+    }, &decodeJobs);
+
+    return texture;
+}
+
+std::vector<std::shared_ptr<const VTexture>> VTextureCache::loadDirectory(const std::string &directory) {
+    std::vector<std::filesystem::path> files;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+        if (extension == ".png" || extension == ".jpg" || extension == ".jpeg") {
+            files.push_back(entry.path());
+        }
+    }
+
+    if (error) {
+        std::cerr << "Warning: Could not read texture directory '" << directory << "': " << error.message() << "\n";
+    }
+
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::shared_ptr<const VTexture>> loaded;
+    loaded.reserve(files.size());
+    for (const auto &file : files) {
+        loaded.push_back(load(file.string()));
+    }
+    return loaded;
+}
+
+void VTextureCache::recordFrameTime() {
+    const auto now = std::chrono::steady_clock::now();
+    if (lastFrame.time_since_epoch().count() != 0) {
+        const double seconds = std::chrono::duration<double>(now - lastFrame).count();
+        if (inFlight > 0) {
+            ++stats.frames;
+            if (averageFrameSeconds > 0.0 && seconds > averageFrameSeconds * HITCH_FACTOR) {
+                ++stats.hitches;
+            }
+        }
+        averageFrameSeconds = averageFrameSeconds > 0.0 ? averageFrameSeconds * 0.9 + seconds * 0.1 : seconds;
+    }
+    lastFrame = now;
+}
+
+void VTextureCache::finishUpload(VTexture &texture) {
+    texture.descriptorSet = allocateDescriptorSet(texture.image->getView());
+    registerBindless(texture);
+    texture.ready = true;
+    ++stats.loaded;
+    stats.decodedBytes += static_cast<uint64_t>(texture.width) * texture.height * 4;
+}
+
+bool VTextureCache::upload(VAsyncQueue &uploads) {
+    recordFrameTime();
+    if (inFlight == 0) {
+        return false;
+    }
+
+    std::vector<Decoded> batch;
+    {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        VkDeviceSize budget = UPLOAD_BUDGET_PER_FRAME;
+        while (!decoded.empty()) {
+            const Decoded &next = decoded.front();
+            const VkDeviceSize bytes = next.pixels ? static_cast<VkDeviceSize>(next.width) * next.height * 4 : 0;
+            if (bytes > budget && !batch.empty()) {
+                break;
+            }
+
+            budget -= std::min(budget, bytes);
+            batch.push_back(next);
+            decoded.pop_front();
+        }
+    }
+
+    bool anyReady = false;
+    std::size_t processed = 0;
+    for (; processed < batch.size(); ++processed) {
+        const Decoded &entry = batch[processed];
+        VTexture &texture = *entry.texture;
+
+        if (!entry.pixels) {
+            texture.failed = true;
+            ++stats.failed;
+            --inFlight;
+            continue;
+        }
+
+        const VkDeviceSize bytes = static_cast<VkDeviceSize>(entry.width) * entry.height * 4;
+        if (bytes > stagingRing.getCapacity()) {
+            // Too large for the ring to ever hold; take the slow path rather than never loading it.
+            std::cerr << "Warning: texture '" << texture.getName() << "' exceeds the staging ring and was uploaded synchronously.\n";
+            uploadImmediately(entry);
+            stbi_image_free(entry.pixels);
+            finishUpload(texture);
+            --inFlight;
+            anyReady = true;
+            continue;
+        }
+
+        auto staging = stagingRing.allocate(bytes, 16);
+        if (!staging) {
+            break;
+        }
+
+        std::memcpy(staging->data, entry.pixels, bytes);
+        stbi_image_free(entry.pixels);
+
+        texture.width = entry.width;
+        texture.height = entry.height;
+        texture.image = std::make_unique<VImage>(vDevice, VkExtent2D{entry.width, entry.height}, VK_FORMAT_R8G8B8A8_SRGB,
+                                                 VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+        VkBufferImageCopy region {
+            .bufferOffset = staging->offset,
+            .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+            .imageExtent = {entry.width, entry.height, 1},
+        };
+
+        VkCommandBuffer commandBuffer = uploads.getCommandBuffer();
+        texture.image->transitionLayout(commandBuffer, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        vkCmdCopyBufferToImage(commandBuffer, staging->buffer, texture.image->getImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        uploads.finishImage(texture.image->getImage(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+        // The set is only bound by this frame's draws, which the upload queue orders after the copy above.
+        finishUpload(texture);
+        --inFlight;
+        anyReady = true;
+    }
+
+    // Whatever did not fit in the ring goes back to the front of the queue, in order.
+    if (processed < batch.size()) {
+        std::lock_guard<std::mutex> lock(decodedMutex);
+        decoded.insert(decoded.begin(), batch.begin() + processed, batch.end());
+    }
+
+    stats.elapsed = std::chrono::steady_clock::now() - burstStart;
+    if (inFlight == 0) {
+        std::cout << "Loaded " << stats.loaded << " texture(s), " << stats.failed << " failed, "
+                  << std::fixed << std::setprecision(1) << stats.decodedBytes / (1024.0 * 1024.0) << " MB in "
+                  << std::chrono::duration<double, std::milli>(stats.elapsed).count() << " ms ("
+                  << stats.throughputMBps() << " MB/s); " << stats.hitches << " of " << stats.frames << " frame(s) hitched.\n"
+                  << std::defaultfloat;
+    }
+
+    return anyReady;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "VDevice.hpp"
+#include "VStagingRing.hpp"
+#include "VAsyncQueue.hpp"
+#include "util/JobSystem.hpp"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class VImage;
+
+// A sampled RGBA image. It is handed out immediately and becomes ready once its pixels have been decoded and uploaded.
+class VTexture {
+
+private:
+    friend class VTextureCache;
+
+    std::string name;
+    std::unique_ptr<VImage> image;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    uint32_t bindlessIndex = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    bool ready = false;
+    bool failed = false;
+
+
+public:
+    explicit VTexture(std::string name);
+    ~VTexture();
+
+    VTexture(const VTexture &) = delete;
+    VTexture &operator=(const VTexture &) = delete;
+
+    bool isReady() const { return ready; }
+    bool hasFailed() const { return failed; }
+    const std::string &getName() const { return name; }
+    uint32_t getWidth() const { return width; }
+    uint32_t getHeight() const { return height; }
+    VkDescriptorSet getDescriptorSet() const { return descriptorSet; }
+    // Slot in the bindless texture array; 0 (the fallback) until the texture is ready or when bindless is unavailable.
+    uint32_t getBindlessIndex() const { return bindlessIndex; }
+
+};
+
+// Counters for one burst of loads, reset when a new burst starts after the queue drained.
+struct VTextureStats {
+    uint32_t requested = 0;
+    uint32_t loaded = 0;
+    uint32_t failed = 0;
+    uint64_t decodedBytes = 0;
+    std::chrono::nanoseconds elapsed{0}; // From the first request to the last upload.
+    uint32_t frames = 0;                 // Frames that ran while the burst was in progress.
+    uint32_t hitches = 0;                // Of those, frames much slower than the running average.
+
+    double throughputMBps() const {
+        const double seconds = std::chrono::duration<double>(elapsed).count();
+        return seconds > 0.0 ? static_cast<double>(decodedBytes) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+};
+
+// Loads textures by path without stalling frames: images are decoded on background workers and copied
+// to the GPU through the staging ring, a bounded amount per frame, via the frame's upload queue.
+class VTextureCache {
+
+private:
+    struct Decoded {
+        VTexture *texture;
+        unsigned char *pixels; // Owned; released with stbi_image_free.
+        uint32_t width;
+        uint32_t height;
+    };
+
+    // At most this many bytes are copied per frame; the rest waits for the next one.
+    static constexpr VkDeviceSize UPLOAD_BUDGET_PER_FRAME = 16 * 1024 * 1024;
+    static constexpr uint32_t SETS_PER_POOL = 256;
+    static constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+    // A frame counts as a hitch when it takes this much longer than the running average.
+    static constexpr double HITCH_FACTOR = 1.5;
+
+    // Registers a new texture under `name` and counts it towards the current load burst.
+    std::shared_ptr<VTexture> track(const std::string &name);
+    // Called from decode jobs; a null `pixels` marks the texture as failed.
+    void queueDecoded(VTexture *texture, unsigned char *pixels, int width, int height);
+
+    void createDescriptors();
+    void createBindlessDescriptors();
+    void createFallback();
+    void registerBindless(VTexture &texture);
+    VkDescriptorSet allocateDescriptorSet(VkImageView view);
+    void finishUpload(VTexture &texture);
+    void uploadImmediately(const Decoded &decoded);
+    void recordFrameTime();
+
+    VDevice &vDevice;
+    JobSystem &jobSystem;
+    VStagingRing &stagingRing;
+
+    VkSampler sampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    std::vector<VkDescriptorPool> descriptorPools;
+    std::unique_ptr<VTexture> fallback;
+
+    // With descriptor indexing, every texture is also written into one large array that stays bound.
+    VkDescriptorSetLayout bindlessLayout = VK_NULL_HANDLE;
+    VkDescriptorPool bindlessPool = VK_NULL_HANDLE;
+    VkDescriptorSet bindlessSet = VK_NULL_HANDLE;
+    uint32_t nextBindlessIndex = 0;
+
+    std::unordered_map<std::string, std::shared_ptr<VTexture>> textures;
+    JobCounter decodeJobs;
+    std::mutex decodedMutex;
+    std::deque<Decoded> decoded;
+    uint32_t inFlight = 0;
+
+    VTextureStats stats;
+    std::chrono::steady_clock::time_point burstStart;
+    std::chrono::steady_clock::time_point lastFrame;
+    double averageFrameSeconds = 0.0;
+
+
+public:
+    VTextureCache(VDevice &device, JobSystem &jobs, VStagingRing &ring);
+    ~VTextureCache();
+
+    VTextureCache(const VTextureCache &) = delete;
+    VTextureCache &operator=(const VTextureCache &) = delete;
+
+    // Returns the texture for this file, queueing a decode the first time it is requested.
+    std::shared_ptr<const VTexture> load(const std::string &path);
+
+    // Same as load, for an encoded image already in memory. The data must outlive the decode.
+    std::shared_ptr<const VTexture> load(const std::string &name, const unsigned char *data, std::size_t size);
+
+    // Queues every PNG and JPEG in the directory, in name order.
+    std::vector<std::shared_ptr<const VTexture>> loadDirectory(const std::string &directory);
+
+    // Records this frame's share of pending uploads. Returns true if at least one texture became ready.
+    bool upload(VAsyncQueue &uploads);
+
+    // Bound in place of textures that are still loading or failed to load: a single white texel.
+    const VTexture &getFallback() const { return *fallback; }
+    VkDescriptorSetLayout getDescriptorSetLayout() const { return descriptorSetLayout; }
+    bool isBindless() const { return bindlessSet != VK_NULL_HANDLE; }
+    VkDescriptorSetLayout getBindlessLayout() const { return bindlessLayout; }
+    VkDescriptorSet getBindlessSet() const { return bindlessSet; }
+    bool isLoading() const { return inFlight > 0; }
+    const VTextureStats &getStats() const { return stats; }
+
+};
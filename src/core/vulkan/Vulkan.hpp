@@ -12,12 +12,41 @@
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily;  // Transfer-only (typically a DMA engine); absent on most integrated GPUs.
+    std::vector<uint32_t> computeFamilies;   // Compute-capable families without graphics, in family order.
 
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
     }
 };
 
+// Optional device capabilities negotiated when the logical device is created. A flag is only set when the
+// feature was supported and has been enabled, so renderer code can branch on it directly.
+struct DeviceFeatures {
+    uint32_t apiVersion = VK_API_VERSION_1_0; // The lower of the instance's and the device's versions.
+    bool dynamicRendering = false;
+    bool synchronization2 = false;
+    bool descriptorIndexing = false;          // Non-uniform, partially bound, update-after-bind sampled image arrays.
+    bool bufferDeviceAddress = false;
+    bool timelineSemaphores = false;
+    bool hostQueryReset = false;              // vkResetQueryPool, for queues that cannot reset queries themselves.
+};
+
+// What pipelines and secondary command buffers render into. With dynamic rendering there is no render
+// pass, and only the attachment format has to match.
+struct RenderTarget {
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+
+    bool operator==(const RenderTarget &) const = default;
+};
+
+// A semaphore a queue submission waits on, and the first stage that must wait for it.
+struct SemaphoreWait {
+    VkSemaphore semaphore;
+    VkPipelineStageFlags stage;
+};
+
 // Contains details about the swap chain capabilities of a physical device.
 struct SwapChainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
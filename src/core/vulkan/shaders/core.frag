@@ -6,14 +6,16 @@ layout(location = 0) out vec4 outColor;
 layout(location = 0) in vec4 fragColor; // Default interpolated color
 layout(location = 2) in vec2 inUv;      // Interpolated UV coordinate
 
-// UPDATED: Push constant block to access the flag and corner colors
+// Push constant block to access the corner colors
 layout(push_constant, std430) uniform Push {
     vec2 position_offset;
     vec2 scale;
     uint colors[4];
-    int isBilinear;
 } push;
 
+// Set per pipeline variant, so the untaken path is compiled out instead of branched over per fragment.
+layout(constant_id = 0) const bool BILINEAR = false;
+
 // Unpacks an 8-bit per channel RGBA color from a 32-bit unsigned integer (AABBGGRR).
 vec4 uint32_aabbggrr_to_rgba(uint packed) {
     return vec4(
@@ -26,7 +28,7 @@ vec4 uint32_aabbggrr_to_rgba(uint packed) {
 
 void main() {
     // If this is a quad, perform manual bilinear interpolation
-    if (push.isBilinear == 1) {
+    if (BILINEAR) {
         // Unpack the four corner colors sent from the CPU
         // The order matches the vertex order: BL, BR, TR, TL
         vec4 c00 = uint32_aabbggrr_to_rgba(push.colors[0]); // Bottom-Left
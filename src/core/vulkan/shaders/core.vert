@@ -4,14 +4,16 @@
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in uint inColor;
 
-// UPDATED: Push constant block matches the new C++ struct
+// Push constant block matches Primitives::PushConstantData
 layout(push_constant, std430) uniform Push {
     vec2 position_offset;
     vec2 scale;
     uint colors[4];
-    int isBilinear;
 } push;
 
+// Set per pipeline variant (see VPipelineVariants); the same IDs are used by every primitive shader.
+layout(constant_id = 1) const bool INSTANCE_COLORS = false;
+
 // Output to the fragment shader
 layout(location = 0) out vec4 fragColor;
 // NEW: Pass a UV coordinate to the fragment shader
@@ -31,8 +33,13 @@ void main() {
     vec2 finalPosition = push.position_offset + (inPosition * push.scale);
     gl_Position = vec4(finalPosition, 0.0, 1.0);
     
-    // Pass the default interpolated color for non-quad objects
-    fragColor = uint32_aabbggrr_to_rgba(inColor);
+    // Pass the default interpolated color for non-quad objects. Shared meshes carry no color,
+    // so small primitives look theirs up per vertex from the push block instead.
+    if (INSTANCE_COLORS) {
+        fragColor = uint32_aabbggrr_to_rgba(push.colors[gl_VertexIndex]);
+    } else {
+        fragColor = uint32_aabbggrr_to_rgba(inColor);
+    }
 
     // Calculate and pass UVs, mapping the [-0.5, 0.5] local space to [0, 1] texture space
     outUv = inPosition + 0.5;
@@ -0,0 +1,43 @@
+#version 450
+
+layout(location = 0) out vec4 outColor;
+
+// Input from core.vert
+layout(location = 0) in vec4 fragColor;
+layout(location = 2) in vec2 inUv;
+
+layout(set = 0, binding = 0) uniform sampler2D spriteTexture;
+
+// Same push constant block as core.vert; the corner colors tint the texture.
+layout(push_constant, std430) uniform Push {
+    vec2 position_offset;
+    vec2 scale;
+    uint colors[4];
+} push;
+
+layout(constant_id = 0) const bool BILINEAR = false;
+
+// Unpacks an 8-bit per channel RGBA color from a 32-bit unsigned integer (AABBGGRR).
+vec4 uint32_aabbggrr_to_rgba(uint packed) {
+    return vec4(
+        (packed & 0xFF) / 255.0,
+        ((packed >> 8) & 0xFF) / 255.0,
+        ((packed >> 16) & 0xFF) / 255.0,
+        ((packed >> 24) & 0xFF) / 255.0
+    );
+}
+
+void main() {
+    vec4 tint = fragColor;
+    if (BILINEAR) {
+        // Corner order matches the vertex order: BL, BR, TR, TL
+        vec4 c00 = uint32_aabbggrr_to_rgba(push.colors[0]);
+        vec4 c10 = uint32_aabbggrr_to_rgba(push.colors[1]);
+        vec4 c11 = uint32_aabbggrr_to_rgba(push.colors[2]);
+        vec4 c01 = uint32_aabbggrr_to_rgba(push.colors[3]);
+
+        tint = mix(mix(c00, c10, inUv.x), mix(c01, c11, inUv.x), inUv.y);
+    }
+
+    outColor = tint * texture(spriteTexture, inUv);
+}
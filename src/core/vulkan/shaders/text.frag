@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragUv;
+
+layout(location = 0) out vec4 outColor;
+
+// Single-channel distance field; 0.5 lies on the glyph outline and larger values are inside.
+layout(set = 0, binding = 0) uniform sampler2D glyphAtlas;
+
+void main() {
+    float distance = texture(glyphAtlas, fragUv).r;
+
+    // Keep the edge about one screen pixel wide regardless of the glyph's scale.
+    float width = max(fwidth(distance), 1e-4) * 0.7;
+    float coverage = smoothstep(0.5 - width, 0.5 + width, distance);
+
+    outColor = vec4(fragColor.rgb, fragColor.a * coverage);
+}
@@ -0,0 +1,39 @@
+#version 450
+
+// Per-instance glyph attributes
+layout(location = 0) in vec4 inRect;  // x0, y0, x1, y1 in window pixels
+layout(location = 1) in vec4 inUv;    // u0, v0, u1, v1 in the atlas
+layout(location = 2) in uint inColor; // AABBGGRR
+
+layout(push_constant, std430) uniform Push {
+    vec2 viewportSize;
+} push;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUv;
+
+// Two triangles covering the glyph quad, as (x, y) selectors into the rect.
+const vec2 corners[6] = vec2[](
+    vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+    vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0)
+);
+
+// Unpacks an 8-bit per channel RGBA color from a 32-bit unsigned integer (AABBGGRR).
+vec4 uint32_aabbggrr_to_rgba(uint packed) {
+    return vec4(
+        (packed & 0xFF) / 255.0,
+        ((packed >> 8) & 0xFF) / 255.0,
+        ((packed >> 16) & 0xFF) / 255.0,
+        ((packed >> 24) & 0xFF) / 255.0
+    );
+}
+
+void main() {
+    vec2 corner = corners[gl_VertexIndex];
+    vec2 pixel = mix(inRect.xy, inRect.zw, corner);
+
+    // Window pixels (origin top-left) to normalized device coordinates.
+    gl_Position = vec4(pixel / push.viewportSize * 2.0 - 1.0, 0.0, 1.0);
+    fragUv = mix(inUv.xy, inUv.zw, corner);
+    fragColor = uint32_aabbggrr_to_rgba(inColor);
+}
@@ -0,0 +1,53 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) out vec4 outColor;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) flat in uint inInstance;
+layout(location = 2) in vec2 inUv;
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+
+// Must match InstanceRecord in VInstanceTable.hpp.
+struct InstanceRecord {
+    vec2 position;
+    vec2 scale;
+    uint colors[4];
+    uint textureIndex;
+    uint flags;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+    InstanceRecord instances[];
+};
+
+const uint BILINEAR = 1u;
+
+// Unpacks an 8-bit per channel RGBA color from a 32-bit unsigned integer (AABBGGRR).
+vec4 uint32_aabbggrr_to_rgba(uint packed) {
+    return vec4(
+        (packed & 0xFF) / 255.0,
+        ((packed >> 8) & 0xFF) / 255.0,
+        ((packed >> 16) & 0xFF) / 255.0,
+        ((packed >> 24) & 0xFF) / 255.0
+    );
+}
+
+void main() {
+    InstanceRecord instance = instances[inInstance];
+
+    vec4 tint = fragColor;
+    if ((instance.flags & BILINEAR) != 0u) {
+        // Corner order matches the vertex order: BL, BR, TR, TL
+        vec4 c00 = uint32_aabbggrr_to_rgba(instance.colors[0]);
+        vec4 c10 = uint32_aabbggrr_to_rgba(instance.colors[1]);
+        vec4 c11 = uint32_aabbggrr_to_rgba(instance.colors[2]);
+        vec4 c01 = uint32_aabbggrr_to_rgba(instance.colors[3]);
+
+        tint = mix(mix(c00, c10, inUv.x), mix(c01, c11, inUv.x), inUv.y);
+    }
+
+    // Untextured primitives point at the white fallback, so every primitive takes the same path.
+    outColor = tint * texture(textures[nonuniformEXT(instance.textureIndex)], inUv);
+}
@@ -0,0 +1,48 @@
+#version 450
+
+// Bindless counterpart of core.vert: per-primitive parameters come from the instance table,
+// indexed by the draw's firstInstance, instead of from push constants.
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in uint inColor;
+
+// Must match InstanceRecord in VInstanceTable.hpp.
+struct InstanceRecord {
+    vec2 position;
+    vec2 scale;
+    uint colors[4];
+    uint textureIndex;
+    uint flags;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+    InstanceRecord instances[];
+};
+
+const uint INSTANCE_COLORS = 2u;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) flat out uint outInstance;
+layout(location = 2) out vec2 outUv;
+
+// Unpacks an 8-bit per channel RGBA color from a 32-bit unsigned integer (AABBGGRR).
+vec4 uint32_aabbggrr_to_rgba(uint packed) {
+    return vec4(
+        (packed & 0xFF) / 255.0,
+        ((packed >> 8) & 0xFF) / 255.0,
+        ((packed >> 16) & 0xFF) / 255.0,
+        ((packed >> 24) & 0xFF) / 255.0
+    );
+}
+
+void main() {
+    InstanceRecord instance = instances[gl_InstanceIndex];
+    gl_Position = vec4(instance.position + inPosition * instance.scale, 0.0, 1.0);
+
+    // Shared meshes carry no color; small primitives keep theirs in the record instead.
+    uint packed = (instance.flags & INSTANCE_COLORS) != 0u ? instance.colors[gl_VertexIndex] : inColor;
+    fragColor = uint32_aabbggrr_to_rgba(packed);
+
+    outInstance = gl_InstanceIndex;
+    outUv = inPosition + 0.5;
+}
@@ -1,21 +1,53 @@
 #include "core/Engine.hpp"
+#include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
 #ifdef __linux__
 #include <fontconfig/fontconfig.h>
 #endif
 
-int main() {
+// Usage: IroEngine [--headless] [--frames N] [--size WIDTHxHEIGHT] [--hud] [--capture PATH | --replay PATH]
+static EngineOptions parseOptions(int argc, char **argv) {
+    EngineOptions options {};
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--hud") {
+            options.overlay = true;
+        } else if (arg == "--capture" && hasValue) {
+            options.capturePath = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            options.replayPath = argv[++i];
+        } else if (arg == "--frames" && hasValue) {
+            options.frameLimit = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--size" && hasValue) {
+            const std::string size = argv[++i];
+            const std::size_t x = size.find('x');
+            if (x == std::string::npos) {
+                throw std::runtime_error("Expected --size WIDTHxHEIGHT, got \"" + size + "\".");
+            }
+            options.extent = {static_cast<uint32_t>(std::stoul(size.substr(0, x))), static_cast<uint32_t>(std::stoul(size.substr(x + 1)))};
+        } else {
+            throw std::runtime_error("Unknown or incomplete argument \"" + arg + "\".");
+        }
+    }
+    return options;
+}
+
+int main(int argc, char **argv) {
     #ifdef __linux__
     // Initialize fontconfig on Linux to prevent runtime warnings.
     FcInit();
     #endif
 
-    // The Engine class encapsulates the application's lifecycle.
-    Engine engine {};
-
     try {
+        // The Engine class encapsulates the application's lifecycle.
+        Engine engine {parseOptions(argc, argv)};
         engine.run();
     } catch (const std::exception &e) {
         // Catch all unrecoverable errors from the engine's setup or main loop.
@@ -0,0 +1,225 @@
+#include "AllocTracker.hpp"
+
+#ifdef IRO_TRACK_ALLOCS
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace AllocTracker {
+
+namespace {
+
+// Threads beyond this share the last slot, which stays correct because every update is atomic.
+constexpr uint32_t MAX_THREADS = 256;
+
+struct alignas(64) ThreadSlot {
+    struct Atomic {
+        std::atomic<uint64_t> allocations {0};
+        std::atomic<uint64_t> bytes {0};
+        std::atomic<uint64_t> frees {0};
+    };
+    std::array<Atomic, TAGS> counts;
+    std::atomic<uint64_t> allocations {0};
+};
+
+// Nothing here may allocate: it is reached from operator new. The slots are static storage and the
+// thread-locals are trivially initialized, so neither needs the heap.
+ThreadSlot slots[MAX_THREADS];
+std::atomic<uint32_t> slotsUsed {0};
+
+thread_local ThreadSlot *threadSlot = nullptr;
+thread_local Tag threadTag = Tag::Other;
+
+ThreadSlot &slot() {
+    if (!threadSlot) {
+        threadSlot = &slots[std::min(slotsUsed.fetch_add(1, std::memory_order_relaxed), MAX_THREADS - 1)];
+    }
+    return *threadSlot;
+}
+
+void recordAllocation(std::size_t size) {
+    ThreadSlot &own = slot();
+    ThreadSlot::Atomic &counts = own.counts[static_cast<std::size_t>(threadTag)];
+    counts.allocations.fetch_add(1, std::memory_order_relaxed);
+    counts.bytes.fetch_add(size, std::memory_order_relaxed);
+    own.allocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+void recordFree(void *pointer) {
+    if (pointer) {
+        slot().counts[static_cast<std::size_t>(threadTag)].frees.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void *allocate(std::size_t size) {
+    void *pointer = std::malloc(size ? size : 1);
+    if (pointer) {
+        recordAllocation(size);
+    }
+    return pointer;
+}
+
+void *allocate(std::size_t size, std::align_val_t alignment) {
+    // aligned_alloc wants a size that is a multiple of the alignment.
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    void *pointer = std::aligned_alloc(align, std::max<std::size_t>(align, (size + align - 1) / align * align));
+    if (pointer) {
+        recordAllocation(size);
+    }
+    return pointer;
+}
+
+void release(void *pointer) {
+    recordFree(pointer);
+    std::free(pointer);
+}
+
+Counts difference(const Counts &now, const Counts &before) {
+    return {now.allocations - before.allocations, now.bytes - before.bytes, now.frees - before.frees};
+}
+
+}
+
+const char *tagName(Tag tag) {
+    switch (tag) {
+        case Tag::Renderer: return "renderer";
+        case Tag::UI: return "ui";
+        case Tag::Jobs: return "jobs";
+        case Tag::Discord: return "discord";
+        default: return "other";
+    }
+}
+
+TagCounts totals() {
+    TagCounts result {};
+    const uint32_t used = std::min(slotsUsed.load(std::memory_order_relaxed), MAX_THREADS);
+    for (uint32_t i = 0; i < used; ++i) {
+        for (std::size_t t = 0; t < TAGS; ++t) {
+            const ThreadSlot::Atomic &counts = slots[i].counts[t];
+            result[t].allocations += counts.allocations.load(std::memory_order_relaxed);
+            result[t].bytes += counts.bytes.load(std::memory_order_relaxed);
+            result[t].frees += counts.frees.load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+uint64_t threadAllocations() {
+    return slot().allocations.load(std::memory_order_relaxed);
+}
+
+Tag currentTag() {
+    return threadTag;
+}
+
+TagScope::TagScope(Tag tag) : previous(threadTag) {
+    threadTag = tag;
+}
+
+TagScope::~TagScope() {
+    threadTag = previous;
+}
+
+void FrameAllocations::markFrame() {
+    const TagCounts now = totals();
+    if (!started) {
+        started = true;
+        previous = now;
+        return;
+    }
+
+    Counts frame;
+    for (std::size_t t = 0; t < TAGS; ++t) {
+        const Counts delta = difference(now[t], previous[t]);
+        sum[t].allocations += delta.allocations;
+        sum[t].bytes += delta.bytes;
+        sum[t].frees += delta.frees;
+        frame.allocations += delta.allocations;
+        frame.bytes += delta.bytes;
+        frame.frees += delta.frees;
+    }
+
+    previous = now;
+    last = frame;
+    if (frame.allocations > worst.allocations) {
+        worst = frame;
+    }
+    ++frames;
+}
+
+double FrameAllocations::allocationsPerFrame() const {
+    uint64_t allocations = 0;
+    for (const Counts &counts : sum) {
+        allocations += counts.allocations;
+    }
+    return frames ? static_cast<double>(allocations) / static_cast<double>(frames) : 0.0;
+}
+
+double FrameAllocations::bytesPerFrame() const {
+    uint64_t bytes = 0;
+    for (const Counts &counts : sum) {
+        bytes += counts.bytes;
+    }
+    return frames ? static_cast<double>(bytes) / static_cast<double>(frames) : 0.0;
+}
+
+double FrameAllocations::allocationsPerFrame(Tag tag) const {
+    return frames ? static_cast<double>(sum[static_cast<std::size_t>(tag)].allocations) / static_cast<double>(frames) : 0.0;
+}
+
+void FrameAllocations::writeJson(std::ostream &out) const {
+    out << "{\"frames\":" << frames << ",\"allocations_per_frame\":" << allocationsPerFrame() << ",\"bytes_per_frame\":" << bytesPerFrame()
+        << ",\"worst_frame_allocations\":" << worst.allocations << ",\"tags\":{";
+    for (std::size_t t = 0; t < TAGS; ++t) {
+        out << (t ? "," : "") << '"' << tagName(static_cast<Tag>(t)) << "\":" << allocationsPerFrame(static_cast<Tag>(t));
+    }
+    out << "}}";
+}
+
+}
+
+// The replaceable global allocation functions. Every other form forwards to these four.
+
+void *operator new(std::size_t size) {
+    if (void *pointer = AllocTracker::allocate(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    if (void *pointer = AllocTracker::allocate(size, alignment)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept {
+    AllocTracker::release(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    AllocTracker::release(pointer);
+}
+
+void *operator new[](std::size_t size) { return ::operator new(size); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return AllocTracker::allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return AllocTracker::allocate(size); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return AllocTracker::allocate(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept { return AllocTracker::allocate(size, alignment); }
+
+void operator delete[](void *pointer) noexcept { ::operator delete(pointer); }
+void operator delete[](void *pointer, std::align_val_t alignment) noexcept { ::operator delete(pointer, alignment); }
+void operator delete(void *pointer, std::size_t) noexcept { ::operator delete(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { ::operator delete(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t alignment) noexcept { ::operator delete(pointer, alignment); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t alignment) noexcept { ::operator delete(pointer, alignment); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { ::operator delete(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { ::operator delete(pointer); }
+void operator delete(void *pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept { ::operator delete(pointer, alignment); }
+void operator delete[](void *pointer, std::align_val_t alignment, const std::nothrow_t &) noexcept { ::operator delete(pointer, alignment); }
+
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+
+// Heap allocation tracking, compiled in with IRO_TRACK_ALLOCS (`make TRACK_ALLOCS=1`). It replaces the global
+// operator new and delete, so it must not be enabled in anything that brings its own. Without it the macro
+// below expands to nothing and the replacements do not exist.
+//
+// Every allocation is charged to the calling thread's current tag, which IRO_ALLOC_TAG scopes set. Each thread
+// counts into its own slot, without locks, and the slots are summed when totals are read.
+
+#ifdef IRO_TRACK_ALLOCS
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+namespace AllocTracker {
+
+enum class Tag : uint8_t { Other, Renderer, UI, Jobs, Discord };
+constexpr std::size_t TAGS = 5;
+
+const char *tagName(Tag tag);
+
+struct Counts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;  // Requested, so allocator overhead is not included.
+    uint64_t frees = 0;
+};
+using TagCounts = std::array<Counts, TAGS>;
+
+// Everything allocated by every thread so far. Allocations that race with the call may or may not be included.
+TagCounts totals();
+
+// The calling thread's allocations so far, over all tags. Comparing two readings around a piece of code
+// checks that it does not allocate.
+uint64_t threadAllocations();
+
+Tag currentTag();
+
+// Charges the calling thread's allocations to `tag` until destroyed, then restores the previous tag.
+class TagScope {
+
+private:
+    Tag previous;
+
+
+public:
+    explicit TagScope(Tag tag);
+    ~TagScope();
+
+    TagScope(const TagScope &) = delete;
+    TagScope &operator=(const TagScope &) = delete;
+
+};
+
+// Allocations per frame over a run, from the totals read at each frame boundary.
+class FrameAllocations {
+
+private:
+    TagCounts previous {};
+    bool started = false;
+
+    uint64_t frames = 0;
+    TagCounts sum {};
+    Counts last;
+    Counts worst; // The frame with the most allocations.
+
+
+public:
+    // Ends a frame. The first call only takes the baseline, so loading is not charged to a frame.
+    void markFrame();
+
+    uint64_t getFrames() const { return frames; }
+    const Counts &lastFrame() const { return last; }
+    const Counts &worstFrame() const { return worst; }
+    // Averages per frame, overall and by tag.
+    double allocationsPerFrame() const;
+    double bytesPerFrame() const;
+    double allocationsPerFrame(Tag tag) const;
+
+    // The per-frame figures as a JSON object.
+    void writeJson(std::ostream &out) const;
+
+};
+
+}
+
+#define IRO_ALLOC_CONCAT_(a, b) a##b
+#define IRO_ALLOC_CONCAT(a, b) IRO_ALLOC_CONCAT_(a, b)
+#define IRO_ALLOC_TAG(tag) ::AllocTracker::TagScope IRO_ALLOC_CONCAT(iroAllocTag, __LINE__) {::AllocTracker::Tag::tag}
+
+#else
+
+#define IRO_ALLOC_TAG(tag) ((void)0)
+
+#endif
@@ -0,0 +1,131 @@
+#include "FrameStats.hpp"
+#include <fstream>
+
+namespace {
+
+constexpr const char *CHANNEL_NAMES[FrameStats::CHANNELS] = {"cpu", "gpu"};
+
+void writeSummaryCsv(std::ostream &out, const std::string &window, const char *channel, const FrameStats::Summary &summary) {
+    out << window << ',' << channel << ',' << summary.frames << ',' << summary.seconds << ',' << summary.p50 << ','
+        << summary.p95 << ',' << summary.p99 << ',' << summary.max << ',' << summary.hitches << '\n';
+}
+
+}
+
+void FrameStats::writeJson(std::ostream &out, const Summary &summary) {
+    out << "{\"frames\":" << summary.frames << ",\"seconds\":" << summary.seconds
+        << ",\"p50_ms\":" << summary.p50 << ",\"p95_ms\":" << summary.p95 << ",\"p99_ms\":" << summary.p99
+        << ",\"max_ms\":" << summary.max << ",\"hitches\":" << summary.hitches << "}";
+}
+
+FrameStats::Summary FrameStats::summarize(const LatencyHistogram &histogram, uint64_t hitches, double seconds) {
+    auto toMilliseconds = [](uint64_t microseconds) { return static_cast<double>(microseconds) / 1000.0; };
+    return {
+        .frames = histogram.count(),
+        .seconds = seconds,
+        .p50 = toMilliseconds(histogram.percentile(0.50)),
+        .p95 = toMilliseconds(histogram.percentile(0.95)),
+        .p99 = toMilliseconds(histogram.percentile(0.99)),
+        .max = toMilliseconds(histogram.max()),
+        .hitches = hitches,
+    };
+}
+
+void FrameStats::record(ChannelState &state, double milliseconds) {
+    const uint64_t microseconds = static_cast<uint64_t>(std::max(0.0, milliseconds) * 1000.0);
+    state.window.record(microseconds);
+    state.total.record(microseconds);
+
+    if (state.hitchThreshold != 0 && microseconds > state.hitchThreshold) {
+        ++state.windowHitches;
+        ++state.totalHitches;
+    }
+}
+
+bool FrameStats::recordFrame(double cpuMilliseconds, std::optional<double> gpuMilliseconds) {
+    // The clock starts with the first frame rather than at construction, which would count startup.
+    if (channels[static_cast<std::size_t>(Channel::Cpu)].total.count() == 0) {
+        start = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(cpuMilliseconds));
+        windowStart = start;
+    }
+
+    record(channels[static_cast<std::size_t>(Channel::Cpu)], cpuMilliseconds);
+    if (gpuMilliseconds) {
+        record(channels[static_cast<std::size_t>(Channel::Gpu)], *gpuMilliseconds);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - windowStart < WINDOW) {
+        return false;
+    }
+
+    completeWindow(now);
+    return true;
+}
+
+void FrameStats::completeWindow(std::chrono::steady_clock::time_point now) {
+    const double seconds = std::chrono::duration<double>(now - windowStart).count();
+
+    std::array<Summary, CHANNELS> summaries;
+    for (std::size_t i = 0; i < CHANNELS; ++i) {
+        ChannelState &state = channels[i];
+        summaries[i] = summarize(state.window, state.windowHitches, seconds);
+        state.lastWindow = summaries[i];
+
+        // The next window's hitches are judged against this window's typical frame.
+        if (state.window.count() > 0) {
+            state.hitchThreshold = static_cast<uint64_t>(static_cast<double>(state.window.percentile(0.50)) * HITCH_FACTOR);
+        }
+
+        state.window.reset();
+        state.windowHitches = 0;
+    }
+
+    history.push_back(summaries);
+    windowStart = now;
+}
+
+FrameStats::Summary FrameStats::total(Channel channel) const {
+    const ChannelState &state = channels[static_cast<std::size_t>(channel)];
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return summarize(state.total, state.totalHitches, seconds);
+}
+
+bool FrameStats::writeReport(const std::string &path) const {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        out << "window,channel,frames,seconds,p50_ms,p95_ms,p99_ms,max_ms,hitches\n";
+        for (std::size_t i = 0; i < CHANNELS; ++i) {
+            writeSummaryCsv(out, "total", CHANNEL_NAMES[i], total(static_cast<Channel>(i)));
+        }
+        for (std::size_t w = 0; w < history.size(); ++w) {
+            for (std::size_t i = 0; i < CHANNELS; ++i) {
+                writeSummaryCsv(out, std::to_string(w), CHANNEL_NAMES[i], history[w][i]);
+            }
+        }
+        return static_cast<bool>(out);
+    }
+
+    out << "{\n\"total\":{";
+    for (std::size_t i = 0; i < CHANNELS; ++i) {
+        out << (i ? "," : "") << '"' << CHANNEL_NAMES[i] << "\":";
+        writeJson(out, total(static_cast<Channel>(i)));
+    }
+    out << "},\n\"windows\":[";
+    for (std::size_t w = 0; w < history.size(); ++w) {
+        out << (w ? ",\n" : "\n") << '{';
+        for (std::size_t i = 0; i < CHANNELS; ++i) {
+            out << (i ? "," : "") << '"' << CHANNEL_NAMES[i] << "\":";
+            writeJson(out, history[w][i]);
+        }
+        out << '}';
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
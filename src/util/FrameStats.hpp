@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A log-linear histogram of microsecond values, in the style of HdrHistogram: values below 64 are exact and
+// every power of two above that is split into 32 buckets, so any recorded value is known to within ~3%.
+// Recording is a relaxed atomic increment and can happen from any thread.
+class LatencyHistogram {
+
+private:
+    static constexpr uint32_t SUB_BUCKET_BITS = 5;
+    static constexpr uint32_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+    static constexpr uint32_t EXACT = SUB_BUCKETS * 2;
+    // Powers of two up to 2^37 us (about 38 hours); anything longer lands in the last bucket.
+    static constexpr uint32_t MAGNITUDES = 32;
+    static constexpr uint32_t BUCKETS = EXACT + MAGNITUDES * SUB_BUCKETS;
+
+    static uint32_t bucketOf(uint64_t value) {
+        if (value < EXACT) {
+            return static_cast<uint32_t>(value);
+        }
+        const uint32_t magnitude = static_cast<uint32_t>(std::bit_width(value)) - 1; // 2^magnitude <= value
+        const uint32_t shift = magnitude - SUB_BUCKET_BITS;
+        const uint32_t index = EXACT + (magnitude - (SUB_BUCKET_BITS + 1)) * SUB_BUCKETS + static_cast<uint32_t>((value >> shift) - SUB_BUCKETS);
+        return std::min(index, BUCKETS - 1);
+    }
+
+    // The largest value that falls into the bucket.
+    static uint64_t upperBoundOf(uint32_t bucket) {
+        if (bucket < EXACT) {
+            return bucket;
+        }
+        const uint32_t magnitude = (bucket - EXACT) / SUB_BUCKETS + SUB_BUCKET_BITS + 1;
+        const uint32_t shift = magnitude - SUB_BUCKET_BITS;
+        const uint64_t sub = (bucket - EXACT) % SUB_BUCKETS + SUB_BUCKETS;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> counts {};
+    std::atomic<uint64_t> total {0};
+    std::atomic<uint64_t> maximum {0};
+
+
+public:
+    void record(uint64_t microseconds) {
+        counts[bucketOf(microseconds)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t previous = maximum.load(std::memory_order_relaxed);
+        while (previous < microseconds && !maximum.compare_exchange_weak(previous, microseconds, std::memory_order_relaxed)) {}
+    }
+
+    // Not atomic with respect to concurrent recording.
+    void reset() {
+        for (auto &count : counts) {
+            count.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        maximum.store(0, std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t max() const { return maximum.load(std::memory_order_relaxed); }
+
+    // The smallest bucket bound that at least `fraction` (0..1) of the values do not exceed; 0 when empty.
+    uint64_t percentile(double fraction) const {
+        const uint64_t n = count();
+        if (n == 0) {
+            return 0;
+        }
+
+        const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * static_cast<double>(n) + 0.5));
+        uint64_t seen = 0;
+        for (uint32_t bucket = 0; bucket < BUCKETS; ++bucket) {
+            seen += counts[bucket].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return std::min(upperBoundOf(bucket), max());
+            }
+        }
+        return max();
+    }
+
+};
+
+// Per-frame CPU and GPU times, summarised over rolling one-second windows and over the whole run. Averages hide
+// stutters, so the summaries report percentiles, the worst frame and the number of hitches.
+class FrameStats {
+
+public:
+    enum class Channel { Cpu, Gpu };
+    static constexpr std::size_t CHANNELS = 2;
+
+    struct Summary {
+        uint64_t frames = 0;
+        double seconds = 0.0;   // Wall time the summary covers.
+        double p50 = 0.0;       // Milliseconds, as are the fields below.
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+        uint64_t hitches = 0;   // Frames slower than HITCH_FACTOR times the previous window's median.
+    };
+
+
+private:
+    struct ChannelState {
+        LatencyHistogram window;
+        LatencyHistogram total;
+        uint64_t windowHitches = 0;
+        uint64_t totalHitches = 0;
+        uint64_t hitchThreshold = 0; // Microseconds; 0 until the first window has completed.
+        Summary lastWindow;
+    };
+
+    static constexpr std::chrono::seconds WINDOW {1};
+    static constexpr double HITCH_FACTOR = 2.0;
+
+    static Summary summarize(const LatencyHistogram &histogram, uint64_t hitches, double seconds);
+    void record(ChannelState &state, double milliseconds);
+    void completeWindow(std::chrono::steady_clock::time_point now);
+
+    std::array<ChannelState, CHANNELS> channels;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point windowStart = start;
+    // Every completed window, in order, for the report.
+    std::vector<std::array<Summary, CHANNELS>> history;
+
+
+public:
+    // Records one frame. Returns true when this frame completed a window, i.e. lastWindow() just changed.
+    bool recordFrame(double cpuMilliseconds, std::optional<double> gpuMilliseconds);
+
+    const Summary &lastWindow(Channel channel) const { return channels[static_cast<std::size_t>(channel)].lastWindow; }
+    Summary total(Channel channel) const;
+
+    // One summary as a JSON object, in the format used by the report.
+    static void writeJson(std::ostream &out, const Summary &summary);
+
+    // Writes the totals and every window; CSV when the path ends in ".csv", JSON otherwise. Returns false on failure.
+    bool writeReport(const std::string &path) const;
+
+};
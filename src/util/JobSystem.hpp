@@ -1,44 +1,85 @@
 #pragma once
+#include "AllocTracker.hpp"
+#include "Profiler.hpp"
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <thread>
 #include <vector>
 
+// Counts the outstanding jobs of one group so callers can wait on their own work only.
+struct JobCounter {
+    std::atomic_uint pending{0};
+};
+
 class JobSystem {
 
 private:
     using Task = std::function<void()>;
 
+    struct Job {
+        Task task;
+        JobCounter *counter = nullptr;
+    };
+
     void workerLoop() {
         while (true) {
-            Task task;
+            Job job;
+            bool isBackground = false;
             
             {
                 std::unique_lock<std::mutex> lk(mu);
-                cv.wait(lk, [this] { return stop || !q.empty(); });
-                if (stop && q.empty()) return;
-                task = std::move(q.front());
-                q.pop();
+                auto backgroundReady = [this] { return !background.empty() && runningBackground < backgroundLimit; };
+                cv.wait(lk, [&] { return stop || !q.empty() || backgroundReady(); });
+                if (stop && q.empty() && background.empty()) return;
+
+                // Frame work always goes first. Background jobs only fill idle workers, and with more than one
+                // worker never all of them, so a long decode cannot hold up the next frame's recording. A single
+                // worker has nothing to spare: it takes background jobs only while no frame work is queued, so
+                // frame work waits for at most the one job already running.
+                isBackground = q.empty();
+                auto &source = isBackground ? background : q;
+                job = std::move(source.front());
+                source.pop();
+                if (isBackground) ++runningBackground;
             }
 
-            task();
+            const auto started = std::chrono::steady_clock::now();
+            job.task();
+            busy.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - started).count()),
+                           std::memory_order_relaxed);
 
-            if (--pending == 0) {
+            if (isBackground) {
+                {
+                    std::lock_guard<std::mutex> lk(mu);
+                    --runningBackground;
+                }
+                cv.notify_one();
+            }
+
+            const bool groupDone = job.counter && --job.counter->pending == 0;
+            if (--pending == 0 || groupDone) {
                 std::lock_guard<std::mutex> lk(doneMu);
-                doneCv.notify_one();
+                doneCv.notify_all();
             }
         }
     }
 
     std::vector<std::thread> threads;
-    std::queue<Task> q;
+    std::queue<Job> q;
+    std::queue<Job> background;
+    std::size_t runningBackground = 0;
+    std::size_t backgroundLimit = 1;
     std::condition_variable cv;
     std::mutex mu;
     std::atomic_uint pending{0};
+    std::atomic<uint64_t> busy{0}; // Nanoseconds spent running jobs, summed over the workers.
 
     std::condition_variable doneCv;
     std::mutex doneMu;
@@ -47,8 +88,15 @@ private:
 
 public:
     explicit JobSystem(std::size_t workers = std::max(1u, std::thread::hardware_concurrency() - 1u)) : stop(false) {
+        // One worker is always kept for frame work; see workerLoop for the single-worker case.
+        backgroundLimit = workers > 1 ? workers - 1 : 1;
         for (std::size_t i = 0; i < workers; ++i) {
-            threads.emplace_back([this] { workerLoop(); });
+            threads.emplace_back([this, i] {
+                IRO_PROFILE_THREAD("Worker " + std::to_string(i));
+                // Jobs that do not tag themselves are charged to the job system.
+                IRO_ALLOC_TAG(Jobs);
+                workerLoop();
+            });
         }
     }
     
@@ -63,18 +111,48 @@ public:
             t.join();
     }
 
-    void push(Task &&task) {
+    void push(Task &&task, JobCounter *counter = nullptr) {
+        IRO_ALLOC_TAG(Jobs);
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            if (counter) ++counter->pending;
+            q.emplace(Job{std::move(task), counter});
+            ++pending;
+        }
+
+        cv.notify_one();
+    }
+
+    // Queues a long-running job (asset decoding and the like) that must never delay frame work.
+    void pushBackground(Task &&task, JobCounter *counter = nullptr) {
+        IRO_ALLOC_TAG(Jobs);
         {
             std::lock_guard<std::mutex> lk(mu);
-            q.emplace(std::move(task));
+            if (counter) ++counter->pending;
+            background.emplace(Job{std::move(task), counter});
             ++pending;
         }
 
         cv.notify_one();
     }
 
+    // Waits for every queued job, including those pushed by other subsystems.
     void wait() {
+        IRO_PROFILE_ZONE("JobSystem::wait");
         std::unique_lock<std::mutex> lk(doneMu);
         doneCv.wait(lk, [this] { return pending.load() == 0; });
     }
+
+    // Waits only for the jobs pushed with this counter.
+    void wait(JobCounter &counter) {
+        IRO_PROFILE_ZONE("JobSystem::wait");
+        std::unique_lock<std::mutex> lk(doneMu);
+        doneCv.wait(lk, [&counter] { return counter.pending.load() == 0; });
+    }
+
+    std::size_t workerCount() const { return threads.size(); }
+
+    // Total time the workers have spent inside jobs; its growth over an interval, divided by the interval
+    // times workerCount(), is their utilization.
+    std::chrono::nanoseconds busyTime() const { return std::chrono::nanoseconds(busy.load(std::memory_order_relaxed)); }
 };
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <ostream>
+#include <string_view>
+
+namespace Json {
+
+// Writes `text` as the inside of a JSON string: quotes and backslashes are escaped, and control characters,
+// which JSON does not allow raw, become \u escapes.
+inline void writeEscaped(std::ostream &out, std::string_view text) {
+    constexpr char HEX[] = "0123456789abcdef";
+    for (const char c : text) {
+        const auto byte = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (byte < 0x20) {
+            out << "\\u00" << HEX[byte >> 4] << HEX[byte & 0xF];
+        } else {
+            out << c;
+        }
+    }
+}
+
+}
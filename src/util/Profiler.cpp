@@ -0,0 +1,125 @@
+#include "Profiler.hpp"
+
+#ifdef IRO_PROFILE
+
+#include "Json.hpp"
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <unordered_set>
+
+namespace Profiler {
+
+namespace {
+
+// Tracks live until exit, so zones from threads that already finished still make it into the trace.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Track>> tracks;
+    std::unordered_set<std::string> strings; // Node-based, so element addresses are stable.
+
+    // Callers hold `mutex`.
+    Track &add(std::string name) {
+        tracks.push_back(std::make_unique<Track>(std::move(name), static_cast<uint32_t>(tracks.size() + 1)));
+        return *tracks.back();
+    }
+};
+
+Registry &registry() {
+    static Registry instance;
+    return instance;
+}
+
+}
+
+Track::Track(std::string name, uint32_t id) : events(std::make_unique<Event[]>(CAPACITY)), name(std::move(name)), id(id) {}
+
+std::vector<Event> Track::snapshot() const {
+    const uint64_t count = written.load(std::memory_order_acquire);
+    const uint64_t first = count > CAPACITY ? count - CAPACITY : 0;
+
+    std::vector<Event> result;
+    result.reserve(count - first);
+    for (uint64_t i = first; i < count; ++i) {
+        result.push_back(events[i & (CAPACITY - 1)]);
+    }
+    return result;
+}
+
+Track &registerThread() {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.add("Thread");
+}
+
+void setThreadName(std::string name) {
+    Track &own = threadTrack();
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    own.setName(std::move(name));
+}
+
+Track &track(const std::string &name) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const auto &existing : reg.tracks) {
+        if (existing->getName() == name) {
+            return *existing;
+        }
+    }
+    return reg.add(name);
+}
+
+const char *intern(const std::string &text) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    return reg.strings.insert(text).first->c_str();
+}
+
+bool writeChromeTrace(const std::string &path) {
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::vector<std::vector<Event>> snapshots;
+    uint64_t origin = std::numeric_limits<uint64_t>::max();
+    for (const auto &t : reg.tracks) {
+        snapshots.push_back(t->snapshot());
+        for (const Event &event : snapshots.back()) {
+            origin = std::min(origin, event.start);
+        }
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    // Complete ("X") events in microseconds relative to the earliest zone, plus one metadata event per track name.
+    out << "{\"traceEvents\":[\n";
+    out.setf(std::ios::fixed);
+    out.precision(3);
+    bool first = true;
+    for (std::size_t i = 0; i < reg.tracks.size(); ++i) {
+        const Track &t = *reg.tracks[i];
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t.getId() << ",\"args\":{\"name\":\"";
+        Json::writeEscaped(out, t.getName());
+        out << "\"}}";
+        first = false;
+
+        for (const Event &event : snapshots[i]) {
+            out << ",\n{\"name\":\"";
+            Json::writeEscaped(out, event.name);
+            out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << t.getId()
+                << ",\"ts\":" << static_cast<double>(event.start - origin) / 1000.0
+                << ",\"dur\":" << static_cast<double>(event.end - event.start) / 1000.0 << "}";
+        }
+    }
+    out << "\n]}\n";
+
+    return static_cast<bool>(out);
+}
+
+}
+
+#endif
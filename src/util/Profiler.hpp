@@ -0,0 +1,116 @@
+#pragma once
+
+// CPU zone profiler, compiled in with IRO_PROFILE (`make PROFILE=1`). Without it the macros below expand
+// to nothing and none of this code exists in the binary.
+//
+// Every thread writes finished zones into its own fixed-size ring, so recording never takes a lock; once a
+// ring is full its oldest zones are overwritten. The collected timelines are exported as a Chrome trace,
+// which chrome://tracing and ui.perfetto.dev both open.
+
+#ifdef IRO_PROFILE
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Profiler {
+
+struct Event {
+    const char *name; // Not copied: a string literal, or anything else that outlives the profiler.
+    uint64_t start;   // Nanoseconds on the profiler clock.
+    uint64_t end;
+};
+
+// One timeline of the trace: each thread gets one, and other sources such as the GPU can add named ones.
+class Track {
+
+private:
+    static constexpr uint64_t CAPACITY = 1 << 16;
+
+    std::unique_ptr<Event[]> events;
+    std::atomic<uint64_t> written{0};
+    std::string name;
+    uint32_t id;
+
+
+public:
+    Track(std::string name, uint32_t id);
+
+    Track(const Track &) = delete;
+    Track &operator=(const Track &) = delete;
+
+    // Only the owning thread may record into a track.
+    void record(const char *eventName, uint64_t start, uint64_t end) {
+        const uint64_t index = written.load(std::memory_order_relaxed);
+        events[index & (CAPACITY - 1)] = {eventName, start, end};
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    void setName(std::string newName) { name = std::move(newName); }
+    const std::string &getName() const { return name; }
+    uint32_t getId() const { return id; }
+
+    // Copies the retained events, oldest first. Zones recorded concurrently with the copy may be torn,
+    // so export once the threads have gone quiet.
+    std::vector<Event> snapshot() const;
+
+};
+
+// The profiler clock: steady_clock in nanoseconds.
+inline uint64_t now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Track &registerThread();
+
+inline Track &threadTrack() {
+    thread_local Track &track = registerThread();
+    return track;
+}
+
+// Names the calling thread's timeline in the trace.
+void setThreadName(std::string name);
+
+// Returns the named track, creating it on first use. Like thread tracks, it must have a single writer.
+Track &track(const std::string &name);
+
+// Returns a copy of `text` that lives as long as the profiler, for event names built at runtime.
+const char *intern(const std::string &text);
+
+// Writes every track as Chrome trace JSON. Returns false if the file could not be written.
+bool writeChromeTrace(const std::string &path);
+
+// Records the time between its construction and destruction on the calling thread's track.
+class Zone {
+
+private:
+    const char *name;
+    uint64_t start;
+
+
+public:
+    explicit Zone(const char *name) : name(name), start(now()) {}
+    ~Zone() { threadTrack().record(name, start, now()); }
+
+    Zone(const Zone &) = delete;
+    Zone &operator=(const Zone &) = delete;
+
+};
+
+}
+
+#define IRO_PROFILE_CONCAT_(a, b) a##b
+#define IRO_PROFILE_CONCAT(a, b) IRO_PROFILE_CONCAT_(a, b)
+#define IRO_PROFILE_ZONE(name) ::Profiler::Zone IRO_PROFILE_CONCAT(iroProfileZone, __LINE__) {name}
+#define IRO_PROFILE_THREAD(name) ::Profiler::setThreadName(name)
+
+#else
+
+#define IRO_PROFILE_ZONE(name) ((void)0)
+#define IRO_PROFILE_THREAD(name) ((void)0)
+
+#endif
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace Utf8 {
+
+constexpr char32_t REPLACEMENT = 0xFFFD;
+
+// Decodes the code point starting at `index` and advances it past the sequence.
+// Malformed input yields U+FFFD and skips a single byte, so decoding always makes progress.
+inline char32_t next(std::string_view text, std::size_t &index) {
+    const auto lead = static_cast<unsigned char>(text[index]);
+    std::size_t length;
+    char32_t codepoint;
+
+    if (lead < 0x80) {
+        ++index;
+        return lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        codepoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codepoint = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        codepoint = lead & 0x07;
+    } else {
+        ++index;
+        return REPLACEMENT;
+    }
+
+    if (index + length > text.size()) {
+        ++index;
+        return REPLACEMENT;
+    }
+
+    for (std::size_t i = 1; i < length; ++i) {
+        const auto continuation = static_cast<unsigned char>(text[index + i]);
+        if ((continuation & 0xC0) != 0x80) {
+            ++index;
+            return REPLACEMENT;
+        }
+        codepoint = (codepoint << 6) | (continuation & 0x3F);
+    }
+
+    index += length;
+    return codepoint;
+}
+
+} // namespace Utf8